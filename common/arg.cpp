@@ -1357,10 +1357,10 @@ common_params_context common_params_parser_init(common_params & params, llama_ex
         }
     ));
     add_opt(common_arg(
-        {"--poll"}, "<0...100>",
-        string_format("use polling level to wait for work (0 - no polling, default: %u)\n", (unsigned) params.cpuparams.poll),
+        {"--poll"}, "<0...100|adaptive>",
+        string_format("use polling level to wait for work (0 - no polling, adaptive - poll for about as long as the time between graphs, without OpenMP only, default: %u)\n", (unsigned) params.cpuparams.poll),
         [](common_params & params, const std::string & value) {
-            params.cpuparams.poll = std::stoul(value);
+            params.cpuparams.poll = value == "adaptive" ? GGML_THREADPOOL_POLL_ADAPTIVE : std::stoul(value);
         }
     ));
     add_opt(common_arg(
@@ -1581,6 +1581,13 @@ common_params_context common_params_parser_init(common_params & params, llama_ex
             params.n_print = value;
         }
     ).set_examples({LLAMA_EXAMPLE_MAIN}));
+    add_opt(common_arg(
+        {"--prof-trace"}, "FNAME",
+        "record a CPU profiler timeline and save it as Chrome trace JSON (requires GGML_CPU_PROFILING=ON or RUNTIME)",
+        [](common_params & params, const std::string & value) {
+            params.prof_trace_file = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_MAIN}));
     add_opt(common_arg(
         {"--prompt-cache"}, "FNAME",
         "file to cache prompt state for faster startup (default: none)",
@@ -2284,12 +2291,14 @@ common_params_context common_params_parser_init(common_params & params, llama_ex
         "- distribute: spread execution evenly over all nodes\n"
         "- isolate: only spawn threads on CPUs on the node that execution started on\n"
         "- numactl: use the CPU map provided by numactl\n"
+        "- replicate: distribute, and keep a copy of the weights on each node\n"
         "if run without this previously, it is recommended to drop the system page cache before using this\n"
         "see https://github.com/ggml-org/llama.cpp/issues/1437",
         [](common_params & params, const std::string & value) {
             /**/ if (value == "distribute" || value == "") { params.numa = GGML_NUMA_STRATEGY_DISTRIBUTE; }
             else if (value == "isolate") { params.numa = GGML_NUMA_STRATEGY_ISOLATE; }
             else if (value == "numactl") { params.numa = GGML_NUMA_STRATEGY_NUMACTL; }
+            else if (value == "replicate") { params.numa = GGML_NUMA_STRATEGY_MIRROR; }
             else { throw std::invalid_argument("invalid value"); }
         }
     ).set_env("LLAMA_ARG_NUMA"));
@@ -2815,6 +2824,101 @@ common_params_context common_params_parser_init(common_params & params, llama_ex
             params.n_cache_reuse = value;
         }
     ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_CACHE_REUSE"));
+    add_opt(common_arg(
+        {"-kvp", "--kv-pool"},
+        string_format(
+            "slots take KV cache cells from one pool shared by all of them, instead of n_ctx/n_parallel each;\n"
+            "when the pool is full, the cached prompts of idle slots are evicted, then the latest requests are preempted (default: %s)",
+            params.kv_pool ? "enabled" : "disabled"
+        ),
+        [](common_params & params) {
+            params.kv_pool = true;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_KV_POOL"));
+    add_opt(common_arg(
+        {"-pfc", "--prefix-cache"},
+        string_format(
+            "share the KV cache of common prompt prefixes between the slots, so that a new prompt\n"
+            "only processes what follows the longest prefix cached by any slot (default: %s)",
+            params.prefix_cache ? "enabled" : "disabled"
+        ),
+        [](common_params & params) {
+            params.prefix_cache = true;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_PREFIX_CACHE"));
+    add_opt(common_arg(
+        {"-cram", "--cache-ram"}, "N",
+        string_format(
+            "size of the prompt cache in RAM, in MiB: the state of the prompts that the slots drop is kept there,\n"
+            "and restored when a new prompt starts with the same tokens (default: %d, 0 = disabled)",
+            params.cache_ram_mib
+        ),
+        [](common_params & params, int value) {
+            params.cache_ram_mib = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_CACHE_RAM"));
+    add_opt(common_arg(
+        {"--cache-disk"}, "PATH",
+        "directory where the prompt cache goes when it does not fit in RAM (default: disabled)",
+        [](common_params & params, const std::string & value) {
+            params.cache_disk_path = value;
+            // if doesn't end with DIRECTORY_SEPARATOR, add it
+            if (!params.cache_disk_path.empty() && params.cache_disk_path[params.cache_disk_path.size() - 1] != DIRECTORY_SEPARATOR) {
+                params.cache_disk_path += DIRECTORY_SEPARATOR;
+            }
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_CACHE_DISK"));
+    add_opt(common_arg(
+        {"--cache-disk-size"}, "N",
+        string_format("size of the prompt cache on disk, in MiB (default: %d)", params.cache_disk_mib),
+        [](common_params & params, int value) {
+            params.cache_disk_mib = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_CACHE_DISK_SIZE"));
+    add_opt(common_arg(
+        {"--target-tpot"}, "N",
+        string_format(
+            "target time per output token of the generating slots, in ms: the prompt tokens in each batch are limited\n"
+            "so that new prompts do not stall the generation, and long prompts are split across more batches (default: %d, 0 = disabled)",
+            params.target_tpot_ms
+        ),
+        [](common_params & params, int value) {
+            params.target_tpot_ms = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_TARGET_TPOT"));
+    add_opt(common_arg(
+        {"--tenant-slots"}, "N",
+        string_format(
+            "max number of slots that the requests of one tenant can use at once, the others wait in the queue;\n"
+            "the tenant is the API key of the request, or its `tenant` field when there are no API keys (default: %d, 0 = no limit)",
+            params.tenant_slots
+        ),
+        [](common_params & params, int value) {
+            params.tenant_slots = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_TENANT_SLOTS"));
+    add_opt(common_arg(
+        {"--priority-max"}, "N",
+        string_format(
+            "highest `priority` that a request can ask for, higher values are lowered to it;\n"
+            "when a slot frees up, the waiting request with the highest priority gets it, then the one whose tenant runs the fewest requests (default: %d)",
+            params.priority_max
+        ),
+        [](common_params & params, int value) {
+            params.priority_max = value;
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_PRIORITY_MAX"));
+    add_opt(common_arg(
+        {"--admit-kv-ratio"}, "F",
+        string_format(
+            "reject new requests with 429 (Too Many Requests) while the KV cells estimated for the running and queued requests\n"
+            "exceed F times the context size (default: %.1f, 0.0 = disabled)",
+            params.admit_kv_ratio
+        ),
+        [](common_params & params, const std::string & value) {
+            params.admit_kv_ratio = std::stof(value);
+        }
+    ).set_examples({LLAMA_EXAMPLE_SERVER}).set_env("LLAMA_ARG_ADMIT_KV_RATIO"));
     add_opt(common_arg(
         {"--metrics"},
         string_format("enable prometheus compatible metrics endpoint (default: %s)", params.endpoint_metrics ? "enabled" : "disabled"),
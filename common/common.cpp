@@ -169,6 +169,33 @@ static int cpu_count_math_cpus(int n_cpu) {
 
 #endif // __x86_64__ && __linux__
 
+#if defined(__aarch64__) && defined(__linux__)
+// count the CPUs that are not little cores, based on the capacities reported by the kernel
+// (big.LITTLE / DynamIQ topologies, e.g. Cortex-X + A7xx + A5xx on Android SoCs)
+static int cpu_count_math_cpus_arm(int n_cpu) {
+    std::vector<int> capacity;
+    for (int cpu = 0; cpu < n_cpu; ++cpu) {
+        std::ifstream f("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpu_capacity");
+        int cap = 0;
+        if (!(f >> cap) || cap <= 0) {
+            return -1;
+        }
+        capacity.push_back(cap);
+    }
+    if (capacity.empty()) {
+        return -1;
+    }
+    const int cap_max = *std::max_element(capacity.begin(), capacity.end());
+    int result = 0;
+    for (int cap : capacity) {
+        if (2*cap >= cap_max) {
+            ++result; // little cores harm lockstep threading
+        }
+    }
+    return result;
+}
+#endif // __aarch64__ && __linux__
+
 /**
  * Returns number of CPUs on system that are useful for math.
  */
@@ -188,6 +215,14 @@ int32_t cpu_get_num_math() {
             }
         }
     }
+#elif defined(__aarch64__) && defined(__linux__)
+    int n_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_cpu > 0) {
+        int result = cpu_count_math_cpus_arm(n_cpu);
+        if (result > 0) {
+            return result;
+        }
+    }
 #endif
     return cpu_get_num_physical_cores();
 }
@@ -278,6 +278,7 @@ struct common_params {
     std::string lookup_cache_static  = ""; // path of static ngram cache file for lookup decoding           // NOLINT
     std::string lookup_cache_dynamic = ""; // path of dynamic ngram cache file for lookup decoding          // NOLINT
     std::string logits_file          = ""; // file for saving *all* logits                                  // NOLINT
+    std::string prof_trace_file      = ""; // file for saving the CPU profiler trace (Chrome trace JSON)    // NOLINT
 
     std::vector<std::string> in_files;   // all input files
     std::vector<std::string> antiprompt; // strings upon which more user input is prompted (a.k.a. reverse prompts)
@@ -363,6 +364,14 @@ struct common_params {
     int32_t timeout_write  = timeout_read; // http write timeout in seconds
     int32_t n_threads_http = -1;           // number of threads to process HTTP requests (TODO: support threadpool)
     int32_t n_cache_reuse  = 0;            // min chunk size to reuse from the cache via KV shifting
+    bool    kv_pool        = false;        // slots take KV cells from one pool shared by all of them, instead of n_ctx/n_parallel each
+    bool    prefix_cache   = false;        // slots share the KV cells of the prompt prefixes they have in common
+    int32_t cache_ram_mib  = 0;            // size of the prompt cache in RAM, in MiB (0 = disabled)
+    int32_t cache_disk_mib = 4096;         // size of the prompt cache on disk, in MiB
+    int32_t target_tpot_ms = 0;            // target time per output token while prompts are processed, in ms (0 = disabled)
+    int32_t tenant_slots   = 0;            // max number of slots used by the requests of one tenant at once (0 = no limit)
+    int32_t priority_max   = 0;            // highest priority that a request can ask for, lower ones are always allowed
+    float   admit_kv_ratio = 0.0f;         // reject requests when the KV they need exceeds this times the context size (0 = disabled)
 
     std::string hostname      = "127.0.0.1";
     std::string public_path   = "";                                                                         // NOLINT
@@ -387,6 +396,7 @@ struct common_params {
     bool log_json = false;
 
     std::string slot_save_path;
+    std::string cache_disk_path; // directory of the prompt cache on disk (empty = disabled)
 
     float slot_prompt_similarity = 0.5f;
 
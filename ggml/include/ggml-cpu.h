@@ -19,6 +19,9 @@ extern "C" {
         // abort ggml_graph_compute when true
         ggml_abort_callback abort_callback;
         void *              abort_callback_data;
+
+        // schedule of the graph nodes, kept at the end of work_data and filled in by the first `ggml_graph_compute()`
+        void * sched;
     };
 
     // numa strategies
@@ -27,12 +30,14 @@ extern "C" {
         GGML_NUMA_STRATEGY_DISTRIBUTE = 1,
         GGML_NUMA_STRATEGY_ISOLATE    = 2,
         GGML_NUMA_STRATEGY_NUMACTL    = 3,
-        GGML_NUMA_STRATEGY_MIRROR     = 4,
+        GGML_NUMA_STRATEGY_MIRROR     = 4, // distribute, with a copy of the weights on each node
         GGML_NUMA_STRATEGY_COUNT
     };
 
     GGML_BACKEND_API void    ggml_numa_init(enum ggml_numa_strategy numa); // call once for better performance on NUMA systems
     GGML_BACKEND_API bool    ggml_is_numa(void); // true if init detected that system has >1 NUMA node
+    GGML_BACKEND_API void    ggml_numa_interleave(void * data, size_t size); // with GGML_NUMA_STRATEGY_MIRROR, spread the pages of a buffer over all nodes
+    GGML_BACKEND_API bool    ggml_cpu_is_hybrid(void); // true if init detected cores of different speed (big.LITTLE, P+E cores)
 
     GGML_BACKEND_API struct ggml_tensor * ggml_new_i32(struct ggml_context * ctx, int32_t value);
     GGML_BACKEND_API struct ggml_tensor * ggml_new_f32(struct ggml_context * ctx, float value);
@@ -57,6 +62,9 @@ extern "C" {
     GGML_BACKEND_API int                           ggml_threadpool_get_n_threads (struct ggml_threadpool * threadpool);
     GGML_BACKEND_API void                          ggml_threadpool_pause         (struct ggml_threadpool * threadpool);
     GGML_BACKEND_API void                          ggml_threadpool_resume        (struct ggml_threadpool * threadpool);
+    // time the worker threads spent polling and sleeping while waiting for the graphs computed so far
+    // must not be called while a graph is being computed with the threadpool
+    GGML_BACKEND_API void                          ggml_threadpool_get_wait_time (struct ggml_threadpool * threadpool, int64_t * t_poll_us, int64_t * t_sleep_us);
 
     // ggml_graph_plan() has to be called before ggml_graph_compute()
     // when plan.work_size > 0, caller must allocate memory for plan.work_data
@@ -2185,13 +2185,17 @@ extern "C" {
         GGML_SCHED_PRIO_REALTIME
     };
 
+    // polling level that follows the time between graphs: the threads poll when the next graph
+    // usually comes soon and sleep right away when it does not
+    #define GGML_THREADPOOL_POLL_ADAPTIVE UINT32_MAX
+
     // threadpool params
     // Use ggml_threadpool_params_default() or ggml_threadpool_params_init() to populate the defaults
     struct ggml_threadpool_params {
         bool                cpumask[GGML_MAX_N_THREADS]; // mask of cpu cores (all-zeros means use default affinity settings)
         int                 n_threads;                   // number of threads
         enum ggml_sched_priority prio;                   // thread priority
-        uint32_t            poll;                        // polling level (0 - no polling, 100 - aggressive polling)
+        uint32_t            poll;                        // polling level (0 - no polling, 100 - aggressive polling, GGML_THREADPOOL_POLL_ADAPTIVE)
         bool                strict_cpu;                  // strict cpu placement
         bool                paused;                      // start in paused state
     };
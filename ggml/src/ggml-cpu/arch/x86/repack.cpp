@@ -174,6 +174,353 @@ static inline __m256i mul_sum_i8_pairs_acc_int32x8(const __m256i acc, const __m2
 }
 #endif
 
+#if defined(__AVX2__)
+// Q2_K, Q3_K, Q5_K and Q6_K 8x8 kernels: the quants of each 8-byte chunk are unpacked to unsigned bytes
+// (rows 0-3 / 4-7 in two registers), multiplied with maddubs and scaled per group of 16 with madd.
+// The offset of each group (mins, or 4/32 * scale for Q3_K/Q6_K) is applied afterwards through the q8_K bsums.
+
+static inline const ggml_half * dmin_kx8(const block_q2_Kx8 & b) { return b.dmin; }
+static inline const ggml_half * dmin_kx8(const block_q3_Kx8 & b) { return b.d; }
+static inline const ggml_half * dmin_kx8(const block_q5_Kx8 & b) { return b.dmin; }
+static inline const ggml_half * dmin_kx8(const block_q6_Kx8 & b) { return b.d; }
+
+// int16 scales and offsets of the 16 groups of the 8 rows
+static inline void unpack_scales_kx8(const block_q2_Kx8 & b, __m128i sc[16], __m128i mn[16]) {
+    const __m128i m4 = _mm_set1_epi16(0xF);
+    for (int g = 0; g < 16; g++) {
+        const __m128i s = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *) (b.scales + g * 8)));
+        sc[g] = _mm_and_si128(s, m4);
+        mn[g] = _mm_srli_epi16(s, 4);
+    }
+}
+
+static inline void unpack_scales_kx8(const block_q3_Kx8 & b, __m128i sc[16], __m128i mn[16]) {
+    // moves bits 2j, 2j + 1 of lane j to the top of the lane
+    const __m128i mul_h = _mm_set_epi16(1 << 0, 1 << 2, 1 << 4, 1 << 6, 1 << 8, 1 << 10, 1 << 12, 1 << 14);
+    const __m128i m32 = _mm_set1_epi16(32);
+    for (int g = 0; g < 16; g++) {
+        uint32_t lo;
+        uint16_t hi;
+        memcpy(&lo, b.scales + g * 4, sizeof(lo));
+        memcpy(&hi, b.scales + 64 + g * 2, sizeof(hi));
+
+        const uint64_t lo8 = (uint64_t) (lo & 0x0F0F0F0F) | ((uint64_t) ((lo >> 4) & 0x0F0F0F0F) << 32);
+        const __m128i l = _mm_cvtepu8_epi16(_mm_cvtsi64_si128((int64_t) lo8));
+        const __m128i h = _mm_srli_epi16(_mm_mullo_epi16(_mm_set1_epi16((int16_t) hi), mul_h), 14);
+
+        sc[g] = _mm_sub_epi16(_mm_or_si128(l, _mm_slli_epi16(h, 4)), m32);
+        mn[g] = _mm_slli_epi16(sc[g], 2);
+    }
+}
+
+static inline void unpack_scales_kx8(const block_q5_Kx8 & b, __m128i sc[16], __m128i mn[16]) {
+    static const uint32_t kmask1 = 0x3f3f3f3f;
+    static const uint32_t kmask2 = 0x0f0f0f0f;
+    static const uint32_t kmask3 = 0x03030303;
+
+    // same scales layout as block_q4_Kx8: 16 bytes per sub-block of 32, the 8 scales followed by the 8 mins
+    uint32_t utmp[4];
+    for (int sb = 0; sb < 8; sb++) {
+        memcpy(utmp, b.scales + sb * 12, 12);
+        utmp[3] = ((utmp[2] >> 4) & kmask2) | (((utmp[1] >> 6) & kmask3) << 4);
+        const uint32_t uaux_0 = utmp[1] & kmask1;
+        utmp[1] = (utmp[2] & kmask2) | (((utmp[0] >> 6) & kmask3) << 4);
+        utmp[2] = uaux_0;
+        utmp[0] &= kmask1;
+
+        const __m128i s = _mm_loadu_si128((const __m128i *) utmp);
+        sc[2 * sb + 0] = sc[2 * sb + 1] = _mm_cvtepu8_epi16(s);
+        mn[2 * sb + 0] = mn[2 * sb + 1] = _mm_cvtepu8_epi16(_mm_srli_si128(s, 8));
+    }
+}
+
+static inline void unpack_scales_kx8(const block_q6_Kx8 & b, __m128i sc[16], __m128i mn[16]) {
+    for (int g = 0; g < 16; g++) {
+        sc[g] = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *) (b.scales + g * 8)));
+        mn[g] = _mm_slli_epi16(sc[g], 5);
+    }
+}
+
+static inline __m256i load_kx8(const uint8_t * p) {
+    return _mm256_loadu_si256((const __m256i *) p);
+}
+
+// (x >> k) for k >= 0, (x << -k) otherwise; the 16-bit shifts are only used on bits that stay within their byte
+static inline __m256i shift_epi16(const __m256i x, int k) {
+    return k >= 0 ? _mm256_srli_epi16(x, k) : _mm256_slli_epi16(x, -k);
+}
+
+// Calls f(g, q0_0123, q0_4567, q1_0123, q1_4567) for each group g of 16 quants, with the unsigned quants of the
+// two 8-byte chunks of the group (quants [16g, 16g + 8) and [16g + 8, 16g + 16) of each row) for rows 0-3 / 4-7.
+// The groups are visited in the order that lets each load of the packed quants feed several of them.
+template <typename F>
+static inline void for_each_group_kx8(const block_q2_Kx8 & b, F && f) {
+    const __m256i m2 = _mm256_set1_epi8(3);
+    for (int n = 0; n < 2; n++) {
+        for (int p = 0; p < 2; p++) {
+            const uint8_t * qs_0 = b.qs + (n * 4 + 2 * p + 0) * 64;
+            const uint8_t * qs_1 = b.qs + (n * 4 + 2 * p + 1) * 64;
+            const __m256i qs_0_0123 = load_kx8(qs_0), qs_0_4567 = load_kx8(qs_0 + 32);
+            const __m256i qs_1_0123 = load_kx8(qs_1), qs_1_4567 = load_kx8(qs_1 + 32);
+            for (int j = 0; j < 4; j++) {
+                f(n * 8 + j * 2 + p,
+                  _mm256_and_si256(shift_epi16(qs_0_0123, 2 * j), m2), _mm256_and_si256(shift_epi16(qs_0_4567, 2 * j), m2),
+                  _mm256_and_si256(shift_epi16(qs_1_0123, 2 * j), m2), _mm256_and_si256(shift_epi16(qs_1_4567, 2 * j), m2));
+            }
+        }
+    }
+}
+
+template <typename F>
+static inline void for_each_group_kx8(const block_q3_Kx8 & b, F && f) {
+    const __m256i m2 = _mm256_set1_epi8(3);
+    const __m256i m4 = _mm256_set1_epi8(4);
+    for (int n = 0; n < 2; n++) {
+        for (int p = 0; p < 2; p++) {
+            const uint8_t * qs_0 = b.qs    + (n * 4 + 2 * p + 0) * 64;
+            const uint8_t * qs_1 = b.qs    + (n * 4 + 2 * p + 1) * 64;
+            const uint8_t * hm_0 = b.hmask + (2 * p + 0) * 64;
+            const uint8_t * hm_1 = b.hmask + (2 * p + 1) * 64;
+            const __m256i qs_0_0123 = load_kx8(qs_0), qs_0_4567 = load_kx8(qs_0 + 32);
+            const __m256i qs_1_0123 = load_kx8(qs_1), qs_1_4567 = load_kx8(qs_1 + 32);
+            const __m256i hm_0_0123 = load_kx8(hm_0), hm_0_4567 = load_kx8(hm_0 + 32);
+            const __m256i hm_1_0123 = load_kx8(hm_1), hm_1_4567 = load_kx8(hm_1 + 32);
+            for (int j = 0; j < 4; j++) {
+                // low 2 bits at 2j, high bit at n*4 + j -> moved to bit 2
+                const int sh = n * 4 + j - 2;
+                f(n * 8 + j * 2 + p,
+                  _mm256_or_si256(_mm256_and_si256(shift_epi16(qs_0_0123, 2 * j), m2), _mm256_and_si256(shift_epi16(hm_0_0123, sh), m4)),
+                  _mm256_or_si256(_mm256_and_si256(shift_epi16(qs_0_4567, 2 * j), m2), _mm256_and_si256(shift_epi16(hm_0_4567, sh), m4)),
+                  _mm256_or_si256(_mm256_and_si256(shift_epi16(qs_1_0123, 2 * j), m2), _mm256_and_si256(shift_epi16(hm_1_0123, sh), m4)),
+                  _mm256_or_si256(_mm256_and_si256(shift_epi16(qs_1_4567, 2 * j), m2), _mm256_and_si256(shift_epi16(hm_1_4567, sh), m4)));
+            }
+        }
+    }
+}
+
+template <typename F>
+static inline void for_each_group_kx8(const block_q5_Kx8 & b, F && f) {
+    const __m256i m4b = _mm256_set1_epi8(0xF);
+    const __m256i m16 = _mm256_set1_epi8(16);
+    for (int p = 0; p < 2; p++) {
+        const uint8_t * qh_0 = b.qh + (2 * p + 0) * 64;
+        const uint8_t * qh_1 = b.qh + (2 * p + 1) * 64;
+        const __m256i qh_0_0123 = load_kx8(qh_0), qh_0_4567 = load_kx8(qh_0 + 32);
+        const __m256i qh_1_0123 = load_kx8(qh_1), qh_1_4567 = load_kx8(qh_1 + 32);
+        for (int j = 0; j < 4; j++) {
+            const uint8_t * qs_0 = b.qs + (j * 4 + 2 * p + 0) * 64;
+            const uint8_t * qs_1 = b.qs + (j * 4 + 2 * p + 1) * 64;
+            const __m256i qs_0_0123 = load_kx8(qs_0), qs_0_4567 = load_kx8(qs_0 + 32);
+            const __m256i qs_1_0123 = load_kx8(qs_1), qs_1_4567 = load_kx8(qs_1 + 32);
+
+            // low nibbles with the high bit 2j, high nibbles with the high bit 2j + 1 -> moved to bit 4
+            const int sh_l = 2 * j - 4;
+            const int sh_h = 2 * j - 3;
+            f(j * 4 + p,
+              _mm256_or_si256(_mm256_and_si256(qs_0_0123, m4b), _mm256_and_si256(shift_epi16(qh_0_0123, sh_l), m16)),
+              _mm256_or_si256(_mm256_and_si256(qs_0_4567, m4b), _mm256_and_si256(shift_epi16(qh_0_4567, sh_l), m16)),
+              _mm256_or_si256(_mm256_and_si256(qs_1_0123, m4b), _mm256_and_si256(shift_epi16(qh_1_0123, sh_l), m16)),
+              _mm256_or_si256(_mm256_and_si256(qs_1_4567, m4b), _mm256_and_si256(shift_epi16(qh_1_4567, sh_l), m16)));
+            f(j * 4 + 2 + p,
+              _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(qs_0_0123, 4), m4b), _mm256_and_si256(shift_epi16(qh_0_0123, sh_h), m16)),
+              _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(qs_0_4567, 4), m4b), _mm256_and_si256(shift_epi16(qh_0_4567, sh_h), m16)),
+              _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(qs_1_0123, 4), m4b), _mm256_and_si256(shift_epi16(qh_1_0123, sh_h), m16)),
+              _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(qs_1_4567, 4), m4b), _mm256_and_si256(shift_epi16(qh_1_4567, sh_h), m16)));
+        }
+    }
+}
+
+template <typename F>
+static inline void for_each_group_kx8(const block_q6_Kx8 & b, F && f) {
+    const __m256i m4b = _mm256_set1_epi8(0xF);
+    const __m256i m48 = _mm256_set1_epi8(0x30);
+    for (int h = 0; h < 2; h++) {
+        for (int p = 0; p < 2; p++) {
+            __m256i q[2][4][2];
+            for (int i = 0; i < 2; i++) {
+                const int lc = 2 * p + i;
+                const uint8_t * ql_a = b.ql + (h * 8 + 0 + lc) * 64;
+                const uint8_t * ql_b = b.ql + (h * 8 + 4 + lc) * 64;
+                const uint8_t * qh   = b.qh + (h * 4 + lc) * 64;
+                for (int r = 0; r < 2; r++) {
+                    const __m256i a  = load_kx8(ql_a + 32 * r);
+                    const __m256i bb = load_kx8(ql_b + 32 * r);
+                    const __m256i hh = load_kx8(qh   + 32 * r);
+                    // quarter qq: nibble qq / 2 of ql_a (qq even) or ql_b (qq odd), bits 2qq of qh -> moved to bit 4
+                    q[i][0][r] = _mm256_or_si256(_mm256_and_si256(a, m4b),                         _mm256_and_si256(_mm256_slli_epi16(hh, 4), m48));
+                    q[i][1][r] = _mm256_or_si256(_mm256_and_si256(bb, m4b),                        _mm256_and_si256(_mm256_slli_epi16(hh, 2), m48));
+                    q[i][2][r] = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(a, 4), m4b),  _mm256_and_si256(hh, m48));
+                    q[i][3][r] = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(bb, 4), m4b), _mm256_and_si256(_mm256_srli_epi16(hh, 2), m48));
+                }
+            }
+            for (int qq = 0; qq < 4; qq++) {
+                f(h * 8 + qq * 2 + p, q[0][qq][0], q[0][qq][1], q[1][qq][0], q[1][qq][1]);
+            }
+        }
+    }
+}
+
+// broadcast the group scales of rows 0-3 / 4-7 to the 4 int16 products of each row
+static inline void expand_scales_kx8(const __m128i s, __m256i & sc_0123, __m256i & sc_4567) {
+    const __m128i s_0123 = _mm_unpacklo_epi16(s, s);
+    const __m128i s_4567 = _mm_unpackhi_epi16(s, s);
+
+    sc_0123 = _mm256_set_m128i(_mm_unpackhi_epi32(s_0123, s_0123), _mm_unpacklo_epi32(s_0123, s_0123));
+    sc_4567 = _mm256_set_m128i(_mm_unpackhi_epi32(s_4567, s_4567), _mm_unpacklo_epi32(s_4567, s_4567));
+}
+
+// offsets of the groups 2*gp and 2*gp + 1 of the 8 rows, interleaved for madd against a pair of bsums
+static inline __m256i expand_mins_kx8(const __m128i mn[16], int gp) {
+    const __m128i m_0 = mn[2 * gp + 0];
+    const __m128i m_1 = mn[2 * gp + 1];
+
+    return _mm256_set_m128i(_mm_unpackhi_epi16(m_0, m_1), _mm_unpacklo_epi16(m_0, m_1));
+}
+
+static inline __m256i load_bcast_8_bytes(const int8_t * p) {
+    int64_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm256_set1_epi64x(v);
+}
+
+static inline __m256i load_bcast_bsums_pair(const int16_t * p) {
+    int32_t v;
+    memcpy(&v, p, sizeof(v));
+    return _mm256_set1_epi32(v);
+}
+
+template <typename BLOC_TYPE>
+static void gemv_kx8_q8_K(int n, float * GGML_RESTRICT s, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nc) {
+    const int nb = n / QK_K;
+
+    __m128i sc[16];
+    __m128i mn[16];
+
+    const block_q8_K * a_ptr = (const block_q8_K *) vy;
+    for (int x = 0; x < nc / 8; x++) {
+        const BLOC_TYPE * b_ptr = (const BLOC_TYPE *) vx + (x * nb);
+
+        __m256 acc = _mm256_setzero_ps();
+        for (int l = 0; l < nb; l++) {
+            unpack_scales_kx8(b_ptr[l], sc, mn);
+
+            __m256i iacc_0123 = _mm256_setzero_si256();
+            __m256i iacc_4567 = _mm256_setzero_si256();
+            for_each_group_kx8(b_ptr[l], [&](int g, const __m256i & q0_0123, const __m256i & q0_4567, const __m256i & q1_0123, const __m256i & q1_4567) {
+                const __m256i a_0 = load_bcast_8_bytes(a_ptr[l].qs + 16 * g + 0);
+                const __m256i a_1 = load_bcast_8_bytes(a_ptr[l].qs + 16 * g + 8);
+
+                const __m256i p_0123 = _mm256_add_epi16(_mm256_maddubs_epi16(q0_0123, a_0), _mm256_maddubs_epi16(q1_0123, a_1));
+                const __m256i p_4567 = _mm256_add_epi16(_mm256_maddubs_epi16(q0_4567, a_0), _mm256_maddubs_epi16(q1_4567, a_1));
+
+                __m256i sc_0123, sc_4567;
+                expand_scales_kx8(sc[g], sc_0123, sc_4567);
+
+                iacc_0123 = _mm256_add_epi32(iacc_0123, _mm256_madd_epi16(p_0123, sc_0123));
+                iacc_4567 = _mm256_add_epi32(iacc_4567, _mm256_madd_epi16(p_4567, sc_4567));
+            });
+
+            __m256i iacc_min = _mm256_setzero_si256();
+            for (int gp = 0; gp < 8; gp++) {
+                iacc_min = _mm256_add_epi32(iacc_min, _mm256_madd_epi16(expand_mins_kx8(mn, gp), load_bcast_bsums_pair(a_ptr[l].bsums + 2 * gp)));
+            }
+
+            // {r0, r0, r1, r1, r2, r2, r3, r3} + {r4, r4, ...} -> {r0, ..., r7}
+            const __m256i iacc = _mm256_permute4x64_epi64(_mm256_hadd_epi32(iacc_0123, iacc_4567), 0xD8);
+
+            const __m256 a_d = _mm256_set1_ps(a_ptr[l].d);
+            acc = _mm256_fmadd_ps (_mm256_cvtepi32_ps(iacc),     _mm256_mul_ps(GGML_F32Cx8_LOAD(b_ptr[l].d),        a_d), acc);
+            acc = _mm256_fnmadd_ps(_mm256_cvtepi32_ps(iacc_min), _mm256_mul_ps(GGML_F32Cx8_LOAD(dmin_kx8(b_ptr[l])), a_d), acc);
+        }
+
+        _mm256_storeu_ps(s + x * 8, acc);
+    }
+}
+
+template <typename BLOC_TYPE>
+static void gemm_kx8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int nb = n / QK_K;
+
+    __m128i sc[16];
+    __m128i mn[16];
+
+    // one super-block of the 8 weight rows, unpacked once and reused for all the activation rows
+    __m256i q[32][2];
+    __m256i sc_x[16][2];
+    __m256i mn_x[8];
+
+    for (int x = 0; x < nc / 8; x++) {
+        const BLOC_TYPE * b_ptr = (const BLOC_TYPE *) vx + (x * nb);
+
+        for (int l = 0; l < nb; l++) {
+            unpack_scales_kx8(b_ptr[l], sc, mn);
+            for_each_group_kx8(b_ptr[l], [&](int g, const __m256i & q0_0123, const __m256i & q0_4567, const __m256i & q1_0123, const __m256i & q1_4567) {
+                q[2 * g + 0][0] = q0_0123;
+                q[2 * g + 0][1] = q0_4567;
+                q[2 * g + 1][0] = q1_0123;
+                q[2 * g + 1][1] = q1_4567;
+            });
+            for (int g = 0; g < 16; g++) {
+                expand_scales_kx8(sc[g], sc_x[g][0], sc_x[g][1]);
+            }
+            for (int gp = 0; gp < 8; gp++) {
+                mn_x[gp] = expand_mins_kx8(mn, gp);
+            }
+
+            const __m256 b_d    = GGML_F32Cx8_LOAD(b_ptr[l].d);
+            const __m256 b_dmin = GGML_F32Cx8_LOAD(dmin_kx8(b_ptr[l]));
+
+            for (int y = 0; y < nr / 4; y++) {
+                const block_q8_Kx4 * a_ptr = (const block_q8_Kx4 *) vy + (y * nb) + l;
+
+                __m256i iacc_0123[4];
+                __m256i iacc_4567[4];
+                __m256i iacc_min[4];
+                for (int m = 0; m < 4; m++) {
+                    iacc_0123[m] = _mm256_setzero_si256();
+                    iacc_4567[m] = _mm256_setzero_si256();
+                    iacc_min[m]  = _mm256_setzero_si256();
+                }
+
+                for (int g = 0; g < 16; g++) {
+                    // the activations of row m for quants [8c, 8c + 8) are at qs[32c + 8m]
+                    for (int m = 0; m < 4; m++) {
+                        const __m256i a_0 = load_bcast_8_bytes(a_ptr->qs + (2 * g + 0) * 32 + m * 8);
+                        const __m256i a_1 = load_bcast_8_bytes(a_ptr->qs + (2 * g + 1) * 32 + m * 8);
+
+                        const __m256i p_0123 = _mm256_add_epi16(_mm256_maddubs_epi16(q[2 * g][0], a_0), _mm256_maddubs_epi16(q[2 * g + 1][0], a_1));
+                        const __m256i p_4567 = _mm256_add_epi16(_mm256_maddubs_epi16(q[2 * g][1], a_0), _mm256_maddubs_epi16(q[2 * g + 1][1], a_1));
+
+                        iacc_0123[m] = _mm256_add_epi32(iacc_0123[m], _mm256_madd_epi16(p_0123, sc_x[g][0]));
+                        iacc_4567[m] = _mm256_add_epi32(iacc_4567[m], _mm256_madd_epi16(p_4567, sc_x[g][1]));
+                    }
+                }
+
+                // the bsums of row m for the groups 2gp, 2gp + 1 are at bsums[16 * (gp / 2) + 4m + 2 * (gp % 2)]
+                for (int gp = 0; gp < 8; gp++) {
+                    for (int m = 0; m < 4; m++) {
+                        const __m256i bsums = load_bcast_bsums_pair(a_ptr->bsums + (gp / 2) * 16 + m * 4 + (gp % 2) * 2);
+                        iacc_min[m] = _mm256_add_epi32(iacc_min[m], _mm256_madd_epi16(mn_x[gp], bsums));
+                    }
+                }
+
+                for (int m = 0; m < 4; m++) {
+                    float * dst = s + (y * 4 + m) * bs + x * 8;
+
+                    const __m256i iacc = _mm256_permute4x64_epi64(_mm256_hadd_epi32(iacc_0123[m], iacc_4567[m]), 0xD8);
+                    const __m256 a_d = _mm256_set1_ps(a_ptr->d[m]);
+
+                    __m256 acc = l == 0 ? _mm256_setzero_ps() : _mm256_loadu_ps(dst);
+                    acc = _mm256_fmadd_ps (_mm256_cvtepi32_ps(iacc),        _mm256_mul_ps(b_d,    a_d), acc);
+                    acc = _mm256_fnmadd_ps(_mm256_cvtepi32_ps(iacc_min[m]), _mm256_mul_ps(b_dmin, a_d), acc);
+                    _mm256_storeu_ps(dst, acc);
+                }
+            }
+        }
+    }
+}
+#endif // #if defined(__AVX2__)
+
 void ggml_quantize_mat_q8_0_4x8(const float * GGML_RESTRICT x, void * GGML_RESTRICT vy, int64_t k) {
     assert(QK8_0 == 32);
     assert(k % QK8_0 == 0);
@@ -715,6 +1062,95 @@ void ggml_gemv_q4_0_8x8_q8_0(int n, float * GGML_RESTRICT s, size_t bs, const vo
     }
 }
 
+void ggml_gemv_q8_0_8x8_q8_0(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(s);
+    UNUSED(bs);
+    UNUSED(vx);
+    UNUSED(vy);
+    UNUSED(nr);
+    UNUSED(nc);
+    UNUSED(nb);
+    UNUSED(ncols_interleaved);
+    UNUSED(blocklen);
+
+#if defined(__AVX2__)
+    const block_q8_0 * a_ptr = (const block_q8_0 *) vy;
+
+    for (int64_t x = 0; x < nc / ncols_interleaved; x++) {
+        const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+
+        // Master FP accumulator
+        __m256 acc_row = _mm256_setzero_ps();
+
+        for (int64_t b = 0; b < nb; b++) {
+            __m256i iacc_0123 = _mm256_setzero_si256();
+            __m256i iacc_4567 = _mm256_setzero_si256();
+
+            // Each 64 bit lane of the RHS holds 8 quants of one column: B0(0-7) B1(0-7) B2(0-7) B3(0-7)
+            // The matching 8 quants of the LHS are broadcast to all four lanes
+            for (int k = 0; k < qk / blocklen; k++) {
+                const __m256i rhs_vec_0123 = _mm256_loadu_si256((const __m256i *)(b_ptr[b].qs + k * 64));
+                const __m256i rhs_vec_4567 = _mm256_loadu_si256((const __m256i *)(b_ptr[b].qs + k * 64 + 32));
+
+                int64_t lhs_raw;
+                memcpy(&lhs_raw, a_ptr[b].qs + k * blocklen, sizeof(int64_t));
+                const __m256i lhs_vec = _mm256_set1_epi64x(lhs_raw);
+
+                iacc_0123 = mul_sum_i8_pairs_acc_int32x8(iacc_0123, rhs_vec_0123, lhs_vec);
+                iacc_4567 = mul_sum_i8_pairs_acc_int32x8(iacc_4567, rhs_vec_4567, lhs_vec);
+            }
+
+            // Two partial sums per column: B0 B0 B1 B1 B2 B2 B3 B3 and B4 B4 ... B7 B7
+            // hadd gives B0 B1 B4 B5 | B2 B3 B6 B7, the 64 bit permute restores B0 - B7
+            const __m256i iacc = _mm256_permute4x64_epi64(_mm256_hadd_epi32(iacc_0123, iacc_4567), 0xD8);
+
+            // Load the scale values for the 8 blocks interleaved in block_q8_0x8
+            const __m256 col_scale_f32 = GGML_F32Cx8_LOAD(b_ptr[b].d);
+
+            // Load and convert to FP32 scale from block_q8_0
+            const __m256 row_scale_f32 = _mm256_set1_ps(GGML_FP16_TO_FP32(a_ptr[b].d));
+
+            acc_row = _mm256_fmadd_ps(_mm256_cvtepi32_ps(iacc), _mm256_mul_ps(col_scale_f32, row_scale_f32), acc_row);
+        }
+
+        _mm256_storeu_ps(s + x * 8, acc_row);
+    }
+    return;
+
+#endif
+    {
+        float sumf[8];
+        int sumi;
+
+        const block_q8_0 * a_ptr = (const block_q8_0 *) vy;
+        for (int x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+
+            for (int j = 0; j < ncols_interleaved; j++) sumf[j] = 0.0;
+            for (int l = 0; l < nb; l++) {
+                for (int j = 0; j < ncols_interleaved; j++) {
+                    sumi = 0;
+                    for (int k = 0; k < (qk / blocklen); k++) {
+                        for (int i = 0; i < blocklen; ++i) {
+                            sumi += b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i] * a_ptr[l].qs[k * blocklen + i];
+                        }
+                    }
+                    sumf[j] += sumi * GGML_FP16_TO_FP32(b_ptr[l].d[j]) * GGML_FP16_TO_FP32(a_ptr[l].d);
+                }
+            }
+            for (int j = 0; j < ncols_interleaved; j++) s[x * ncols_interleaved + j] = sumf[j];
+        }
+    }
+}
+
 void ggml_gemv_q4_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
@@ -989,6 +1425,62 @@ void ggml_gemv_q4_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const vo
 #endif
 }
 
+void ggml_gemv_q2_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K<block_q2_Kx8>(n, s, vx, vy, nc);
+#else
+    ggml_gemv_q2_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemv_q3_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K<block_q3_Kx8>(n, s, vx, vy, nc);
+#else
+    ggml_gemv_q3_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemv_q5_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K<block_q5_Kx8>(n, s, vx, vy, nc);
+#else
+    ggml_gemv_q5_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemv_q6_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K<block_q6_Kx8>(n, s, vx, vy, nc);
+#else
+    ggml_gemv_q6_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
 void ggml_gemm_q4_0_8x8_q8_0(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK8_0;
     const int nb = n / qk;
@@ -1768,6 +2260,117 @@ void ggml_gemm_q4_0_8x8_q8_0(int n, float * GGML_RESTRICT s, size_t bs, const vo
     }
 }
 
+void ggml_gemm_q8_0_8x8_q8_0(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nr % 4 == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(s);
+    UNUSED(bs);
+    UNUSED(vx);
+    UNUSED(vy);
+    UNUSED(nr);
+    UNUSED(nc);
+    UNUSED(nb);
+    UNUSED(ncols_interleaved);
+    UNUSED(blocklen);
+
+#if defined(__AVX2__)
+    for (int64_t y = 0; y < nr / 4; y++) {
+        // LHS rows are interleaved in groups of 8 quants: A0(0-7) A1(0-7) A2(0-7) A3(0-7) A0(8-15) ...
+        const block_q8_0x4 * a_ptr = (const block_q8_0x4 *) vy + (y * nb);
+
+        for (int64_t x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+
+            __m256 acc_rows[4];
+            for (int m = 0; m < 4; m++) {
+                acc_rows[m] = _mm256_setzero_ps();
+            }
+
+            for (int64_t b = 0; b < nb; b++) {
+                __m256i iacc_0123[4];
+                __m256i iacc_4567[4];
+                for (int m = 0; m < 4; m++) {
+                    iacc_0123[m] = _mm256_setzero_si256();
+                    iacc_4567[m] = _mm256_setzero_si256();
+                }
+
+                for (int k = 0; k < qk / blocklen; k++) {
+                    const __m256i rhs_vec_0123 = _mm256_loadu_si256((const __m256i *)(b_ptr[b].qs + k * 64));
+                    const __m256i rhs_vec_4567 = _mm256_loadu_si256((const __m256i *)(b_ptr[b].qs + k * 64 + 32));
+
+                    // The absolute values of the RHS are shared by the four rows, only the LHS signs change
+                    const __m256i rhs_abs_0123 = _mm256_sign_epi8(rhs_vec_0123, rhs_vec_0123);
+                    const __m256i rhs_abs_4567 = _mm256_sign_epi8(rhs_vec_4567, rhs_vec_4567);
+
+                    for (int m = 0; m < 4; m++) {
+                        int64_t lhs_raw;
+                        memcpy(&lhs_raw, a_ptr[b].qs + k * 4 * blocklen + m * blocklen, sizeof(int64_t));
+                        const __m256i lhs_vec = _mm256_set1_epi64x(lhs_raw);
+
+                        iacc_0123[m] = mul_sum_us8_pairs_acc_int32x8(iacc_0123[m], rhs_abs_0123, _mm256_sign_epi8(lhs_vec, rhs_vec_0123));
+                        iacc_4567[m] = mul_sum_us8_pairs_acc_int32x8(iacc_4567[m], rhs_abs_4567, _mm256_sign_epi8(lhs_vec, rhs_vec_4567));
+                    }
+                }
+
+                // Load the scale values for the 8 blocks interleaved in block_q8_0x8
+                const __m256 col_scale_f32 = GGML_F32Cx8_LOAD(b_ptr[b].d);
+
+                for (int m = 0; m < 4; m++) {
+                    // B0 B1 B4 B5 | B2 B3 B6 B7 -> B0 - B7, see ggml_gemv_q8_0_8x8_q8_0
+                    const __m256i iacc = _mm256_permute4x64_epi64(_mm256_hadd_epi32(iacc_0123[m], iacc_4567[m]), 0xD8);
+                    const __m256 row_scale_f32 = _mm256_set1_ps(GGML_FP16_TO_FP32(a_ptr[b].d[m]));
+
+                    acc_rows[m] = _mm256_fmadd_ps(_mm256_cvtepi32_ps(iacc), _mm256_mul_ps(col_scale_f32, row_scale_f32), acc_rows[m]);
+                }
+            }
+
+            for (int m = 0; m < 4; m++) {
+                _mm256_storeu_ps(s + (y * 4 + m) * bs + x * 8, acc_rows[m]);
+            }
+        }
+    }
+    return;
+
+#endif
+    float sumf[4][8];
+    int sumi;
+
+    for (int y = 0; y < nr / 4; y++) {
+        const block_q8_0x4 * a_ptr = (const block_q8_0x4 *) vy + (y * nb);
+        for (int x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++) sumf[m][j] = 0.0;
+            }
+            for (int l = 0; l < nb; l++) {
+                for (int m = 0; m < 4; m++) {
+                    for (int j = 0; j < ncols_interleaved; j++) {
+                        sumi = 0;
+                        for (int k = 0; k < (qk / blocklen); k++) {
+                            for (int i = 0; i < blocklen; ++i) {
+                                sumi += b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i] *
+                                        a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i];
+                            }
+                        }
+                        sumf[m][j] += sumi * GGML_FP16_TO_FP32(b_ptr[l].d[j]) * GGML_FP16_TO_FP32(a_ptr[l].d[m]);
+                    }
+                }
+            }
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++)
+                    s[(y * 4 + m) * bs + x * ncols_interleaved + j] = sumf[m][j];
+            }
+        }
+    }
+}
+
 void ggml_gemm_q4_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK_K;
     const int nb = n / qk;
@@ -3282,3 +3885,51 @@ void ggml_gemm_q4_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const vo
     }
 #endif
 }
+
+void ggml_gemm_q2_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    gemm_kx8_q8_K<block_q2_Kx8>(n, s, bs, vx, vy, nr, nc);
+#else
+    ggml_gemm_q2_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemm_q3_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    gemm_kx8_q8_K<block_q3_Kx8>(n, s, bs, vx, vy, nr, nc);
+#else
+    ggml_gemm_q3_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemm_q5_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    gemm_kx8_q8_K<block_q5_Kx8>(n, s, bs, vx, vy, nr, nc);
+#else
+    ggml_gemm_q5_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
+
+void ggml_gemm_q6_K_8x8_q8_K(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+#if defined(__AVX2__)
+    gemm_kx8_q8_K<block_q6_Kx8>(n, s, bs, vx, vy, nr, nc);
+#else
+    ggml_gemm_q6_K_8x8_q8_K_generic(n, s, bs, vx, vy, nr, nc);
+#endif
+}
@@ -24,8 +24,45 @@ struct ggml_compute_params {
     void * wdata;
 
     struct ggml_threadpool * threadpool;
+
+    // src1 of the last mul_mat whose converted copy is still in wdata
+    // reset by the graph loop when a later node may overwrite either of them
+    const struct ggml_tensor * wdata_src1;
+    const struct ggml_tensor * wdata_owner;
+    int                        wdata_layout;
 };
 
+// split [0, n) across the threads of params in proportion to the capacity of the cores they are pinned to
+void ggml_cpu_thread_range(const struct ggml_compute_params * params, int64_t n, int64_t * start, int64_t * end);
+
+// number of copies of the weights with GGML_NUMA_STRATEGY_MIRROR (one per node), 0 otherwise
+int  ggml_cpu_numa_n_replicas(void);
+// node that thread ith of a graph computation runs on
+int  ggml_cpu_numa_thread_node(int ith);
+// prefer node for the pages of [data, data + size)
+bool ggml_cpu_numa_bind(void * data, size_t size, int node);
+
+void ggml_compute_forward_mul_mat   (      struct ggml_compute_params * params, struct ggml_tensor * dst);
+void ggml_compute_forward_mul_mat_id(const struct ggml_compute_params * params, struct ggml_tensor * dst);
+
+// layout of a src1 conversion in wdata: rows of `type`, interleaved in groups
+// of 4 rows with `interleave` bytes each (0 = plain rows)
+static inline int ggml_cpu_wdata_layout(enum ggml_type type, int interleave) {
+    return (int) type + GGML_TYPE_COUNT * interleave;
+}
+
+// returns true if src1 of dst is already in wdata with the given layout, so
+// the conversion can be skipped, otherwise records that dst is writing it
+static inline bool ggml_cpu_wdata_has_src1(struct ggml_compute_params * params, const struct ggml_tensor * dst, int layout) {
+    const bool hit = params->wdata_src1 == dst->src[1] && params->wdata_layout == layout;
+
+    params->wdata_src1   = dst->src[1];
+    params->wdata_owner  = dst;
+    params->wdata_layout = layout;
+
+    return hit;
+}
+
 
 #if defined(_MSC_VER)
 
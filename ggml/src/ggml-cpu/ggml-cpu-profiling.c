@@ -3,65 +3,612 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <stdbool.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #if GGML_PROFILING_ENABLED
 
 // Global profiler instance
-ggml_profiler_t g_ggml_profiler = {0};
+ggml_profiler_t g_ggml_profiler = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+int ggml_prof_active __attribute__((aligned(64))) = 0;
+int ggml_prof_trace  __attribute__((aligned(64))) = 0;
+int ggml_prof_nodes  __attribute__((aligned(64))) = 0;
+int ggml_prof_hw     __attribute__((aligned(64))) = 0;
+
+// default until calibrated: nanosecond ticks
+double ggml_prof_us_per_tick = 1e-3;
 
 // Thread-local profiling stack
 __thread ggml_prof_ctx_t ggml_prof_stack[GGML_MAX_PROF_DEPTH] = {0};
 __thread int ggml_prof_stack_depth = 0;
+__thread ggml_prof_thread_t * ggml_prof_thread = NULL;
+
+__thread int32_t ggml_prof_cur_op = -1;
+__thread char    ggml_prof_cur_tensor[GGML_PROF_TRACE_NAME] = {0};
+
+__thread uint64_t ggml_prof_node_hw_start[GGML_PROF_HW_COUNT] = {0};
+__thread uint64_t ggml_prof_node_hw_end[GGML_PROF_HW_COUNT]   = {0};
+
+static const char * prof_hw_names[GGML_PROF_HW_COUNT] = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "stalled backend",
+};
+
+// counters that could be opened on at least one thread
+static int prof_hw_mask = 0;
+
+// thread tables are recycled when their thread exits
+static pthread_key_t  prof_thread_key;
+static pthread_once_t prof_thread_key_once = PTHREAD_ONCE_INIT;
+
+#define GGML_PROF_TRACE_EVENTS_DEFAULT (1u << 16)
+
+static char prof_trace_env_file[1024];
+static char prof_nodes_env_file[1024];
+
+static double prof_monotonic_us(void) {
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+static void prof_calibrate_clock(void) {
+#if defined(__aarch64__)
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    if (freq > 0) {
+        ggml_prof_us_per_tick = 1e6 / (double)freq;
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    // the TSC frequency is not architecturally exposed, measure it against the monotonic clock
+    const double   t0 = prof_monotonic_us();
+    const uint64_t c0 = ggml_prof_ticks();
+    double t1;
+    do {
+        t1 = prof_monotonic_us();
+    } while (t1 - t0 < 10000.0);
+    const uint64_t c1 = ggml_prof_ticks();
+    if (c1 > c0) {
+        ggml_prof_us_per_tick = (t1 - t0) / (double)(c1 - c0);
+    }
+#else
+    ggml_prof_us_per_tick = 1e-3;
+#endif
+}
+
+static int prof_env_enabled(void) {
+    const char * env = getenv("GGML_PROFILING");
+    return env != NULL && env[0] != '\0' && strcmp(env, "0") != 0;
+}
 
 void ggml_profiler_init(void) {
     if (g_ggml_profiler.initialized) {
         return;
     }
-    
-    memset(&g_ggml_profiler, 0, sizeof(ggml_profiler_t));
-    pthread_mutex_init(&g_ggml_profiler.mutex, NULL);
-    g_ggml_profiler.session_start_time_us = ggml_prof_time_us();
-    g_ggml_profiler.initialized = 1;
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    if (!g_ggml_profiler.initialized) {
+        prof_calibrate_clock();
+        g_ggml_profiler.count = 0;
+        memset(g_ggml_profiler.stats, 0, sizeof(g_ggml_profiler.stats));
+        g_ggml_profiler.session_start_ticks = ggml_prof_ticks();
+        g_ggml_profiler.session_start_time_us = g_ggml_profiler.session_start_ticks * ggml_prof_us_per_tick;
+        g_ggml_profiler.initialized = 1;
+    }
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+#ifdef GGML_PROFILING_RUNTIME
+    ggml_profiler_enable(prof_env_enabled());
+    printf("[GGML PROFILER] Profiling initialized (runtime mode)\n");
+#else
+    ggml_profiler_enable(1);
     printf("[GGML PROFILER] Profiling initialized\n");
+#endif
+}
+
+static void prof_save_trace_at_exit(void) {
+    ggml_profiler_save_trace(prof_trace_env_file);
+}
+
+static void prof_save_nodes_at_exit(void) {
+    ggml_profiler_save_nodes(prof_nodes_env_file);
+}
+
+void ggml_profiler_init_from_env(void) {
+    const char * hw = getenv("GGML_PROF_HW");
+    if (hw != NULL && hw[0] != '\0' && strcmp(hw, "0") != 0) {
+        ggml_profiler_init();
+        ggml_profiler_enable(1);
+        ggml_profiler_hw_enable(1);
+    }
+
+    // GGML_PROF_NODES=1 enables node profiling, any other value is a CSV file written at exit
+    const char * nodes = getenv("GGML_PROF_NODES");
+    if (nodes != NULL && nodes[0] != '\0' && strcmp(nodes, "0") != 0) {
+        ggml_profiler_init();
+        ggml_profiler_enable(1);
+        ggml_profiler_nodes_enable(1);
+        if (strcmp(nodes, "1") != 0) {
+            strncpy(prof_nodes_env_file, nodes, sizeof(prof_nodes_env_file) - 1);
+            atexit(prof_save_nodes_at_exit);
+        }
+    }
+
+    const char * trace_file = getenv("GGML_PROF_TRACE");
+    if (trace_file != NULL && trace_file[0] != '\0') {
+        uint64_t n_events = 0;
+        const char * n_events_env = getenv("GGML_PROF_TRACE_EVENTS");
+        if (n_events_env != NULL) {
+            n_events = strtoull(n_events_env, NULL, 10);
+        }
+
+        strncpy(prof_trace_env_file, trace_file, sizeof(prof_trace_env_file) - 1);
+        ggml_profiler_init();
+        ggml_profiler_enable(1);
+        ggml_profiler_trace_enable(1, n_events);
+        atexit(prof_save_trace_at_exit);
+        return;
+    }
+
+    if (prof_env_enabled()) {
+        ggml_profiler_init();
+    }
 }
 
+void ggml_profiler_enable(int enable) {
+    if (enable && !g_ggml_profiler.initialized) {
+        ggml_profiler_init();
+    }
+    __atomic_store_n(&ggml_prof_active, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+int ggml_profiler_is_enabled(void) {
+    return __atomic_load_n(&ggml_prof_active, __ATOMIC_ACQUIRE);
+}
+
+// Interned names and thread tables survive a reset: call sites cache their ids
+// in static storage and threads keep a pointer to their table.
+// Reset while no graph is being computed to avoid losing in-flight samples.
 void ggml_profiler_reset(void) {
     if (!g_ggml_profiler.initialized) {
         return;
     }
-    
+
     pthread_mutex_lock(&g_ggml_profiler.mutex);
+    for (ggml_prof_thread_t * thread = g_ggml_profiler.threads; thread; thread = thread->next) {
+        memset(thread->counters, 0, sizeof(thread->counters));
+        if (thread->nodes) {
+            memset(thread->nodes, 0, GGML_PROF_MAX_NODE_STATS * sizeof(ggml_prof_node_stat_t));
+        }
+        thread->n_nodes_dropped = 0;
+        thread->n_events = 0;
+    }
     g_ggml_profiler.count = 0;
     memset(g_ggml_profiler.stats, 0, sizeof(g_ggml_profiler.stats));
-    g_ggml_profiler.session_start_time_us = ggml_prof_time_us();
+    g_ggml_profiler.session_start_ticks = ggml_prof_ticks();
+    g_ggml_profiler.session_start_time_us = g_ggml_profiler.session_start_ticks * ggml_prof_us_per_tick;
     pthread_mutex_unlock(&g_ggml_profiler.mutex);
     printf("[GGML PROFILER] Profiling reset\n");
 }
 
+int ggml_profiler_intern(const char* name) {
+    if (!name) return -1;
+
+    int id = -1;
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    for (int i = 0; i < g_ggml_profiler.n_names; i++) {
+        if (strcmp(g_ggml_profiler.names[i], name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && g_ggml_profiler.n_names < GGML_PROF_MAX_STATS) {
+        id = g_ggml_profiler.n_names;
+        strncpy(g_ggml_profiler.names[id], name, sizeof(g_ggml_profiler.names[id]) - 1);
+        g_ggml_profiler.names[id][sizeof(g_ggml_profiler.names[id]) - 1] = '\0';
+        g_ggml_profiler.n_names++;
+    }
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+    return id;
+}
+
+static void prof_hw_close(ggml_prof_thread_t * thread);
+
+static void prof_thread_release(void * data) {
+    ggml_prof_thread_t * thread = (ggml_prof_thread_t *) data;
+
+    // perf events count the thread that opened them, the next owner reopens its own
+    prof_hw_close(thread);
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    thread->in_use = 0;
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+}
+
+static void prof_thread_key_init(void) {
+    pthread_key_create(&prof_thread_key, prof_thread_release);
+}
+
+ggml_prof_thread_t* ggml_profiler_thread_register(void) {
+    if (ggml_prof_thread) {
+        return ggml_prof_thread;
+    }
+
+    pthread_once(&prof_thread_key_once, prof_thread_key_init);
+
+    // reuse the table of an exited thread, its samples stay part of the totals.
+    // tables are never freed: a worker thread may exit while its samples are still unmerged
+    ggml_prof_thread_t * thread = NULL;
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    for (ggml_prof_thread_t * t = g_ggml_profiler.threads; t; t = t->next) {
+        if (!t->in_use) {
+            thread = t;
+            break;
+        }
+    }
+    if (thread == NULL) {
+        thread = (ggml_prof_thread_t *) calloc(1, sizeof(ggml_prof_thread_t));
+        if (thread != NULL) {
+            thread->tid = g_ggml_profiler.n_threads++;
+            thread->next = g_ggml_profiler.threads;
+            g_ggml_profiler.threads = thread;
+        }
+    }
+    if (thread != NULL) {
+        thread->in_use = 1;
+    }
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    pthread_setspecific(prof_thread_key, thread);
+
+    ggml_prof_thread = thread;
+    return thread;
+}
+
+//
+// hardware counters
+//
+
+#if defined(__linux__)
+
+static int prof_hw_open_counter(int counter, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+
+    switch (counter) {
+        case GGML_PROF_HW_CYCLES:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case GGML_PROF_HW_INSTRUCTIONS:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case GGML_PROF_HW_L1D_MISSES:
+            attr.type   = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case GGML_PROF_HW_LLC_MISSES:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case GGML_PROF_HW_STALLED_BACKEND:
+            attr.type   = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
+            break;
+        default:
+            return -1;
+    }
+
+    attr.disabled       = group_fd == -1; // the leader enables the whole group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
+
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static int prof_hw_open(ggml_prof_thread_t * thread) {
+    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+        thread->hw_fd[i]    = -1;
+        thread->hw_index[i] = -1;
+    }
+
+    const int leader = prof_hw_open_counter(GGML_PROF_HW_CYCLES, -1);
+    if (leader < 0) {
+        thread->hw_state = -1;
+        return 0;
+    }
+
+    thread->hw_fd[GGML_PROF_HW_CYCLES]    = leader;
+    thread->hw_index[GGML_PROF_HW_CYCLES] = 0;
+
+    int n = 1;
+    int mask = 1 << GGML_PROF_HW_CYCLES;
+    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+        if (i == GGML_PROF_HW_CYCLES) continue;
+        // unsupported events (e.g. backend stalls on many cores) are simply left out
+        const int fd = prof_hw_open_counter(i, leader);
+        if (fd >= 0) {
+            thread->hw_fd[i]    = fd;
+            thread->hw_index[i] = n++;
+            mask |= 1 << i;
+        }
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET,  PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    __atomic_fetch_or(&prof_hw_mask, mask, __ATOMIC_RELAXED);
+    thread->hw_state = 1;
+    return 1;
+}
+
+static void prof_hw_close(ggml_prof_thread_t * thread) {
+    if (thread->hw_state == 1) {
+        for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+            if (thread->hw_fd[i] >= 0) {
+                close(thread->hw_fd[i]);
+            }
+            thread->hw_fd[i] = -1;
+        }
+    }
+    thread->hw_state = 0;
+}
+
+int ggml_prof_hw_read(uint64_t* values) {
+    ggml_prof_thread_t * thread = ggml_prof_thread ? ggml_prof_thread : ggml_profiler_thread_register();
+    if (thread == NULL) {
+        return 0;
+    }
+    if (thread->hw_state == 0) {
+        prof_hw_open(thread);
+    }
+    if (thread->hw_state < 0) {
+        return 0;
+    }
+
+    uint64_t buf[1 + GGML_PROF_HW_COUNT];
+    const ssize_t n = read(thread->hw_fd[GGML_PROF_HW_CYCLES], buf, sizeof(buf));
+    if (n < (ssize_t) (2 * sizeof(uint64_t))) {
+        return 0;
+    }
+
+    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+        const int index = thread->hw_index[i];
+        values[i] = index >= 0 && (uint64_t) index < buf[0] ? buf[1 + index] : 0;
+    }
+    return 1;
+}
+
+#else
+
+static void prof_hw_close(ggml_prof_thread_t * thread) {
+    thread->hw_state = 0;
+}
+
+int ggml_prof_hw_read(uint64_t* values) {
+    (void) values;
+    return 0;
+}
+
+#endif // defined(__linux__)
+
+int ggml_profiler_hw_enable(int enable) {
+    if (!enable) {
+        __atomic_store_n(&ggml_prof_hw, 0, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    if (!g_ggml_profiler.initialized) {
+        ggml_profiler_init();
+    }
+
+    // probe on the calling thread so that an unusable PMU is reported once
+    uint64_t values[GGML_PROF_HW_COUNT];
+    if (!ggml_prof_hw_read(values)) {
+#if defined(__linux__)
+        printf("[GGML PROFILER] perf_event_open failed (%s), hardware counters disabled; "
+               "check /proc/sys/kernel/perf_event_paranoid\n", strerror(errno));
+#else
+        printf("[GGML PROFILER] hardware counters are only supported on Linux/Android\n");
+#endif
+        return 0;
+    }
+
+    __atomic_store_n(&ggml_prof_hw, 1, __ATOMIC_RELEASE);
+    printf("[GGML PROFILER] Hardware counters enabled:");
+    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+        if (prof_hw_mask & (1 << i)) {
+            printf(" %s", prof_hw_names[i]);
+        }
+    }
+    printf("\n");
+    return 1;
+}
+
+void ggml_profiler_trace_alloc(ggml_prof_thread_t* thread) {
+    if (thread->events != NULL || g_ggml_profiler.n_trace_events == 0) {
+        return;
+    }
+
+    // on failure tracing is skipped for this thread, the allocation is retried on the next event
+    thread->events = (ggml_prof_event_t *) calloc(g_ggml_profiler.n_trace_events, sizeof(ggml_prof_event_t));
+    thread->n_events = 0;
+}
+
+void ggml_profiler_trace_enable(int enable, uint64_t n_events) {
+    if (enable && !g_ggml_profiler.initialized) {
+        ggml_profiler_init();
+    }
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    if (enable) {
+        if (n_events == 0) {
+            n_events = GGML_PROF_TRACE_EVENTS_DEFAULT;
+        }
+        if (n_events != g_ggml_profiler.n_trace_events) {
+            // ring capacity changed, drop the old buffers
+            for (ggml_prof_thread_t * thread = g_ggml_profiler.threads; thread; thread = thread->next) {
+                free(thread->events);
+                thread->events = NULL;
+                thread->n_events = 0;
+            }
+            g_ggml_profiler.n_trace_events = n_events;
+        }
+    }
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+    __atomic_store_n(&ggml_prof_trace, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+static void prof_json_write_string(FILE * file, const char * str) {
+    fputc('"', file);
+    for (const char * c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((unsigned char) *c < 0x20) {
+            fprintf(file, "\\u%04x", *c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+void ggml_profiler_save_trace(const char* filename) {
+    if (!filename || filename[0] == '\0' || !g_ggml_profiler.initialized) {
+        return;
+    }
+
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        printf("[GGML PROFILER] Failed to open file %s for writing\n", filename);
+        return;
+    }
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+
+    const uint64_t cap = g_ggml_profiler.n_trace_events;
+    uint64_t n_written = 0;
+    uint64_t n_dropped = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"ggml-cpu\"}}");
+
+    for (ggml_prof_thread_t * thread = g_ggml_profiler.threads; thread; thread = thread->next) {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                thread->tid, thread->tid);
+
+        if (thread->events == NULL || cap == 0) {
+            continue;
+        }
+
+        const uint64_t n     = thread->n_events < cap ? thread->n_events : cap;
+        const uint64_t first = thread->n_events - n;
+        n_dropped += first;
+
+        for (uint64_t i = first; i < thread->n_events; i++) {
+            const ggml_prof_event_t * ev = &thread->events[i % cap];
+            if (ev->id < 0 || ev->id >= g_ggml_profiler.n_names || ev->start_ticks < g_ggml_profiler.session_start_ticks) {
+                continue;
+            }
+
+            const double ts  = (double)(ev->start_ticks - g_ggml_profiler.session_start_ticks) * ggml_prof_us_per_tick;
+            const double dur = (double)(ev->end_ticks   - ev->start_ticks) * ggml_prof_us_per_tick;
+
+            fprintf(file, ",\n{\"name\":");
+            prof_json_write_string(file, g_ggml_profiler.names[ev->id]);
+            fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d,\"args\":{\"tensor\":",
+                    ev->op >= 0 ? ggml_op_name((enum ggml_op) ev->op) : "NONE", ts, dur, thread->tid);
+            prof_json_write_string(file, ev->tensor);
+            fprintf(file, ",\"bytes\":%llu}}", (unsigned long long) ev->bytes);
+            n_written++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+    fclose(file);
+    printf("[GGML PROFILER] Trace with %llu events saved to %s", (unsigned long long) n_written, filename);
+    if (n_dropped > 0) {
+        printf(" (%llu older events overwritten, raise GGML_PROF_TRACE_EVENTS to keep them)", (unsigned long long) n_dropped);
+    }
+    printf("\n");
+}
+
+void ggml_profiler_merge(void) {
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+
+    memset(g_ggml_profiler.stats, 0, sizeof(g_ggml_profiler.stats));
+    g_ggml_profiler.count = 0;
+
+    for (int id = 0; id < g_ggml_profiler.n_names; id++) {
+        ggml_prof_stat_t merged = {0};
+        strncpy(merged.name, g_ggml_profiler.names[id], sizeof(merged.name) - 1);
+
+        for (ggml_prof_thread_t * thread = g_ggml_profiler.threads; thread; thread = thread->next) {
+            const ggml_prof_counter_t * counter = &thread->counters[id];
+            if (counter->call_count == 0) continue;
+
+            if (merged.call_count == 0 || counter->min_time_us < merged.min_time_us) {
+                merged.min_time_us = counter->min_time_us;
+            }
+            if (merged.call_count == 0 || counter->max_time_us > merged.max_time_us) {
+                merged.max_time_us = counter->max_time_us;
+            }
+            merged.total_time_us += counter->total_time_us;
+            merged.call_count    += counter->call_count;
+            merged.total_bytes   += counter->total_bytes;
+            merged.hw_calls      += counter->hw_calls;
+            for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+                merged.hw[i] += counter->hw[i];
+            }
+        }
+
+        if (merged.call_count > 0) {
+            g_ggml_profiler.stats[g_ggml_profiler.count++] = merged;
+        }
+    }
+
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+}
+
 ggml_prof_stat_t* ggml_profiler_get_stat(const char* name) {
     if (!name || !g_ggml_profiler.initialized) return NULL;
-    
-    // Try to find existing stat
+
+    ggml_profiler_merge();
+
     for (int i = 0; i < g_ggml_profiler.count; i++) {
         if (strcmp(g_ggml_profiler.stats[i].name, name) == 0) {
             return &g_ggml_profiler.stats[i];
         }
     }
-    
-    // Create new stat if we have space
-    if (g_ggml_profiler.count < 128) {  // Increased from 64 to 128
-        ggml_prof_stat_t* stat = &g_ggml_profiler.stats[g_ggml_profiler.count];
-        strncpy(stat->name, name, sizeof(stat->name) - 1);
-        stat->name[sizeof(stat->name) - 1] = '\0';
-        stat->total_time_us = 0.0;
-        stat->call_count = 0;
-        stat->total_bytes = 0;
-        stat->min_time_us = 0.0;
-        stat->max_time_us = 0.0;
-        g_ggml_profiler.count++;
-        return stat;
-    }
-    
+
     return NULL;
 }
 
@@ -80,7 +627,45 @@ static double calculate_bandwidth_mbps(uint64_t bytes, double time_us) {
     return (bytes / 1024.0 / 1024.0) / (time_us / 1000000.0);
 }
 
+// LLC misses are counted in cache lines, assume 64 bytes per line
+#define GGML_PROF_CACHE_LINE 64
+
+static double prof_hw_ratio(uint64_t num, uint64_t den) {
+    return den > 0 ? (double) num / (double) den : 0.0;
+}
+
+static void prof_print_hw(const ggml_prof_stat_t * stats, int count) {
+    printf("\nHardware Counters (perf_event_open, outermost regions only):\n");
+    print_separator();
+    printf("%-20s %10s %12s %6s %12s %12s %7s %10s\n",
+           "Operation", "Calls", "Mcycles", "IPC", "L1D miss/c", "LLC miss/c", "Stall%", "DRAM GB/s");
+    print_separator();
+    for (int i = 0; i < count; i++) {
+        const ggml_prof_stat_t * stat = &stats[i];
+        if (stat->hw_calls == 0) continue;
+
+        const uint64_t * hw = stat->hw;
+        const double dram_bytes = (double) hw[GGML_PROF_HW_LLC_MISSES] * GGML_PROF_CACHE_LINE;
+        printf("%-20s %10lu %12.2f %6.2f %12.1f %12.1f %6.1f%% %10.2f\n",
+               stat->name, (unsigned long) stat->hw_calls,
+               hw[GGML_PROF_HW_CYCLES] / 1e6,
+               prof_hw_ratio(hw[GGML_PROF_HW_INSTRUCTIONS], hw[GGML_PROF_HW_CYCLES]),
+               prof_hw_ratio(hw[GGML_PROF_HW_L1D_MISSES], stat->hw_calls),
+               prof_hw_ratio(hw[GGML_PROF_HW_LLC_MISSES], stat->hw_calls),
+               100.0 * prof_hw_ratio(hw[GGML_PROF_HW_STALLED_BACKEND], hw[GGML_PROF_HW_CYCLES]),
+               stat->total_time_us > 0.0 ? dram_bytes / 1e3 / stat->total_time_us : 0.0);
+    }
+    print_separator();
+    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+        if (!(prof_hw_mask & (1 << i))) {
+            printf("[GGML PROFILER] %s not supported on this CPU, reported as 0\n", prof_hw_names[i]);
+        }
+    }
+}
+
 void ggml_profiler_print_results(void) {
+    ggml_profiler_merge();
+
     if (g_ggml_profiler.count == 0) {
         printf("[GGML PROFILER] No profiling data available\n");
         return;
@@ -102,7 +687,7 @@ void ggml_profiler_print_results(void) {
     uint64_t total_all_bytes = 0;
     
     // Sort operations by total time (descending)
-    ggml_prof_stat_t sorted_stats[64];
+    ggml_prof_stat_t sorted_stats[GGML_PROF_MAX_STATS];
     memcpy(sorted_stats, g_ggml_profiler.stats, g_ggml_profiler.count * sizeof(ggml_prof_stat_t));
     
     for (int i = 0; i < g_ggml_profiler.count - 1; i++) {
@@ -145,6 +730,10 @@ void ggml_profiler_print_results(void) {
     printf("Profiling Overhead: %.2f%% of session time\n", 
            (total_all_ops_time_us / session_total_time_us) * 100.0);
     print_separator();
+
+    if (prof_hw_mask != 0) {
+        prof_print_hw(sorted_stats, g_ggml_profiler.count);
+    }
     
     // Print operation type breakdown
     printf("\nOperation Type Breakdown:\n");
@@ -285,27 +874,12 @@ void ggml_profiler_print_results(void) {
      ggml_prof_stat_t* rmsnorm = NULL;
      ggml_prof_stat_t* rope = NULL;
      ggml_prof_stat_t* softmax = NULL;
-     ggml_prof_stat_t* q_proj = NULL;
-     ggml_prof_stat_t* k_proj = NULL;
-     ggml_prof_stat_t* v_proj = NULL;
-     ggml_prof_stat_t* o_proj = NULL;
-     ggml_prof_stat_t* up_proj = NULL;
-     ggml_prof_stat_t* gate_proj = NULL;
-     ggml_prof_stat_t* down_proj = NULL;
     
          for (int i = 0; i < g_ggml_profiler.count; i++) {
          // Layer operations
          if (strcmp(g_ggml_profiler.stats[i].name, "ggml_compute_forward_rms_norm_f32") == 0) rmsnorm = &g_ggml_profiler.stats[i];
          else if (strcmp(g_ggml_profiler.stats[i].name, "ggml_compute_forward_rope_f32") == 0) rope = &g_ggml_profiler.stats[i];
          else if (strcmp(g_ggml_profiler.stats[i].name, "ggml_compute_forward_soft_max_f32") == 0) softmax = &g_ggml_profiler.stats[i];
-         // Projection operations
-         else if (strcmp(g_ggml_profiler.stats[i].name, "q_projection") == 0) q_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "k_projection") == 0) k_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "v_projection") == 0) v_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "o_projection") == 0) o_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "up_projection") == 0) up_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "gate_projection") == 0) gate_proj = &g_ggml_profiler.stats[i];
-         else if (strcmp(g_ggml_profiler.stats[i].name, "down_projection") == 0) down_proj = &g_ggml_profiler.stats[i];
          // Legacy names for backward compatibility
          else if (strcmp(g_ggml_profiler.stats[i].name, "rmsnorm") == 0 && !rmsnorm) rmsnorm = &g_ggml_profiler.stats[i];
          else if (strcmp(g_ggml_profiler.stats[i].name, "rope") == 0 && !rope) rope = &g_ggml_profiler.stats[i];
@@ -328,51 +902,21 @@ void ggml_profiler_print_results(void) {
                 calculate_bandwidth_mbps(softmax->total_bytes, softmax->total_time_us));
      }
      
-     // Attention projections
-     if (q_proj && q_proj->call_count > 0) {
-         printf("Q Projection       : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:q]\n", 
-                q_proj->total_time_us / 1000.0, q_proj->call_count,
-                calculate_bandwidth_mbps(q_proj->total_bytes, q_proj->total_time_us));
-     }
-     if (k_proj && k_proj->call_count > 0) {
-         printf("K Projection       : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:k]\n", 
-                k_proj->total_time_us / 1000.0, k_proj->call_count,
-                calculate_bandwidth_mbps(k_proj->total_bytes, k_proj->total_time_us));
-     }
-     if (v_proj && v_proj->call_count > 0) {
-         printf("V Projection       : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:v]\n", 
-                v_proj->total_time_us / 1000.0, v_proj->call_count,
-                calculate_bandwidth_mbps(v_proj->total_bytes, v_proj->total_time_us));
-     }
-     if (o_proj && o_proj->call_count > 0) {
-         printf("O Projection       : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:o]\n", 
-                o_proj->total_time_us / 1000.0, o_proj->call_count,
-                calculate_bandwidth_mbps(o_proj->total_bytes, o_proj->total_time_us));
-     }
-     
-     // FFN projections
-     if (up_proj && up_proj->call_count > 0) {
-         printf("Up Projection      : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:up]\n", 
-                up_proj->total_time_us / 1000.0, up_proj->call_count,
-                calculate_bandwidth_mbps(up_proj->total_bytes, up_proj->total_time_us));
-     }
-     if (gate_proj && gate_proj->call_count > 0) {
-         printf("Gate Projection    : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:gate]\n", 
-                gate_proj->total_time_us / 1000.0, gate_proj->call_count,
-                calculate_bandwidth_mbps(gate_proj->total_bytes, gate_proj->total_time_us));
-     }
-     if (down_proj && down_proj->call_count > 0) {
-         printf("Down Projection    : %8.2f ms (%6lu calls) - %.1f MB/s [mul_mat:down]\n", 
-                down_proj->total_time_us / 1000.0, down_proj->call_count,
-                calculate_bandwidth_mbps(down_proj->total_bytes, down_proj->total_time_us));
-     }
-    
     print_separator();
     printf("\n");
+
+    // Per-layer / per-op breakdown, replaces the projection guesses from tensor names
+    ggml_profiler_print_nodes();
 }
 
 void ggml_profiler_save_results(const char* filename) {
-    if (!filename || g_ggml_profiler.count == 0) {
+    if (!filename) {
+        return;
+    }
+
+    ggml_profiler_merge();
+
+    if (g_ggml_profiler.count == 0) {
         return;
     }
     
@@ -411,4 +955,413 @@ void ggml_profiler_save_results(const char* filename) {
     printf("[GGML PROFILER] Results saved to %s\n", filename);
 }
 
+//
+// per-node profiling
+//
+
+void ggml_profiler_nodes_enable(int enable) {
+    if (enable && !g_ggml_profiler.initialized) {
+        ggml_profiler_init();
+    }
+    __atomic_store_n(&ggml_prof_nodes, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+// "Qcur-12 (reshaped)" -> "Qcur", 12
+static int prof_split_node_name(const char * name, char * base, size_t size) {
+    size_t n = 0;
+    while (name[n] != '\0' && n + 1 < size && !(name[n] == ' ' && name[n + 1] == '(')) {
+        base[n] = name[n];
+        n++;
+    }
+    base[n] = '\0';
+
+    char * dash = strrchr(base, '-');
+    if (dash == NULL || dash[1] == '\0') {
+        return -1;
+    }
+    for (const char * c = dash + 1; *c; c++) {
+        if (*c < '0' || *c > '9') {
+            return -1;
+        }
+    }
+
+    const int layer = atoi(dash + 1);
+    *dash = '\0';
+    return layer;
+}
+
+static uint32_t prof_node_hash(const char * name, int32_t layer, int32_t op) {
+    uint32_t hash = 2166136261u;
+    for (const char * c = name; *c; c++) {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+    hash = (hash ^ (uint32_t) layer) * 16777619u;
+    hash = (hash ^ (uint32_t) op)    * 16777619u;
+    return hash ? hash : 1;
+}
+
+static ggml_prof_node_stat_t * prof_node_find(ggml_prof_node_stat_t * table, uint32_t hash, const char * name, int32_t layer, int32_t op) {
+    for (uint32_t i = 0; i < GGML_PROF_MAX_NODE_STATS; i++) {
+        ggml_prof_node_stat_t * slot = &table[(hash + i) % GGML_PROF_MAX_NODE_STATS];
+        if (slot->hash == 0) {
+            slot->hash  = hash;
+            slot->layer = layer;
+            slot->op    = op;
+            snprintf(slot->name, sizeof(slot->name), "%s", name);
+            return slot;
+        }
+        if (slot->hash == hash && slot->layer == layer && slot->op == op && strcmp(slot->name, name) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static bool prof_is_view_op(enum ggml_op op) {
+    return op == GGML_OP_NONE || op == GGML_OP_VIEW || op == GGML_OP_RESHAPE ||
+           op == GGML_OP_PERMUTE || op == GGML_OP_TRANSPOSE;
+}
+
+// Rough FLOP counts, good enough to place a node on the roofline
+static double prof_node_flops(const struct ggml_tensor * node) {
+    const double ne = (double) ggml_nelements(node);
+
+    switch (node->op) {
+        case GGML_OP_MUL_MAT:
+        case GGML_OP_MUL_MAT_ID:
+            return 2.0 * (double) node->src[0]->ne[0] * ne;
+        case GGML_OP_OUT_PROD:
+            return 2.0 * (double) node->src[0]->ne[1] * ne;
+        case GGML_OP_FLASH_ATTN_EXT:
+            {
+                const struct ggml_tensor * q = node->src[0];
+                const struct ggml_tensor * k = node->src[1];
+                const struct ggml_tensor * v = node->src[2];
+                const double rows = (double) ggml_nelements(q) / (double) q->ne[0];
+                return 2.0 * rows * (double) k->ne[1] * (double) (q->ne[0] + v->ne[0]);
+            }
+        case GGML_OP_SOFT_MAX:
+        case GGML_OP_NORM:
+            return 5.0 * ne;
+        case GGML_OP_RMS_NORM:
+        case GGML_OP_L2_NORM:
+            return 3.0 * ne;
+        case GGML_OP_ROPE:
+            return 6.0 * ne;
+        case GGML_OP_UNARY:
+            return 4.0 * ne;
+        case GGML_OP_ADD:
+        case GGML_OP_ADD1:
+        case GGML_OP_SUB:
+        case GGML_OP_MUL:
+        case GGML_OP_DIV:
+        case GGML_OP_SCALE:
+        case GGML_OP_SQR:
+        case GGML_OP_SQRT:
+        case GGML_OP_SUM_ROWS:
+            return ne;
+        default:
+            return 0.0;
+    }
+}
+
+static uint64_t prof_node_bytes(const struct ggml_tensor * node) {
+    if (prof_is_view_op(node->op)) {
+        return 0;
+    }
+
+    if (node->op == GGML_OP_GET_ROWS) {
+        // only the selected rows of src0 are read
+        return 2 * ggml_nbytes(node) + ggml_nbytes(node->src[1]);
+    }
+
+    uint64_t bytes = ggml_nbytes(node);
+    for (int i = 0; i < GGML_MAX_SRC; i++) {
+        const struct ggml_tensor * src = node->src[i];
+        if (src == NULL) {
+            continue;
+        }
+        uint64_t src_bytes = ggml_nbytes(src);
+        if (node->op == GGML_OP_MUL_MAT_ID && i == 0) {
+            // only the experts selected by ids are read
+            const struct ggml_tensor * ids = node->src[2];
+            const double n_used = (double) ids->ne[0] * (double) ids->ne[1];
+            if (n_used < (double) src->ne[2]) {
+                src_bytes = (uint64_t) (src_bytes * n_used / (double) src->ne[2]);
+            }
+        }
+        bytes += src_bytes;
+    }
+    return bytes;
+}
+
+void ggml_prof_node_record(const struct ggml_tensor* node, int ith, uint64_t t_start, uint64_t t_busy_end) {
+    const uint64_t t_end = ggml_prof_ticks();
+
+    ggml_prof_thread_t * thread = ggml_prof_thread ? ggml_prof_thread : ggml_profiler_thread_register();
+    if (thread == NULL) {
+        return;
+    }
+    if (thread->nodes == NULL) {
+        thread->nodes = (ggml_prof_node_stat_t *) calloc(GGML_PROF_MAX_NODE_STATS, sizeof(ggml_prof_node_stat_t));
+        if (thread->nodes == NULL) {
+            return;
+        }
+    }
+
+    char name[GGML_PROF_TRACE_NAME];
+    const int32_t layer = prof_split_node_name(node->name, name, sizeof(name));
+    const int32_t op    = (int32_t) node->op;
+
+    ggml_prof_node_stat_t * stat = prof_node_find(thread->nodes, prof_node_hash(name, layer, op), name, layer, op);
+    if (stat == NULL) {
+        thread->n_nodes_dropped++;
+        return;
+    }
+
+    stat->busy_time_us += (double) (t_busy_end - t_start) * ggml_prof_us_per_tick;
+
+    if (ggml_prof_hw) {
+        for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+            stat->hw[i] += ggml_prof_node_hw_end[i] - ggml_prof_node_hw_start[i];
+        }
+    }
+
+    // per-node totals are accounted once, by the thread that always participates
+    if (ith == 0) {
+        stat->call_count++;
+        stat->wall_time_us += (double) (t_end - t_start) * ggml_prof_us_per_tick;
+        stat->flops        += prof_node_flops(node);
+        stat->bytes        += prof_node_bytes(node);
+    }
+}
+
+// merge all thread tables, returns the number of entries written to out
+static int prof_merge_nodes(ggml_prof_node_stat_t * out, uint64_t * n_dropped) {
+    ggml_prof_node_stat_t * table = (ggml_prof_node_stat_t *) calloc(GGML_PROF_MAX_NODE_STATS, sizeof(ggml_prof_node_stat_t));
+    if (table == NULL) {
+        return 0;
+    }
+
+    *n_dropped = 0;
+
+    pthread_mutex_lock(&g_ggml_profiler.mutex);
+    for (ggml_prof_thread_t * thread = g_ggml_profiler.threads; thread; thread = thread->next) {
+        *n_dropped += thread->n_nodes_dropped;
+        if (thread->nodes == NULL) {
+            continue;
+        }
+        for (int i = 0; i < GGML_PROF_MAX_NODE_STATS; i++) {
+            const ggml_prof_node_stat_t * src = &thread->nodes[i];
+            if (src->hash == 0) {
+                continue;
+            }
+            ggml_prof_node_stat_t * dst = prof_node_find(table, src->hash, src->name, src->layer, src->op);
+            if (dst == NULL) {
+                (*n_dropped)++;
+                continue;
+            }
+            dst->call_count   += src->call_count;
+            dst->busy_time_us += src->busy_time_us;
+            dst->wall_time_us += src->wall_time_us;
+            dst->flops        += src->flops;
+            dst->bytes        += src->bytes;
+            for (int k = 0; k < GGML_PROF_HW_COUNT; k++) {
+                dst->hw[k] += src->hw[k];
+            }
+        }
+    }
+    pthread_mutex_unlock(&g_ggml_profiler.mutex);
+
+    int n = 0;
+    for (int i = 0; i < GGML_PROF_MAX_NODE_STATS; i++) {
+        if (table[i].hash != 0 && table[i].call_count > 0) {
+            out[n++] = table[i];
+        }
+    }
+    free(table);
+
+    return n;
+}
+
+static int prof_node_cmp_wall(const void * a, const void * b) {
+    const double wa = ((const ggml_prof_node_stat_t *) a)->wall_time_us;
+    const double wb = ((const ggml_prof_node_stat_t *) b)->wall_time_us;
+    return (wa < wb) - (wa > wb);
+}
+
+static double prof_env_double(const char * name) {
+    const char * value = getenv(name);
+    return value ? atof(value) : 0.0;
+}
+
+static const char * prof_node_bound(const ggml_prof_node_stat_t * stat, double peak_gflops, double peak_gbps) {
+    if (peak_gflops <= 0.0 || peak_gbps <= 0.0 || stat->bytes == 0) {
+        return "-";
+    }
+    // ridge point of the roofline in FLOP/byte
+    const double ridge = peak_gflops / peak_gbps;
+    return stat->flops / (double) stat->bytes < ridge ? "memory" : "compute";
+}
+
+void ggml_profiler_print_nodes(void) {
+    ggml_prof_node_stat_t * stats = (ggml_prof_node_stat_t *) malloc(GGML_PROF_MAX_NODE_STATS * sizeof(ggml_prof_node_stat_t));
+    if (stats == NULL) {
+        return;
+    }
+
+    uint64_t n_dropped = 0;
+    const int n = prof_merge_nodes(stats, &n_dropped);
+    if (n == 0) {
+        free(stats);
+        return;
+    }
+
+    const double peak_gflops = prof_env_double("GGML_PROF_PEAK_GFLOPS");
+    const double peak_gbps   = prof_env_double("GGML_PROF_PEAK_GBPS");
+
+    double total_wall_us = 0.0;
+    int max_layer = -1;
+    for (int i = 0; i < n; i++) {
+        total_wall_us += stats[i].wall_time_us;
+        if (stats[i].layer > max_layer) {
+            max_layer = stats[i].layer;
+        }
+    }
+
+    printf("\nPer-Layer Breakdown (graph nodes):\n");
+    print_separator();
+    printf("%-8s %12s %12s %10s %10s %8s %8s %7s\n",
+           "Layer", "Wall(ms)", "Busy(ms)", "GFLOP", "MB", "GFLOP/s", "GB/s", "Share");
+    print_separator();
+    for (int layer = -1; layer <= max_layer; layer++) {
+        double wall = 0.0, busy = 0.0, flops = 0.0;
+        uint64_t bytes = 0;
+        for (int i = 0; i < n; i++) {
+            if (stats[i].layer != layer) continue;
+            wall  += stats[i].wall_time_us;
+            busy  += stats[i].busy_time_us;
+            flops += stats[i].flops;
+            bytes += stats[i].bytes;
+        }
+        if (wall <= 0.0) continue;
+
+        char label[16];
+        snprintf(label, sizeof(label), layer < 0 ? "other" : "%d", layer);
+        printf("%-8s %12.2f %12.2f %10.3f %10.1f %8.2f %8.2f %6.1f%%\n",
+               label, wall / 1000.0, busy / 1000.0, flops / 1e9, bytes / 1024.0 / 1024.0,
+               flops / 1e3 / wall, bytes / 1e3 / wall, 100.0 * wall / total_wall_us);
+    }
+    print_separator();
+
+    printf("\nPer-Op Breakdown (graph nodes):\n");
+    print_separator();
+    printf("%-16s %10s %12s %8s %8s %9s %8s\n",
+           "Op", "Calls", "Wall(ms)", "GFLOP/s", "GB/s", "FLOP/B", "Share");
+    print_separator();
+    for (int op = 0; op < GGML_OP_COUNT; op++) {
+        double wall = 0.0, flops = 0.0;
+        uint64_t bytes = 0, calls = 0;
+        for (int i = 0; i < n; i++) {
+            if (stats[i].op != op) continue;
+            wall  += stats[i].wall_time_us;
+            flops += stats[i].flops;
+            bytes += stats[i].bytes;
+            calls += stats[i].call_count;
+        }
+        if (calls == 0) continue;
+
+        printf("%-16s %10lu %12.2f %8.2f %8.2f %9.2f %6.1f%%\n",
+               ggml_op_name((enum ggml_op) op), (unsigned long) calls, wall / 1000.0,
+               wall > 0.0 ? flops / 1e3 / wall : 0.0, wall > 0.0 ? bytes / 1e3 / wall : 0.0,
+               bytes > 0 ? flops / (double) bytes : 0.0, 100.0 * wall / total_wall_us);
+    }
+    print_separator();
+
+    qsort(stats, n, sizeof(ggml_prof_node_stat_t), prof_node_cmp_wall);
+
+    const int n_top = n < 40 ? n : 40;
+    printf("\nRoofline, top %d nodes by wall time%s:\n", n_top,
+           peak_gflops > 0.0 && peak_gbps > 0.0 ? "" : " (set GGML_PROF_PEAK_GFLOPS/GGML_PROF_PEAK_GBPS to classify)");
+    print_separator();
+    // with hardware counters the arithmetic intensity is also measured against actual DRAM traffic
+    const bool hw = prof_hw_mask != 0;
+    printf("%-5s %-20s %-12s %8s %10s %10s %8s %8s %8s %8s",
+           "Layer", "Tensor", "Op", "Calls", "Wall(ms)", "Avg(μs)", "GFLOP/s", "GB/s", "FLOP/B", "Bound");
+    printf(hw ? " %6s %10s\n" : "\n", "IPC", "FLOP/DRAMB");
+    print_separator();
+    for (int i = 0; i < n_top; i++) {
+        const ggml_prof_node_stat_t * stat = &stats[i];
+        const double wall = stat->wall_time_us;
+        printf("%-5d %-20s %-12s %8lu %10.2f %10.2f %8.2f %8.2f %8.2f %8s",
+               stat->layer, stat->name, ggml_op_name((enum ggml_op) stat->op), (unsigned long) stat->call_count,
+               wall / 1000.0, wall / stat->call_count,
+               wall > 0.0 ? stat->flops / 1e3 / wall : 0.0, wall > 0.0 ? stat->bytes / 1e3 / wall : 0.0,
+               stat->bytes > 0 ? stat->flops / (double) stat->bytes : 0.0,
+               prof_node_bound(stat, peak_gflops, peak_gbps));
+        if (hw) {
+            const uint64_t dram_bytes = stat->hw[GGML_PROF_HW_LLC_MISSES] * GGML_PROF_CACHE_LINE;
+            printf(" %6.2f %10.2f",
+                   prof_hw_ratio(stat->hw[GGML_PROF_HW_INSTRUCTIONS], stat->hw[GGML_PROF_HW_CYCLES]),
+                   dram_bytes > 0 ? stat->flops / (double) dram_bytes : 0.0);
+        }
+        printf("\n");
+    }
+    print_separator();
+    if (n_dropped > 0) {
+        printf("[GGML PROFILER] %lu node samples dropped, node table full\n", (unsigned long) n_dropped);
+    }
+
+    free(stats);
+}
+
+void ggml_profiler_save_nodes(const char* filename) {
+    if (!filename || filename[0] == '\0') {
+        return;
+    }
+
+    ggml_prof_node_stat_t * stats = (ggml_prof_node_stat_t *) malloc(GGML_PROF_MAX_NODE_STATS * sizeof(ggml_prof_node_stat_t));
+    if (stats == NULL) {
+        return;
+    }
+
+    uint64_t n_dropped = 0;
+    const int n = prof_merge_nodes(stats, &n_dropped);
+
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        printf("[GGML PROFILER] Failed to open file %s for writing\n", filename);
+        free(stats);
+        return;
+    }
+
+    const double peak_gflops = prof_env_double("GGML_PROF_PEAK_GFLOPS");
+    const double peak_gbps   = prof_env_double("GGML_PROF_PEAK_GBPS");
+
+    qsort(stats, n, sizeof(ggml_prof_node_stat_t), prof_node_cmp_wall);
+
+    fprintf(file, "Layer,Tensor,Op,Calls,Wall_ms,Busy_ms,GFLOP,Total_Bytes,GFLOPs,GBps,FLOP_per_Byte,Bound,"
+                  "Cycles,Instructions,L1D_Misses,LLC_Misses,Stalled_Backend,IPC,FLOP_per_DRAM_Byte\n");
+    for (int i = 0; i < n; i++) {
+        const ggml_prof_node_stat_t * stat = &stats[i];
+        const double wall = stat->wall_time_us;
+        const uint64_t dram_bytes = stat->hw[GGML_PROF_HW_LLC_MISSES] * GGML_PROF_CACHE_LINE;
+        fprintf(file, "%d,%s,%s,%lu,%.3f,%.3f,%.6f,%lu,%.3f,%.3f,%.3f,%s,%lu,%lu,%lu,%lu,%lu,%.3f,%.3f\n",
+                stat->layer, stat->name, ggml_op_name((enum ggml_op) stat->op), (unsigned long) stat->call_count,
+                wall / 1000.0, stat->busy_time_us / 1000.0, stat->flops / 1e9, (unsigned long) stat->bytes,
+                wall > 0.0 ? stat->flops / 1e3 / wall : 0.0, wall > 0.0 ? stat->bytes / 1e3 / wall : 0.0,
+                stat->bytes > 0 ? stat->flops / (double) stat->bytes : 0.0,
+                prof_node_bound(stat, peak_gflops, peak_gbps),
+                (unsigned long) stat->hw[GGML_PROF_HW_CYCLES], (unsigned long) stat->hw[GGML_PROF_HW_INSTRUCTIONS],
+                (unsigned long) stat->hw[GGML_PROF_HW_L1D_MISSES], (unsigned long) stat->hw[GGML_PROF_HW_LLC_MISSES],
+                (unsigned long) stat->hw[GGML_PROF_HW_STALLED_BACKEND],
+                prof_hw_ratio(stat->hw[GGML_PROF_HW_INSTRUCTIONS], stat->hw[GGML_PROF_HW_CYCLES]),
+                dram_bytes > 0 ? stat->flops / (double) dram_bytes : 0.0);
+    }
+
+    fclose(file);
+    free(stats);
+    printf("[GGML PROFILER] Node results saved to %s\n", filename);
+}
+
 #endif // GGML_PROFILING_ENABLED
@@ -4,28 +4,88 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
-#include <sys/time.h>
 #include <pthread.h>
 
+#include "ggml.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Enable profiling by default for mobile builds
+// Build modes, selected with -DGGML_CPU_PROFILING=OFF|ON|RUNTIME:
+//   OFF     - GGML_PROFILING_ENABLED=0, all profiling macros compile to nothing
+//   ON      - GGML_PROFILING_ENABLED=1, profiling is active after ggml_profiler_init()
+//   RUNTIME - GGML_PROFILING_ENABLED=1 and GGML_PROFILING_RUNTIME=1, compiled in but inactive
+//             until ggml_profiler_enable(1) or GGML_PROFILING=1 in the environment
 #ifndef GGML_PROFILING_ENABLED
-#define GGML_PROFILING_ENABLED 1
+#define GGML_PROFILING_ENABLED 0
 #endif
 
 #if GGML_PROFILING_ENABLED
 
+// Hot-path switch, kept on its own cache line so that interning and merging never
+// invalidate it. When it is 0 the profiling macros do not read the timer at all.
+extern int ggml_prof_active;
+
+// Set while the per-thread trace ring buffers are being filled
+extern int ggml_prof_trace;
+
+// Set while ggml_graph_compute_thread records per-node statistics
+extern int ggml_prof_nodes;
+
+// Set while hardware counters are read around nodes and outermost regions
+extern int ggml_prof_hw;
+
+#ifdef GGML_PROFILING_RUNTIME
+#define GGML_PROF_IS_ACTIVE() __builtin_expect(ggml_prof_active, 0)
+#else
+#define GGML_PROF_IS_ACTIVE() (ggml_prof_active)
+#endif
+
+// Monotonic cycle-counter clock, converted to microseconds with a factor calibrated
+// in ggml_profiler_init()
+extern double ggml_prof_us_per_tick;
+
+static inline uint64_t ggml_prof_ticks(void) {
+#if defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+    return ticks;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
 // High-resolution timer functions
 static inline double ggml_prof_time_us(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+    return (double)ggml_prof_ticks() * ggml_prof_us_per_tick;
 }
 
-// Profiling data structure  
+#define GGML_PROF_MAX_STATS 128
+
+// Hardware counters collected with perf_event_open (Linux/Android only)
+enum ggml_prof_hw_counter {
+    GGML_PROF_HW_CYCLES,
+    GGML_PROF_HW_INSTRUCTIONS,
+    GGML_PROF_HW_L1D_MISSES,
+    GGML_PROF_HW_LLC_MISSES,
+    GGML_PROF_HW_STALLED_BACKEND,
+    GGML_PROF_HW_COUNT,
+};
+
+// Profiling data structure (merged view, produced by ggml_profiler_merge)
 typedef struct {
     char name[64];
     double total_time_us;
@@ -35,13 +95,76 @@ typedef struct {
     double max_time_us;
     uint32_t layer_id;
     char layer_type[32];
+    uint64_t hw[GGML_PROF_HW_COUNT];
+    uint64_t hw_calls;
 } ggml_prof_stat_t;
 
+// Per-thread accumulator, indexed by interned stat id.
+// Only the owning thread writes to it, so the hot path needs no locking.
+typedef struct {
+    double total_time_us;
+    uint64_t call_count;
+    uint64_t total_bytes;
+    double min_time_us;
+    double max_time_us;
+    uint64_t hw[GGML_PROF_HW_COUNT];  // only for regions opened at stack depth 0
+    uint64_t hw_calls;
+} ggml_prof_counter_t;
+
+// Trace event, recorded into a per-thread ring buffer when tracing is enabled
+#define GGML_PROF_TRACE_NAME 32
+
 typedef struct {
-    ggml_prof_stat_t stats[128];  // Increased from 64 to 128
-    int count;
+    uint64_t start_ticks;
+    uint64_t end_ticks;
+    uint64_t bytes;
+    int32_t  id;                           // interned stat id
+    int32_t  op;                           // enum ggml_op of the node being computed, -1 if none
+    char     tensor[GGML_PROF_TRACE_NAME]; // name of the node being computed
+} ggml_prof_event_t;
+
+// Per-node statistics, keyed by (tensor name without layer suffix, layer, op).
+// "Qcur-12" is recorded as name "Qcur", layer 12.
+#define GGML_PROF_MAX_NODE_STATS 4096
+
+typedef struct {
+    uint32_t hash;                         // 0 marks an empty slot
+    int32_t  layer;                        // -1 if the tensor name has no layer suffix
+    int32_t  op;                           // enum ggml_op
+    char     name[GGML_PROF_TRACE_NAME];
+    uint64_t call_count;
+    double   busy_time_us;                 // time spent inside the op, summed over threads
+    double   wall_time_us;                 // node start to the following barrier, thread 0 only
+    double   flops;                        // estimated, thread 0 only
+    uint64_t bytes;                        // src + dst tensor bytes, thread 0 only
+    uint64_t hw[GGML_PROF_HW_COUNT];       // hardware counters inside the op, summed over threads
+} ggml_prof_node_stat_t;
+
+typedef struct ggml_prof_thread {
+    ggml_prof_counter_t counters[GGML_PROF_MAX_STATS];
+    ggml_prof_node_stat_t * nodes; // node table, NULL until node profiling is enabled
+    uint64_t n_nodes_dropped;      // node samples lost because the table was full
+    int hw_fd[GGML_PROF_HW_COUNT]; // perf event fds, the cycles counter leads the group
+    int hw_index[GGML_PROF_HW_COUNT]; // position of each counter in the group read, -1 if unavailable
+    int hw_state;                  // 0 - not opened, 1 - open, -1 - unavailable
+    int in_use;                    // 0 once the owning thread has exited, the table is then reused
+    ggml_prof_event_t * events;  // trace ring buffer, NULL until tracing is enabled
+    uint64_t n_events;           // total events recorded, the ring holds the last n_trace_events
+    int tid;                     // registration order, used as the trace thread id
+    struct ggml_prof_thread * next;
+} ggml_prof_thread_t;
+
+typedef struct {
+    ggml_prof_stat_t stats[GGML_PROF_MAX_STATS]; // merged results, valid after ggml_profiler_merge()
+    int count;                                   // number of merged stats
+    char names[GGML_PROF_MAX_STATS][64];         // interned names, index == stat id
+    int n_names;
+    ggml_prof_thread_t * threads;                // registered per-thread tables
+    int n_threads;
+    uint64_t n_trace_events;                     // per-thread ring buffer capacity
     double session_start_time_us;
-    pthread_mutex_t mutex;
+    uint64_t session_start_ticks;
+    pthread_mutex_t mutex;                       // guards interning, thread registration and merging
     int initialized;
 } ggml_profiler_t;
 
@@ -50,9 +173,12 @@ extern ggml_profiler_t g_ggml_profiler;
 
 // Thread-local profiling context
 typedef struct {
-    double start_time;
-    ggml_prof_stat_t* stat;
+    uint64_t start_ticks;
+    ggml_prof_counter_t* counter;
     uint64_t bytes;
+    int32_t id;
+    int32_t has_hw;
+    uint64_t hw_start[GGML_PROF_HW_COUNT];
 } ggml_prof_ctx_t;
 
 // Thread-local storage for profiling stack
@@ -60,6 +186,15 @@ typedef struct {
 
 extern __thread ggml_prof_ctx_t ggml_prof_stack[GGML_MAX_PROF_DEPTH];
 extern __thread int ggml_prof_stack_depth;
+extern __thread ggml_prof_thread_t * ggml_prof_thread;
+
+// Node currently computed by this thread, attached to trace events
+extern __thread int32_t ggml_prof_cur_op;
+extern __thread char    ggml_prof_cur_tensor[GGML_PROF_TRACE_NAME];
+
+// Hardware counter snapshots around the node being computed
+extern __thread uint64_t ggml_prof_node_hw_start[GGML_PROF_HW_COUNT];
+extern __thread uint64_t ggml_prof_node_hw_end[GGML_PROF_HW_COUNT];
 
 // Profiling functions with thread safety
 void ggml_profiler_init(void);
@@ -68,48 +203,217 @@ void ggml_profiler_print_results(void);
 void ggml_profiler_save_results(const char* filename);
 ggml_prof_stat_t* ggml_profiler_get_stat(const char* name);
 
-// Thread-safe profiling API
-static inline void ggml_prof_start_impl(const char* name, uint64_t bytes) {
-    if (!g_ggml_profiler.initialized) return;
-    
-    if (ggml_prof_stack_depth < GGML_MAX_PROF_DEPTH - 1) {
-        ggml_prof_stack[ggml_prof_stack_depth].start_time = ggml_prof_time_us();
-        pthread_mutex_lock(&g_ggml_profiler.mutex);
-        ggml_prof_stack[ggml_prof_stack_depth].stat = ggml_profiler_get_stat(name);
-        pthread_mutex_unlock(&g_ggml_profiler.mutex);
-        ggml_prof_stack[ggml_prof_stack_depth].bytes = bytes;
-        ggml_prof_stack_depth++;
+// Toggle sample collection; only call while no graph is being computed
+void ggml_profiler_enable(int enable);
+int  ggml_profiler_is_enabled(void);
+
+// Initialize the profiler if GGML_PROFILING or GGML_PROF_TRACE is set in the environment
+// (called from ggml_cpu_init). GGML_PROF_TRACE=<file> also enables tracing and writes the
+// trace to <file> at exit.
+void ggml_profiler_init_from_env(void);
+
+// Chrome trace / Perfetto timeline export. n_events is the per-thread ring capacity
+// (0 selects the default). Only call while no graph is being computed.
+void ggml_profiler_trace_enable(int enable, uint64_t n_events);
+void ggml_profiler_save_trace(const char* filename);
+void ggml_profiler_trace_alloc(ggml_prof_thread_t* thread);
+
+// Per-graph-node profiling with a per-layer / per-op roofline table.
+// Enabled with ggml_profiler_nodes_enable(1) or GGML_PROF_NODES=1. Set GGML_PROF_PEAK_GFLOPS
+// and GGML_PROF_PEAK_GBPS to classify nodes as compute or memory bound.
+void ggml_profiler_nodes_enable(int enable);
+void ggml_profiler_print_nodes(void);
+void ggml_profiler_save_nodes(const char* filename);
+void ggml_prof_node_record(const struct ggml_tensor* node, int ith, uint64_t t_start, uint64_t t_busy_end);
+
+// Hardware counters via perf_event_open, enabled with ggml_profiler_hw_enable(1) or GGML_PROF_HW=1.
+// Counters are read with a syscall, so they are only collected around graph nodes and around
+// profiled regions opened at stack depth 0 (e.g. matmul, rms_norm), never around vec_dot calls.
+// Returns 1 if the counters could be opened on the calling thread.
+int  ggml_profiler_hw_enable(int enable);
+int  ggml_prof_hw_read(uint64_t* values);
+
+// Merge all per-thread tables into g_ggml_profiler.stats
+void ggml_profiler_merge(void);
+
+// Slow paths, each taken at most once per call site / per thread
+int ggml_profiler_intern(const char* name);
+ggml_prof_thread_t* ggml_profiler_thread_register(void);
+
+// Stat id of a call site whose name could not be interned (the names table is full)
+#define GGML_PROF_ID_NONE -2
+
+// Lock-free profiling API: the stat id is interned once per call site
+// Every start pushes a frame so that the matching end pops it, even when nothing is recorded
+// (no stat id, no thread table, or deeper than GGML_MAX_PROF_DEPTH).
+static inline void ggml_prof_start_impl(int id, uint64_t bytes) {
+    ggml_prof_thread_t* thread = NULL;
+    if (id >= 0) {
+        thread = ggml_prof_thread;
+        if (thread == NULL) {
+            thread = ggml_profiler_thread_register();
+        }
+    }
+
+    const int depth = ggml_prof_stack_depth++;
+    if (depth >= GGML_MAX_PROF_DEPTH) {
+        return;
+    }
+
+    ggml_prof_ctx_t* ctx = &ggml_prof_stack[depth];
+    if (thread == NULL) {
+        ctx->counter = NULL;
+        return;
     }
+
+    ctx->counter = &thread->counters[id];
+    ctx->bytes = bytes;
+    ctx->id = id;
+    ctx->has_hw = 0;
+    if (__builtin_expect(ggml_prof_hw, 0) && depth == 0) {
+        ctx->has_hw = ggml_prof_hw_read(ctx->hw_start);
+    }
+    ctx->start_ticks = ggml_prof_ticks();
 }
 
 static inline void ggml_prof_end_impl(void) {
-    if (!g_ggml_profiler.initialized) return;
-    
+    if (!GGML_PROF_IS_ACTIVE()) return;
+
     if (ggml_prof_stack_depth > 0) {
         ggml_prof_stack_depth--;
+        if (ggml_prof_stack_depth >= GGML_MAX_PROF_DEPTH) {
+            return;
+        }
         ggml_prof_ctx_t* ctx = &ggml_prof_stack[ggml_prof_stack_depth];
-        if (ctx->stat) {
-            double end_time = ggml_prof_time_us();
-            double duration = end_time - ctx->start_time;
-            
-            pthread_mutex_lock(&g_ggml_profiler.mutex);
-            ctx->stat->total_time_us += duration;
-            ctx->stat->call_count++;
-            ctx->stat->total_bytes += ctx->bytes;
-            if (ctx->stat->call_count == 1 || duration < ctx->stat->min_time_us) {
-                ctx->stat->min_time_us = duration;
+        ggml_prof_counter_t* counter = ctx->counter;
+        if (counter) {
+            const uint64_t end_ticks = ggml_prof_ticks();
+            double duration = (double)(end_ticks - ctx->start_ticks) * ggml_prof_us_per_tick;
+
+            if (ctx->has_hw) {
+                uint64_t hw_end[GGML_PROF_HW_COUNT];
+                if (ggml_prof_hw_read(hw_end)) {
+                    for (int i = 0; i < GGML_PROF_HW_COUNT; i++) {
+                        counter->hw[i] += hw_end[i] - ctx->hw_start[i];
+                    }
+                    counter->hw_calls++;
+                }
+            }
+
+            counter->total_time_us += duration;
+            counter->call_count++;
+            counter->total_bytes += ctx->bytes;
+            if (counter->call_count == 1 || duration < counter->min_time_us) {
+                counter->min_time_us = duration;
             }
-            if (ctx->stat->call_count == 1 || duration > ctx->stat->max_time_us) {
-                ctx->stat->max_time_us = duration;
+            if (counter->call_count == 1 || duration > counter->max_time_us) {
+                counter->max_time_us = duration;
+            }
+
+            if (__builtin_expect(ggml_prof_trace, 0)) {
+                ggml_prof_thread_t* thread = ggml_prof_thread;
+                if (thread->events == NULL) {
+                    ggml_profiler_trace_alloc(thread);
+                }
+                if (thread->events != NULL) {
+                    ggml_prof_event_t* ev = &thread->events[thread->n_events % g_ggml_profiler.n_trace_events];
+                    ev->start_ticks = ctx->start_ticks;
+                    ev->end_ticks   = end_ticks;
+                    ev->bytes       = ctx->bytes;
+                    ev->id          = ctx->id;
+                    ev->op          = ggml_prof_cur_op;
+                    memcpy(ev->tensor, ggml_prof_cur_tensor, GGML_PROF_TRACE_NAME);
+                    thread->n_events++;
+                }
             }
-            pthread_mutex_unlock(&g_ggml_profiler.mutex);
         }
     }
 }
 
-#define GGML_PROF_START(name, bytes) ggml_prof_start_impl(#name, (uint64_t)(bytes))
+#define GGML_PROF_START(name, bytes)                                                   \
+    do {                                                                               \
+        if (GGML_PROF_IS_ACTIVE()) {                                                   \
+            static int ggml_prof_id_ = -1;                                             \
+            int ggml_prof_id_cur_ = __atomic_load_n(&ggml_prof_id_, __ATOMIC_RELAXED); \
+            if (ggml_prof_id_cur_ == -1) {                                             \
+                ggml_prof_id_cur_ = ggml_profiler_intern(#name);                       \
+                if (ggml_prof_id_cur_ < 0) {                                           \
+                    ggml_prof_id_cur_ = GGML_PROF_ID_NONE;                             \
+                }                                                                      \
+                __atomic_store_n(&ggml_prof_id_, ggml_prof_id_cur_, __ATOMIC_RELAXED); \
+            }                                                                          \
+            ggml_prof_start_impl(ggml_prof_id_cur_, (uint64_t)(bytes));                \
+        }                                                                              \
+    } while (0)
+
 #define GGML_PROF_END(name) ggml_prof_end_impl()
 
+// Record which graph node the calling thread is computing
+static inline void ggml_prof_set_node(const struct ggml_tensor* node) {
+    if (!GGML_PROF_IS_ACTIVE()) return;
+
+    ggml_prof_cur_op = node ? (int32_t)node->op : -1;
+    if (node) {
+        strncpy(ggml_prof_cur_tensor, node->name, GGML_PROF_TRACE_NAME - 1);
+        ggml_prof_cur_tensor[GGML_PROF_TRACE_NAME - 1] = '\0';
+    } else {
+        ggml_prof_cur_tensor[0] = '\0';
+    }
+}
+
+#define GGML_PROF_SET_NODE(node) ggml_prof_set_node(node)
+
+// Timestamps taken around each node by ggml_graph_compute_thread, 0 when node profiling is off
+static inline uint64_t ggml_prof_node_begin(void) {
+    if (!GGML_PROF_IS_ACTIVE() || !ggml_prof_nodes) return 0;
+    if (__builtin_expect(ggml_prof_hw, 0) && !ggml_prof_hw_read(ggml_prof_node_hw_start)) {
+        memset(ggml_prof_node_hw_start, 0, sizeof(ggml_prof_node_hw_start));
+    }
+    return ggml_prof_ticks();
+}
+
+static inline uint64_t ggml_prof_node_busy_end(uint64_t t_start) {
+    if (t_start == 0) return 0;
+    const uint64_t t = ggml_prof_ticks();
+    if (__builtin_expect(ggml_prof_hw, 0) && !ggml_prof_hw_read(ggml_prof_node_hw_end)) {
+        memcpy(ggml_prof_node_hw_end, ggml_prof_node_hw_start, sizeof(ggml_prof_node_hw_end));
+    }
+    return t;
+}
+
+static inline void ggml_prof_node_end(const struct ggml_tensor* node, int ith, uint64_t t_start, uint64_t t_busy_end) {
+    if (t_start == 0) return;
+    ggml_prof_node_record(node, ith, t_start, t_busy_end);
+}
+
+#else // GGML_PROFILING_ENABLED
+
+// No-op macros when profiling is disabled
+#define GGML_PROF_START(name, bytes) ((void)0)
+#define GGML_PROF_END(name)          ((void)0)
+#define GGML_PROF_SET_NODE(node)     ((void)0)
+
+static inline void ggml_profiler_init(void) {}
+static inline void ggml_profiler_reset(void) {}
+static inline void ggml_profiler_print_results(void) {}
+static inline void ggml_profiler_save_results(const char* filename) { (void)filename; }
+static inline void ggml_profiler_enable(int enable) { (void)enable; }
+static inline int  ggml_profiler_is_enabled(void) { return 0; }
+static inline void ggml_profiler_init_from_env(void) {}
+static inline void ggml_profiler_trace_enable(int enable, uint64_t n_events) { (void)enable; (void)n_events; }
+static inline void ggml_profiler_nodes_enable(int enable) { (void)enable; }
+static inline void ggml_profiler_print_nodes(void) {}
+static inline void ggml_profiler_save_nodes(const char* filename) { (void)filename; }
+static inline int ggml_profiler_hw_enable(int enable) { (void)enable; return 0; }
+static inline uint64_t ggml_prof_node_begin(void) { return 0; }
+static inline uint64_t ggml_prof_node_busy_end(uint64_t t_start) { (void)t_start; return 0; }
+static inline void ggml_prof_node_end(const struct ggml_tensor* node, int ith, uint64_t t_start, uint64_t t_busy_end) {
+    (void)node; (void)ith; (void)t_start; (void)t_busy_end;
+}
+static inline void ggml_profiler_save_trace(const char* filename) { (void)filename; }
+
+#endif // GGML_PROFILING_ENABLED
+
 // Specialized macros for different operation types
 #define GGML_PROF_QUANTIZE_START(type, elements) \
     GGML_PROF_START(quantize_##type, (elements) * sizeof(float))
@@ -123,8 +427,8 @@ static inline void ggml_prof_end_impl(void) {
 #define GGML_PROF_VEC_DOT_END(type1, type2) \
     GGML_PROF_END(vec_dot_##type1##_##type2)
 
-#define GGML_PROF_MATMUL_START(rows, cols) \
-    GGML_PROF_START(matmul, (rows) * (cols) * sizeof(float))
+#define GGML_PROF_MATMUL_START(bytes) \
+    GGML_PROF_START(matmul, (bytes))
 
 #define GGML_PROF_MATMUL_END() \
     GGML_PROF_END(matmul)
@@ -141,6 +445,10 @@ static inline void ggml_prof_end_impl(void) {
 #define GGML_PROF_DEQUANT_END(type) \
     GGML_PROF_END(dequant_##type)
 
+// Time spent waiting in ggml_barrier, shows thread imbalance in traces
+#define GGML_PROF_BARRIER_START() GGML_PROF_START(ggml_barrier, 0)
+#define GGML_PROF_BARRIER_END() GGML_PROF_END(ggml_barrier)
+
 // Detailed dequantization profiling for w4a8 vs w8a8 analysis
 #define GGML_PROF_W4_DEQUANT_START(bytes) GGML_PROF_START(w4_dequant, bytes)
 #define GGML_PROF_W4_DEQUANT_END() GGML_PROF_END(w4_dequant)
@@ -164,28 +472,6 @@ static inline void ggml_prof_end_impl(void) {
 #define GGML_PROF_ATTENTION_START(bytes) GGML_PROF_START(attention, bytes)
 #define GGML_PROF_ATTENTION_END() GGML_PROF_END(attention)
 
-// Layer projection profiling (Q, K, V, O, Up, Gate, Down)
-#define GGML_PROF_Q_PROJ_START(bytes) GGML_PROF_START(q_projection, bytes)
-#define GGML_PROF_Q_PROJ_END() GGML_PROF_END(q_projection)
-
-#define GGML_PROF_K_PROJ_START(bytes) GGML_PROF_START(k_projection, bytes)
-#define GGML_PROF_K_PROJ_END() GGML_PROF_END(k_projection)
-
-#define GGML_PROF_V_PROJ_START(bytes) GGML_PROF_START(v_projection, bytes)
-#define GGML_PROF_V_PROJ_END() GGML_PROF_END(v_projection)
-
-#define GGML_PROF_O_PROJ_START(bytes) GGML_PROF_START(o_projection, bytes)
-#define GGML_PROF_O_PROJ_END() GGML_PROF_END(o_projection)
-
-#define GGML_PROF_UP_PROJ_START(bytes) GGML_PROF_START(up_projection, bytes)
-#define GGML_PROF_UP_PROJ_END() GGML_PROF_END(up_projection)
-
-#define GGML_PROF_GATE_PROJ_START(bytes) GGML_PROF_START(gate_projection, bytes)
-#define GGML_PROF_GATE_PROJ_END() GGML_PROF_END(gate_projection)
-
-#define GGML_PROF_DOWN_PROJ_START(bytes) GGML_PROF_START(down_projection, bytes)
-#define GGML_PROF_DOWN_PROJ_END() GGML_PROF_END(down_projection)
-
 // Enhanced function-specific profiling with source info
 #define GGML_PROF_FUNC_START(func_name, bytes) GGML_PROF_START(func_name, bytes)
 #define GGML_PROF_FUNC_END(func_name) GGML_PROF_END(func_name)
@@ -230,29 +516,6 @@ static inline void ggml_prof_end_impl(void) {
 #define GGML_PROF_SOFTMAX_FUNC_START(bytes) GGML_PROF_START(ggml_compute_forward_soft_max_f32, bytes)
 #define GGML_PROF_SOFTMAX_FUNC_END() GGML_PROF_END(ggml_compute_forward_soft_max_f32)
 
-#else // GGML_PROFILING_ENABLED
-
-// No-op macros when profiling is disabled
-#define GGML_PROF_START(name, bytes)
-#define GGML_PROF_END(name)
-#define GGML_PROF_QUANTIZE_START(type, elements)
-#define GGML_PROF_QUANTIZE_END(type)
-#define GGML_PROF_VEC_DOT_START(type1, type2, n)
-#define GGML_PROF_VEC_DOT_END(type1, type2)
-#define GGML_PROF_MATMUL_START(rows, cols)
-#define GGML_PROF_MATMUL_END()
-#define GGML_PROF_MEMCPY_START(bytes)
-#define GGML_PROF_MEMCPY_END()
-#define GGML_PROF_DEQUANT_START(type, elements)
-#define GGML_PROF_DEQUANT_END(type)
-
-static inline void ggml_profiler_init(void) {}
-static inline void ggml_profiler_reset(void) {}
-static inline void ggml_profiler_print_results(void) {}
-static inline void ggml_profiler_save_results(const char* filename) { (void)filename; }
-
-#endif // GGML_PROFILING_ENABLED
-
 #ifdef __cplusplus
 }
 #endif
@@ -39,6 +39,10 @@
 #include <syscall.h>
 #endif
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#endif
+
 #ifdef GGML_USE_OPENMP
 #include <omp.h>
 #endif
@@ -433,6 +437,49 @@ typedef pthread_mutex_t    ggml_mutex_t;
 
 #endif
 
+// Node of the combining-tree barrier, each counter on its own cache line
+struct ggml_barrier_node {
+    atomic_int GGML_CACHE_ALIGN n_arrived;
+};
+
+// Fan-in of the combining-tree barrier
+#define GGML_BARRIER_FANIN 4
+
+// Below this many threads a single shared counter is cheaper than the tree
+#define GGML_BARRIER_TREE_MIN_THREADS 8
+
+// Adaptive polling: number of gaps between graphs that are tracked, and the longest time the
+// workers poll. When graphs typically come further apart than that, the workers sleep right away.
+#define GGML_THREADPOOL_POLL_N_GAPS  8
+#define GGML_THREADPOOL_POLL_MAX_US  2000
+
+// Task queue of a thread while independent graph nodes are computed concurrently.
+// The k-th task of the queue of thread ith is its chunk of the k-th node of the group.
+// The low bits of state count the tasks taken, the high bits tag the group, so that a
+// thread still scanning the queues of the previous group cannot take a task of the next.
+struct ggml_branch_queue {
+    atomic_int GGML_CACHE_ALIGN state;
+};
+
+#define GGML_BRANCH_QUEUE_TAG_SHIFT 8
+#define GGML_BRANCH_QUEUE_TAG_MASK  0x7fffff
+#define GGML_BRANCH_QUEUE_N_MASK    ((1 << GGML_BRANCH_QUEUE_TAG_SHIFT) - 1)
+
+// Max number of nodes computed concurrently, and how far ahead to look for them
+#define GGML_BRANCH_MAX_NODES 8
+#define GGML_BRANCH_MAX_SCAN  32
+
+// Schedule of a graph node, decided once per cplan so that the compute threads only read it.
+// n_run is the number of nodes computed from this node on when it starts a step.
+struct ggml_graph_sched_node {
+    int32_t n_run;
+    int32_t flags;
+};
+
+#define GGML_GRAPH_SCHED_BRANCH  1 // the step is a group of branches
+#define GGML_GRAPH_SCHED_BARRIER 2 // the threads sync before the next step
+#define GGML_GRAPH_SCHED_WDATA   4 // the node uses the work buffer
+
 // Threadpool def
 struct ggml_threadpool {
     ggml_mutex_t mutex;       // mutex for cond.var
@@ -447,6 +494,9 @@ struct ggml_threadpool {
     atomic_int GGML_CACHE_ALIGN n_barrier_passed;
     atomic_int GGML_CACHE_ALIGN current_chunk; // currently processing chunk during Mat_Mul, shared between all the threads.
 
+    struct ggml_barrier_node * barrier_tree; // n_threads_max nodes, used by the barrier between graph nodes
+    struct ggml_branch_queue * branch_queues; // n_threads_max queues, used for groups of independent nodes
+
     // these are atomic as an annotation for thread-sanitizer
     atomic_bool stop;         // Used for stopping the threadpool altogether
     atomic_bool pause;        // Used for pausing the threadpool or individual threads
@@ -457,7 +507,13 @@ struct ggml_threadpool {
     atomic_int   n_threads_cur; // number of threads used in the current graph
 
     int32_t      prio;        // Scheduling priority
-    uint32_t     poll;        // Polling level (0 - no polling)
+    uint32_t     poll;        // Polling level (0 - no polling, GGML_THREADPOOL_POLL_ADAPTIVE)
+
+    // adaptive polling: recent gaps between graphs, and how long the workers poll before they sleep
+    int64_t      t_graph_end;                              // end of the last graph, 0 if none yet
+    int64_t      graph_gaps[GGML_THREADPOOL_POLL_N_GAPS];  // last gaps between graphs in us
+    int          n_graph_gaps;
+    atomic_int   poll_us;
 
     enum ggml_status ec;
 };
@@ -469,9 +525,14 @@ struct ggml_compute_state {
     bool cpumask[GGML_MAX_N_THREADS];
     int  last_graph;
     bool pending;
+
+    // time spent waiting for work that then came, updated by the thread before it computes the graph
+    int64_t t_poll_us;
+    int64_t t_sleep_us;
 #endif
     struct ggml_threadpool * threadpool;
     int ith;
+    uint32_t capacity; // mean capacity of the CPUs the thread is allowed on, 0 if unknown
 };
 
 // Helpers for polling loops
@@ -516,8 +577,19 @@ struct ggml_numa_nodes {
 // ggml state
 //
 
+//
+// heterogeneous (big.LITTLE / P+E core) support
+//
+
+struct ggml_cpu_capacity {
+    uint32_t n_cpus;                         // CPUs with a known capacity
+    uint32_t capacity[GGML_MAX_N_THREADS];   // relative throughput of each CPU, the fastest is 1024
+    bool     hybrid;                         // cores of different speed are present
+};
+
 struct ggml_state {
     struct ggml_numa_nodes numa;
+    struct ggml_cpu_capacity capacity;
 };
 
 static struct ggml_state g_state = {0};
@@ -528,6 +600,8 @@ void ggml_barrier(struct ggml_threadpool * tp) {
         return;
     }
 
+    GGML_PROF_BARRIER_START();
+
 #ifdef GGML_USE_OPENMP
     #pragma omp barrier
 #else
@@ -542,6 +616,8 @@ void ggml_barrier(struct ggml_threadpool * tp) {
 
         // exit barrier (fill seq-cst fence)
         atomic_fetch_add_explicit(&tp->n_barrier_passed, 1, memory_order_seq_cst);
+
+        GGML_PROF_BARRIER_END();
         return;
     }
 
@@ -558,6 +634,69 @@ void ggml_barrier(struct ggml_threadpool * tp) {
     atomic_thread_fence(memory_order_seq_cst);
     #endif
 #endif
+
+    GGML_PROF_BARRIER_END();
+}
+
+// Barrier between graph nodes. With many threads the arrivals are combined in a
+// tree of GGML_BARRIER_FANIN-way counters, so no cache line is hit by more than
+// GGML_BARRIER_FANIN threads; the last thread to reach the root releases everyone.
+// It only uses the atomics of the threadpool, so the OpenMP threads use it as well.
+static void ggml_barrier_ith(struct ggml_threadpool * tp, int ith) {
+    const int n_threads = atomic_load_explicit(&tp->n_threads_cur, memory_order_relaxed);
+    if (n_threads < GGML_BARRIER_TREE_MIN_THREADS) {
+        ggml_barrier(tp);
+        return;
+    }
+
+    GGML_PROF_BARRIER_START();
+
+    int n_passed = atomic_load_explicit(&tp->n_barrier_passed, memory_order_relaxed);
+
+    int n_level = n_threads; // nodes at the level being entered
+    int base    = 0;         // offset of the counters of that level in barrier_tree
+    int idx     = ith;
+
+    for (;;) {
+        const int group   = idx / GGML_BARRIER_FANIN;
+        const int n_group = MIN(GGML_BARRIER_FANIN, n_level - group*GGML_BARRIER_FANIN);
+
+        atomic_int * n_arrived = &tp->barrier_tree[base + group].n_arrived;
+
+        // enter the node (full seq-cst fence)
+        if (atomic_fetch_add_explicit(n_arrived, 1, memory_order_seq_cst) != n_group - 1) {
+            break;
+        }
+
+        // last one in: reset the node and carry the arrival of the group upwards
+        atomic_store_explicit(n_arrived, 0, memory_order_relaxed);
+
+        base   += (n_level + GGML_BARRIER_FANIN - 1) / GGML_BARRIER_FANIN;
+        n_level = (n_level + GGML_BARRIER_FANIN - 1) / GGML_BARRIER_FANIN;
+        idx     = group;
+
+        if (n_level == 1) {
+            // root, exit barrier (full seq-cst fence)
+            atomic_fetch_add_explicit(&tp->n_barrier_passed, 1, memory_order_seq_cst);
+
+            GGML_PROF_BARRIER_END();
+            return;
+        }
+    }
+
+    // wait for other threads
+    while (atomic_load_explicit(&tp->n_barrier_passed, memory_order_relaxed) == n_passed) {
+        ggml_thread_cpu_relax();
+    }
+
+    // exit barrier (full seq-cst fence)
+    #ifdef GGML_TSAN_ENABLED
+    atomic_fetch_add_explicit(&tp->n_barrier_passed, 0, memory_order_seq_cst);
+    #else
+    atomic_thread_fence(memory_order_seq_cst);
+    #endif
+
+    GGML_PROF_BARRIER_END();
 }
 
 #if defined(__gnu_linux__)
@@ -667,6 +806,181 @@ bool ggml_is_numa(void) {
     return g_state.numa.n_nodes > 1;
 }
 
+int ggml_cpu_numa_n_replicas(void) {
+    return ggml_is_numa() && g_state.numa.numa_strategy == GGML_NUMA_STRATEGY_MIRROR ? (int) g_state.numa.n_nodes : 0;
+}
+
+int ggml_cpu_numa_thread_node(int ith) {
+    // threads are spread over the nodes like with GGML_NUMA_STRATEGY_DISTRIBUTE, see set_numa_thread_affinity
+    return ggml_cpu_numa_n_replicas() > 0 ? ith % (int) g_state.numa.n_nodes : 0;
+}
+
+// the work of mul_mat is split statically by thread, so that each thread keeps reading the same
+// part of the weights, unless every node has its own copy of them
+static bool ggml_cpu_numa_static_chunks(void) {
+    return ggml_is_numa() && ggml_cpu_numa_n_replicas() == 0;
+}
+
+#if defined(__gnu_linux__)
+// mbind(2) without a dependency on libnuma
+#define GGML_MPOL_PREFERRED  1
+#define GGML_MPOL_INTERLEAVE 3
+#define GGML_MPOL_MF_MOVE    (1 << 1)
+
+static bool ggml_cpu_numa_mbind(void * data, size_t size, int mode, unsigned long nodemask, unsigned flags) {
+    const uintptr_t page  = (uintptr_t) sysconf(_SC_PAGESIZE);
+    const uintptr_t start = (uintptr_t) data & ~(page - 1);
+    const uintptr_t end   = ((uintptr_t) data + size + page - 1) & ~(page - 1);
+
+    return syscall(SYS_mbind, (void *) start, end - start, mode, &nodemask, sizeof(nodemask)*8, flags) == 0;
+}
+#endif
+
+bool ggml_cpu_numa_bind(void * data, size_t size, int node) {
+#if defined(__gnu_linux__)
+    return ggml_cpu_numa_mbind(data, size, GGML_MPOL_PREFERRED, 1ul << node, 0);
+#else
+    UNUSED(data);
+    UNUSED(size);
+    UNUSED(node);
+    return false;
+#endif
+}
+
+void ggml_numa_interleave(void * data, size_t size) {
+#if defined(__gnu_linux__)
+    const int n_nodes = ggml_cpu_numa_n_replicas();
+    if (n_nodes == 0 || size == 0) {
+        return;
+    }
+
+    if (!ggml_cpu_numa_mbind(data, size, GGML_MPOL_INTERLEAVE, (1ul << n_nodes) - 1, GGML_MPOL_MF_MOVE)) {
+        GGML_LOG_WARN("%s: mbind failed: %s\n", __func__, strerror(errno));
+    }
+#else
+    UNUSED(data);
+    UNUSED(size);
+#endif
+}
+
+static void ggml_cpu_init_capacity(void) {
+    struct ggml_cpu_capacity * cc = &g_state.capacity;
+
+#if defined(__linux__)
+    // arm64 kernels (and recent x86 ones on hybrid parts) report the relative
+    // throughput of each core, see Documentation/scheduler/sched-capacity.rst
+    uint32_t cap_min = UINT32_MAX;
+    uint32_t cap_max = 0;
+
+    for (uint32_t cpu = 0; cpu < GGML_MAX_N_THREADS; ++cpu) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpu_capacity", cpu);
+
+        // offline CPUs have no capacity, keep looking past them
+        FILE * f = fopen(path, "r");
+        if (!f) {
+            continue;
+        }
+
+        unsigned int cap = 0;
+        const int rc = fscanf(f, "%u", &cap);
+        fclose(f);
+
+        if (rc != 1 || cap == 0) {
+            continue;
+        }
+
+        cc->capacity[cpu] = cap;
+        cc->n_cpus        = cpu + 1;
+        cap_min = MIN(cap_min, cap);
+        cap_max = MAX(cap_max, cap);
+    }
+
+    cc->hybrid = cc->n_cpus > 0 && cap_min < cap_max;
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // hybrid Intel parts, even without per-core capacities
+    if (!cc->hybrid) {
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            cc->hybrid = !!(edx & (1u << 15));
+        }
+    }
+#endif
+
+    GGML_PRINT_DEBUG("%s: hybrid = %d, %u CPUs with known capacity\n", __func__, cc->hybrid, cc->n_cpus);
+}
+
+bool ggml_cpu_is_hybrid(void) {
+    return g_state.capacity.hybrid;
+}
+
+static uint32_t ggml_thread_cpumask_capacity(const bool * mask) {
+    const struct ggml_cpu_capacity * cc = &g_state.capacity;
+
+    uint64_t sum = 0;
+    uint32_t n   = 0;
+
+    for (uint32_t cpu = 0; cpu < cc->n_cpus; ++cpu) {
+        // CPUs without a known capacity are offline
+        if (!mask[cpu] || cc->capacity[cpu] == 0) {
+            continue;
+        }
+        sum += cc->capacity[cpu];
+        n++;
+    }
+
+    return n > 0 ? (uint32_t) (sum / n) : 0;
+}
+
+#if defined(GGML_USE_OPENMP)
+// mean capacity of the CPUs the calling thread is allowed on, e.g. with OMP_PROC_BIND and OMP_PLACES
+static uint32_t ggml_thread_affinity_capacity(void) {
+#if defined(__gnu_linux__)
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return 0;
+    }
+
+    bool mask[GGML_MAX_N_THREADS];
+    for (int cpu = 0; cpu < GGML_MAX_N_THREADS; ++cpu) {
+        mask[cpu] = cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+    }
+
+    return ggml_thread_cpumask_capacity(mask);
+#else
+    return 0;
+#endif
+}
+#endif
+
+void ggml_cpu_thread_range(const struct ggml_compute_params * params, int64_t n, int64_t * start, int64_t * end) {
+    const int ith = params->ith;
+    const int nth = params->nth;
+
+    const struct ggml_compute_state * workers = params->threadpool->workers;
+
+    uint64_t w_start = 0;
+    uint64_t w_total = 0;
+
+    for (int j = 0; j < nth; ++j) {
+        if (workers[j].capacity == 0) {
+            // placement unknown, split evenly
+            *start = (ith * n) / nth;
+            *end   = ((ith + 1) * n) / nth;
+            return;
+        }
+        if (j < ith) {
+            w_start += workers[j].capacity;
+        }
+        w_total += workers[j].capacity;
+    }
+
+    *start = (int64_t) (((uint64_t) n * w_start) / w_total);
+    *end   = (int64_t) (((uint64_t) n * (w_start + workers[ith].capacity)) / w_total);
+}
+
 #if defined(__ARM_ARCH)
 
 #if defined(__linux__) && defined(__aarch64__)
@@ -1249,7 +1563,7 @@ static void ggml_compute_forward_mul_mat_one_chunk(
 
                 for (int64_t ir0 = iir0; ir0 < iir0 + blck_0 && ir0 < ir0_end; ir0 += num_rows_per_vec_dot) {
                     // Profile vector dot product
-                    GGML_PROF_START(vec_dot, ne00 * num_rows_per_vec_dot * ggml_type_size(type));
+                    GGML_PROF_START(vec_dot, num_rows_per_vec_dot * (ggml_row_size(type, ne00) + row_size));
                     vec_dot(ne00, &tmp[ir0 - iir0], (num_rows_per_vec_dot > 1 ? 16 : 0), src0_row + ir0 * nb01, (num_rows_per_vec_dot > 1 ? nb01 : 0), src1_col, (num_rows_per_vec_dot > 1 ? src1_col_stride : 0), num_rows_per_vec_dot);
                     GGML_PROF_END(vec_dot);
                 }
@@ -1262,9 +1576,9 @@ static void ggml_compute_forward_mul_mat_one_chunk(
     }
 }
 
-static void ggml_compute_forward_mul_mat(
-        const struct ggml_compute_params * params,
-              struct ggml_tensor * dst) {
+void ggml_compute_forward_mul_mat(
+        struct ggml_compute_params * params,
+        struct ggml_tensor * dst) {
 
     const struct ggml_tensor * src0 = dst->src[0];
     const struct ggml_tensor * src1 = dst->src[1];
@@ -1275,7 +1589,8 @@ static void ggml_compute_forward_mul_mat(
     const int nth = params->nth;
 
     // Start general matmul profiling
-    GGML_PROF_MATMUL_START(ne01 * ne11, ne00);
+    // each thread works on roughly 1/nth of the operands
+    GGML_PROF_MATMUL_START((ggml_nbytes(src0) + ggml_nbytes(src1) + ggml_nbytes(dst)) / nth);
 
     enum ggml_type           const vec_dot_type         = type_traits_cpu[src0->type].vec_dot_type;
     ggml_from_float_t        const from_float           = type_traits_cpu[vec_dot_type].from_float;
@@ -1322,12 +1637,14 @@ static void ggml_compute_forward_mul_mat(
                                      src1->type,
                                      dst->type))
                     goto UseGgmlGemm1;
+        GGML_PROF_MATMUL_END();
         return;
     }
 UseGgmlGemm1:;
 #endif
 
-    if (src1->type != vec_dot_type) {
+    // consecutive mul_mats sharing src1 (e.g. Q/K/V, gate/up) convert it only once
+    if (src1->type != vec_dot_type && !ggml_cpu_wdata_has_src1(params, dst, ggml_cpu_wdata_layout(vec_dot_type, 0))) {
         char * wdata = params->wdata;
 
         const size_t nbw0 = ggml_type_size(vec_dot_type);
@@ -1394,6 +1711,7 @@ UseGgmlGemm1:;
                                      vec_dot_type,
                                      dst->type))
                     goto UseGgmlGemm2;
+        GGML_PROF_MATMUL_END();
         return;
     }
 UseGgmlGemm2:;
@@ -1422,7 +1740,12 @@ UseGgmlGemm2:;
     // If the chunking is poor for the number of threads on this setup, scrap the whole plan.  Re-chunk it by thread.
     //   Also, chunking by thread was measured to have perform better on NUMA systems.  See https://github.com/ggml-org/llama.cpp/pull/6915
     //   In theory, chunking should be just as useful on NUMA and non NUMA systems, but testing disagreed with that.
-    if (nchunk0 * nchunk1 < nth * 4 || ggml_is_numa()) {
+    //   With cores of different speed one chunk per thread makes everyone wait for the slowest core, so keep
+    //   several chunks per thread and let the fast cores claim the surplus.
+    if (nchunk0 * nchunk1 < nth * 4 && g_state.capacity.hybrid && !ggml_cpu_numa_static_chunks()) {
+        nchunk0 = nr0 > nr1 ? MIN(nr0, nth * 4) : 1;
+        nchunk1 = nr0 > nr1 ? 1 : MIN(nr1, nth * 4);
+    } else if (nchunk0 * nchunk1 < nth * 4 || ggml_cpu_numa_static_chunks()) {
         // distribute the thread work across the inner or outer loop based on which one is larger
         nchunk0 = nr0 > nr1 ? nth : 1; // parallelize by src0 rows
         nchunk1 = nr0 > nr1 ? 1 : nth; // parallelize by src1 rows
@@ -1462,28 +1785,7 @@ UseGgmlGemm2:;
         current_chunk = atomic_fetch_add_explicit(&params->threadpool->current_chunk, 1, memory_order_relaxed);
     }
 
-    // End profiling based on projection type
-    if (dst->name && dst->name[0] != '\0') {
-        if (strstr(dst->name, "q") || strstr(dst->name, "wq")) {
-            GGML_PROF_Q_PROJ_END();
-        } else if (strstr(dst->name, "k") || strstr(dst->name, "wk")) {
-            GGML_PROF_K_PROJ_END();
-        } else if (strstr(dst->name, "v") || strstr(dst->name, "wv")) {
-            GGML_PROF_V_PROJ_END();
-        } else if (strstr(dst->name, "o") || strstr(dst->name, "wo")) {
-            GGML_PROF_O_PROJ_END();
-        } else if (strstr(dst->name, "up") || strstr(dst->name, "w3")) {
-            GGML_PROF_UP_PROJ_END();
-        } else if (strstr(dst->name, "gate") || strstr(dst->name, "w1")) {
-            GGML_PROF_GATE_PROJ_END();
-        } else if (strstr(dst->name, "down") || strstr(dst->name, "w2")) {
-            GGML_PROF_DOWN_PROJ_END();
-        } else {
-            GGML_PROF_MUL_MAT_END();
-        }
-    } else {
-        GGML_PROF_MUL_MAT_END();
-    }
+    GGML_PROF_MATMUL_END();
 }
 
 // ggml_compute_forward_mul_mat_id
@@ -1566,7 +1868,7 @@ static void * incr_ptr_aligned(void ** p, size_t size, size_t align) {
     return ptr;
 }
 
-static void ggml_compute_forward_mul_mat_id(
+void ggml_compute_forward_mul_mat_id(
         const struct ggml_compute_params * params,
               struct ggml_tensor * dst) {
 
@@ -1707,7 +2009,7 @@ static void ggml_compute_forward_mul_mat_id(
         const bool disable_chunking = true;
 #else
         // disable for NUMA
-        const bool disable_chunking = ggml_is_numa();
+        const bool disable_chunking = ggml_cpu_numa_static_chunks();
 #endif // defined(__aarch64__)
 
         int64_t nchunk0 = (nr0 + chunk_size - 1) / chunk_size;
@@ -1759,6 +2061,8 @@ static void ggml_compute_forward(struct ggml_compute_params * params, struct ggm
         return;
     }
 
+    GGML_PROF_SET_NODE(tensor);
+
     // extra_buffer op?
     if (ggml_cpu_extra_compute_forward(params, tensor)) {
         return;
@@ -2129,6 +2433,7 @@ static void set_numa_thread_affinity(int thread_n) {
 
     switch(g_state.numa.numa_strategy) {
         case GGML_NUMA_STRATEGY_DISTRIBUTE:
+        case GGML_NUMA_STRATEGY_MIRROR:
             // run thread on node_num thread_n / (threads per node)
             node_num = thread_n % g_state.numa.n_nodes;
             break;
@@ -2665,6 +2970,8 @@ void ggml_threadpool_free(struct ggml_threadpool* threadpool) {
 
     const size_t workers_size = sizeof(struct ggml_compute_state) * n_threads;
     ggml_aligned_free(threadpool->workers, workers_size);
+    ggml_aligned_free(threadpool->barrier_tree, sizeof(struct ggml_barrier_node) * n_threads);
+    ggml_aligned_free(threadpool->branch_queues, sizeof(struct ggml_branch_queue) * n_threads);
     ggml_aligned_free(threadpool, sizeof(struct ggml_threadpool));
 }
 
@@ -2683,6 +2990,21 @@ static void ggml_threadpool_resume_locked(struct ggml_threadpool * threadpool) {
 }
 #endif
 
+void ggml_threadpool_get_wait_time(struct ggml_threadpool * threadpool, int64_t * t_poll_us, int64_t * t_sleep_us) {
+    *t_poll_us  = 0;
+    *t_sleep_us = 0;
+
+#ifndef GGML_USE_OPENMP
+    // the main thread does not wait for work
+    for (int j = 1; j < threadpool->n_threads_max; j++) {
+        *t_poll_us  += threadpool->workers[j].t_poll_us;
+        *t_sleep_us += threadpool->workers[j].t_sleep_us;
+    }
+#else
+    UNUSED(threadpool);
+#endif
+}
+
 void ggml_threadpool_pause(struct ggml_threadpool * threadpool) {
 #ifndef GGML_USE_OPENMP
     ggml_mutex_lock(&threadpool->mutex);
@@ -2707,6 +3029,177 @@ void ggml_threadpool_resume(struct ggml_threadpool * threadpool) {
 #endif
 }
 
+// size of the work buffer needed by a single node
+static size_t ggml_graph_node_work_size(const struct ggml_tensor * node, int n_threads, int n_tasks) {
+    size_t cur = 0;
+
+    if (!ggml_cpu_extra_work_size(n_threads, node, &cur)) {
+        switch (node->op) {
+            case GGML_OP_CPY:
+            case GGML_OP_DUP:
+                {
+                    if (ggml_is_quantized(node->type) ||
+                        // F16 -> BF16 and BF16 -> F16 copies go through intermediate F32
+                        (node->src[0]->type == GGML_TYPE_F16  && node->src[1] && node->src[1]->type == GGML_TYPE_BF16) ||
+                        (node->src[0]->type == GGML_TYPE_BF16 && node->src[1] && node->src[1]->type == GGML_TYPE_F16)) {
+                        cur = ggml_type_size(GGML_TYPE_F32) * node->ne[0] * n_tasks;
+                    }
+                } break;
+            case GGML_OP_ADD:
+            case GGML_OP_ADD1:
+                {
+                    if (ggml_is_quantized(node->src[0]->type)) {
+                        cur = ggml_type_size(GGML_TYPE_F32) * node->src[0]->ne[0] * n_tasks;
+                    }
+                } break;
+            case GGML_OP_ACC:
+                {
+                    if (ggml_is_quantized(node->src[0]->type)) {
+                        cur = ggml_type_size(GGML_TYPE_F32) * node->src[1]->ne[0] * n_tasks;
+                    }
+                } break;
+            case GGML_OP_COUNT_EQUAL:
+                {
+                    cur = ggml_type_size(node->type)*n_tasks;
+                } break;
+            case GGML_OP_MUL_MAT:
+                {
+                    const enum ggml_type vec_dot_type = type_traits_cpu[node->src[0]->type].vec_dot_type;
+
+                    if (node->src[1]->type != vec_dot_type) {
+                        cur = ggml_row_size(vec_dot_type, ggml_nelements(node->src[1]));
+                    }
+                } break;
+            case GGML_OP_MUL_MAT_ID:
+                {
+                    cur = 0;
+                    const struct ggml_tensor * src0 = node->src[0];
+                    const struct ggml_tensor * src1 = node->src[1];
+                    const struct ggml_tensor * ids = node->src[2];
+                    const enum ggml_type vec_dot_type = type_traits_cpu[src0->type].vec_dot_type;
+                    const int n_as = src0->ne[2];
+                    // src1
+                    if (src1->type != vec_dot_type) {
+                        cur += ggml_row_size(vec_dot_type, ggml_nelements(src1)) + sizeof(int64_t);
+                    }
+                    // matrix_row_counts
+                    cur += n_as * sizeof(int64_t) + sizeof(int64_t);
+                    // matrix_rows
+                    cur += n_as*ids->ne[0]*ids->ne[1]*sizeof(struct mmid_row_mapping) + sizeof(int64_t);
+                    // atomic_current_chunk
+                    cur += CACHE_LINE_SIZE*n_as + CACHE_LINE_SIZE;
+                } break;
+            case GGML_OP_OUT_PROD:
+                {
+                    if (ggml_is_quantized(node->src[0]->type)) {
+                        cur = ggml_type_size(GGML_TYPE_F32) * node->src[0]->ne[0] * n_tasks;
+                    }
+                } break;
+            case GGML_OP_SOFT_MAX:
+            case GGML_OP_ROPE:
+            case GGML_OP_ROPE_BACK:
+                {
+                    cur = ggml_type_size(GGML_TYPE_F32) * node->ne[0] * n_tasks;
+                } break;
+            case GGML_OP_CONV_TRANSPOSE_1D:
+                {
+                    GGML_ASSERT(node->src[0]->ne[3] == 1);
+                    GGML_ASSERT(node->src[1]->ne[2] == 1);
+                    GGML_ASSERT(node->src[1]->ne[3] == 1);
+
+                    const int64_t ne00 = node->src[0]->ne[0];  // K
+                    const int64_t ne01 = node->src[0]->ne[1];  // Cout
+                    const int64_t ne02 = node->src[0]->ne[2];  // Cin
+                    const int64_t ne10 = node->src[1]->ne[0];  // L
+                    const int64_t ne11 = node->src[1]->ne[1];  // Cin
+
+                    if ((node->src[0]->type == GGML_TYPE_F16 ||
+                         node->src[0]->type == GGML_TYPE_BF16) &&
+                        node->src[1]->type == GGML_TYPE_F32) {
+                        cur += sizeof(ggml_fp16_t)*ne00*ne01*ne02;
+                        cur += sizeof(ggml_fp16_t)*ne10*ne11;
+                    } else if (node->src[0]->type == GGML_TYPE_F32 &&
+                               node->src[1]->type == GGML_TYPE_F32) {
+                        cur += sizeof(float)*ne00*ne01*ne02;
+                        cur += sizeof(float)*ne10*ne11;
+                    } else {
+                        GGML_ABORT("fatal error");
+                    }
+                } break;
+            case GGML_OP_CONV_TRANSPOSE_2D:
+                {
+                    const int64_t ne00 = node->src[0]->ne[0]; // W
+                    const int64_t ne01 = node->src[0]->ne[1]; // H
+                    const int64_t ne02 = node->src[0]->ne[2]; // Channels Out
+                    const int64_t ne03 = node->src[0]->ne[3]; // Channels In
+
+                    const int64_t ne10 = node->src[1]->ne[0]; // W
+                    const int64_t ne11 = node->src[1]->ne[1]; // H
+                    const int64_t ne12 = node->src[1]->ne[2]; // Channels In
+
+                    cur += sizeof(ggml_fp16_t)*ne00*ne01*ne02*ne03;
+                    cur += sizeof(ggml_fp16_t)*ne10*ne11*ne12;
+                } break;
+            case GGML_OP_FLASH_ATTN_EXT:
+                {
+                    const int64_t ne10 = node->src[1]->ne[0]; // DK
+                    const int64_t ne20 = node->src[2]->ne[0]; // DV
+
+                    cur = sizeof(float)*(1*ne10 + 2*ne20)*n_tasks; // 1x head size K + 2x head size V (per thread)
+
+                    if (node->src[0]->ne[1] > 1) {
+                        // tiled: Q and VKQ rows of a tile, the KQ tile, the max and sum of each row and a V row (per thread)
+                        cur = MAX(cur, sizeof(float)*(GGML_FA_TILE_Q*(ne10 + ne20 + GGML_FA_TILE_KV + 2) + ne20)*n_tasks);
+                    } else {
+                        // split KV: max, sum and head size V for each split of each row
+                        const int64_t n_split = ggml_flash_attn_ext_n_kv_split(node, n_tasks);
+                        if (n_split > 1) {
+                            cur += sizeof(float)*(ne20 + 2)*ggml_nrows(node->src[0])*n_split;
+                        }
+                    }
+                } break;
+            case GGML_OP_FLASH_ATTN_BACK:
+                {
+                    const int64_t    D = node->src[0]->ne[0];
+                    const int64_t ne11 = ggml_up(node->src[1]->ne[1], GGML_SOFT_MAX_UNROLL);
+                    const int64_t mxDn = MAX(D, ne11) * 2; // *2 because of S and SM in ggml_compute_forward_flash_attn_back
+                    if (node->src[1]->type == GGML_TYPE_F32) {
+                        cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
+                        cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
+                    } else if (node->src[1]->type == GGML_TYPE_F16) {
+                        cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
+                        cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
+                    } else if (node->src[1]->type == GGML_TYPE_BF16) {
+                        cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
+                        cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
+                    }
+                } break;
+
+            case GGML_OP_CROSS_ENTROPY_LOSS:
+                {
+                    cur = ggml_type_size(node->type)*(n_tasks + node->src[0]->ne[0]*n_tasks);
+                } break;
+            case GGML_OP_COUNT:
+                {
+                    GGML_ABORT("fatal error");
+                }
+            default:
+                break;
+        }
+    }
+
+    return cur;
+}
+
+static int    ggml_graph_node_n_fused (const struct ggml_cgraph * cgraph, int node_n);
+static int    ggml_graph_node_n_branch(const struct ggml_cgraph * cgraph, int node_n);
+static size_t ggml_graph_branch_work_size(struct ggml_tensor * const * nodes, int n_branch, int n_threads);
+
+// size of the schedule at the end of the work buffer
+static size_t ggml_graph_sched_size(const struct ggml_cgraph * cgraph) {
+    return GGML_PAD(cgraph->n_nodes*sizeof(struct ggml_graph_sched_node), CACHE_LINE_SIZE);
+}
+
 struct ggml_cplan ggml_graph_plan(
           const struct ggml_cgraph * cgraph,
                                int   n_threads,
@@ -2734,159 +3227,31 @@ struct ggml_cplan ggml_graph_plan(
 
         max_tasks = MAX(max_tasks, n_tasks);
 
-        size_t cur = 0;
-
-        if (!ggml_cpu_extra_work_size(n_threads, node, &cur)) {
-            switch (node->op) {
-                case GGML_OP_CPY:
-                case GGML_OP_DUP:
-                    {
-                        if (ggml_is_quantized(node->type) ||
-                            // F16 -> BF16 and BF16 -> F16 copies go through intermediate F32
-                            (node->src[0]->type == GGML_TYPE_F16  && node->src[1] && node->src[1]->type == GGML_TYPE_BF16) ||
-                            (node->src[0]->type == GGML_TYPE_BF16 && node->src[1] && node->src[1]->type == GGML_TYPE_F16)) {
-                            cur = ggml_type_size(GGML_TYPE_F32) * node->ne[0] * n_tasks;
-                        }
-                    } break;
-                case GGML_OP_ADD:
-                case GGML_OP_ADD1:
-                    {
-                        if (ggml_is_quantized(node->src[0]->type)) {
-                            cur = ggml_type_size(GGML_TYPE_F32) * node->src[0]->ne[0] * n_tasks;
-                        }
-                    } break;
-                case GGML_OP_ACC:
-                    {
-                        if (ggml_is_quantized(node->src[0]->type)) {
-                            cur = ggml_type_size(GGML_TYPE_F32) * node->src[1]->ne[0] * n_tasks;
-                        }
-                    } break;
-                case GGML_OP_COUNT_EQUAL:
-                    {
-                        cur = ggml_type_size(node->type)*n_tasks;
-                    } break;
-                case GGML_OP_MUL_MAT:
-                    {
-                        const enum ggml_type vec_dot_type = type_traits_cpu[node->src[0]->type].vec_dot_type;
-
-                        if (node->src[1]->type != vec_dot_type) {
-                            cur = ggml_row_size(vec_dot_type, ggml_nelements(node->src[1]));
-                        }
-                    } break;
-                case GGML_OP_MUL_MAT_ID:
-                    {
-                        cur = 0;
-                        const struct ggml_tensor * src0 = node->src[0];
-                        const struct ggml_tensor * src1 = node->src[1];
-                        const struct ggml_tensor * ids = node->src[2];
-                        const enum ggml_type vec_dot_type = type_traits_cpu[src0->type].vec_dot_type;
-                        const int n_as = src0->ne[2];
-                        // src1
-                        if (src1->type != vec_dot_type) {
-                            cur += ggml_row_size(vec_dot_type, ggml_nelements(src1)) + sizeof(int64_t);
-                        }
-                        // matrix_row_counts
-                        cur += n_as * sizeof(int64_t) + sizeof(int64_t);
-                        // matrix_rows
-                        cur += n_as*ids->ne[0]*ids->ne[1]*sizeof(struct mmid_row_mapping) + sizeof(int64_t);
-                        // atomic_current_chunk
-                        cur += CACHE_LINE_SIZE*n_as + CACHE_LINE_SIZE;
-                    } break;
-                case GGML_OP_OUT_PROD:
-                    {
-                        if (ggml_is_quantized(node->src[0]->type)) {
-                            cur = ggml_type_size(GGML_TYPE_F32) * node->src[0]->ne[0] * n_tasks;
-                        }
-                    } break;
-                case GGML_OP_SOFT_MAX:
-                case GGML_OP_ROPE:
-                case GGML_OP_ROPE_BACK:
-                    {
-                        cur = ggml_type_size(GGML_TYPE_F32) * node->ne[0] * n_tasks;
-                    } break;
-                case GGML_OP_CONV_TRANSPOSE_1D:
-                    {
-                        GGML_ASSERT(node->src[0]->ne[3] == 1);
-                        GGML_ASSERT(node->src[1]->ne[2] == 1);
-                        GGML_ASSERT(node->src[1]->ne[3] == 1);
-
-                        const int64_t ne00 = node->src[0]->ne[0];  // K
-                        const int64_t ne01 = node->src[0]->ne[1];  // Cout
-                        const int64_t ne02 = node->src[0]->ne[2];  // Cin
-                        const int64_t ne10 = node->src[1]->ne[0];  // L
-                        const int64_t ne11 = node->src[1]->ne[1];  // Cin
-
-                        if ((node->src[0]->type == GGML_TYPE_F16 ||
-                             node->src[0]->type == GGML_TYPE_BF16) &&
-                            node->src[1]->type == GGML_TYPE_F32) {
-                            cur += sizeof(ggml_fp16_t)*ne00*ne01*ne02;
-                            cur += sizeof(ggml_fp16_t)*ne10*ne11;
-                        } else if (node->src[0]->type == GGML_TYPE_F32 &&
-                                   node->src[1]->type == GGML_TYPE_F32) {
-                            cur += sizeof(float)*ne00*ne01*ne02;
-                            cur += sizeof(float)*ne10*ne11;
-                        } else {
-                            GGML_ABORT("fatal error");
-                        }
-                    } break;
-                case GGML_OP_CONV_TRANSPOSE_2D:
-                    {
-                        const int64_t ne00 = node->src[0]->ne[0]; // W
-                        const int64_t ne01 = node->src[0]->ne[1]; // H
-                        const int64_t ne02 = node->src[0]->ne[2]; // Channels Out
-                        const int64_t ne03 = node->src[0]->ne[3]; // Channels In
-
-                        const int64_t ne10 = node->src[1]->ne[0]; // W
-                        const int64_t ne11 = node->src[1]->ne[1]; // H
-                        const int64_t ne12 = node->src[1]->ne[2]; // Channels In
+        const size_t cur = ggml_graph_node_work_size(node, n_threads, n_tasks);
 
-                        cur += sizeof(ggml_fp16_t)*ne00*ne01*ne02*ne03;
-                        cur += sizeof(ggml_fp16_t)*ne10*ne11*ne12;
-                    } break;
-                case GGML_OP_FLASH_ATTN_EXT:
-                    {
-                        const int64_t ne10 = node->src[1]->ne[0]; // DK
-                        const int64_t ne20 = node->src[2]->ne[0]; // DV
+        work_size = MAX(work_size, cur);
+    }
 
-                        cur = sizeof(float)*(1*ne10 + 2*ne20)*n_tasks; // 1x head size K + 2x head size V (per thread)
-                    } break;
-                case GGML_OP_FLASH_ATTN_BACK:
-                    {
-                        const int64_t    D = node->src[0]->ne[0];
-                        const int64_t ne11 = ggml_up(node->src[1]->ne[1], GGML_SOFT_MAX_UNROLL);
-                        const int64_t mxDn = MAX(D, ne11) * 2; // *2 because of S and SM in ggml_compute_forward_flash_attn_back
-                        if (node->src[1]->type == GGML_TYPE_F32) {
-                            cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
-                            cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
-                        } else if (node->src[1]->type == GGML_TYPE_F16) {
-                            cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
-                            cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
-                        } else if (node->src[1]->type == GGML_TYPE_BF16) {
-                            cur  = sizeof(float)*mxDn*n_tasks; // TODO: this can become (n_tasks-1)
-                            cur += sizeof(float)*mxDn*n_tasks; // this is overestimated by x2
-                        }
-                    } break;
+    // independent nodes that are computed concurrently each get their own part of the work buffer
+    if (n_threads > 1) {
+        for (int i = 0; i < cgraph->n_nodes; i++) {
+            const int n_fused  = ggml_graph_node_n_fused(cgraph, i);
+            const int n_branch = n_fused > 1 ? 1 : ggml_graph_node_n_branch(cgraph, i);
 
-                case GGML_OP_CROSS_ENTROPY_LOSS:
-                    {
-                        cur = ggml_type_size(node->type)*(n_tasks + node->src[0]->ne[0]*n_tasks);
-                    } break;
-                case GGML_OP_COUNT:
-                    {
-                        GGML_ABORT("fatal error");
-                    }
-                default:
-                    break;
+            if (n_branch > 1) {
+                work_size = MAX(work_size, ggml_graph_branch_work_size(cgraph->nodes + i, n_branch, n_threads));
             }
-        }
 
-        work_size = MAX(work_size, cur);
+            i += MAX(n_fused, n_branch) - 1;
+        }
     }
 
     if (work_size > 0) {
         work_size += CACHE_LINE_SIZE*(n_threads);
     }
 
+    work_size = GGML_PAD(work_size, CACHE_LINE_SIZE) + ggml_graph_sched_size(cgraph);
+
     cplan.threadpool = threadpool;
     cplan.n_threads  = MIN(max_tasks, n_threads);
     cplan.work_size  = work_size;
@@ -2895,40 +3260,538 @@ struct ggml_cplan ggml_graph_plan(
     return cplan;
 }
 
-static thread_ret_t ggml_graph_compute_thread(void * data) {
-    struct ggml_compute_state * state = (struct ggml_compute_state *) data;
-    struct ggml_threadpool    * tp    = state->threadpool;
-
-    const struct ggml_cgraph * cgraph = tp->cgraph;
-    const struct ggml_cplan  * cplan  = tp->cplan;
-
-    set_numa_thread_affinity(state->ith);
-
-    struct ggml_compute_params params = {
-        /*.ith       =*/ state->ith,
-        /*.nth       =*/ atomic_load_explicit(&tp->n_threads_cur, memory_order_relaxed),
-        /*.wsize     =*/ cplan->work_size,
-        /*.wdata     =*/ cplan->work_data,
-        /*.threadpool=*/ tp,
-    };
-
-    for (int node_n = 0; node_n < cgraph->n_nodes && atomic_load_explicit(&tp->abort, memory_order_relaxed) != node_n; node_n++) {
-        struct ggml_tensor * node = cgraph->nodes[node_n];
-
-        ggml_compute_forward(&params, node);
-
-        if (state->ith == 0 && cplan->abort_callback &&
-                cplan->abort_callback(cplan->abort_callback_data)) {
-            atomic_store_explicit(&tp->abort, node_n + 1, memory_order_relaxed);
-            tp->ec    = GGML_STATUS_ABORTED;
-        }
+// check if the src1 conversion a mul_mat left in wdata may no longer be valid after node
+static bool ggml_graph_node_clobbers_wdata_src1(const struct ggml_compute_params * params, struct ggml_tensor * node, int32_t flags) {
+    const struct ggml_tensor * src1 = params->wdata_src1;
 
-        if (node_n + 1 < cgraph->n_nodes) {
-            ggml_barrier(state->threadpool);
-        }
+    // node wrote into the memory of src1
+    if (node->data && src1->data &&
+        (const char *) node->data < (const char *) src1->data + ggml_nbytes(src1) &&
+        (const char *) src1->data < (const char *) node->data + ggml_nbytes(node)) {
+        return true;
     }
 
-    ggml_barrier(state->threadpool);
+    // any other node that asks for a work buffer may use it
+    return (flags & GGML_GRAPH_SCHED_WDATA) && node != params->wdata_owner;
+}
+
+// ops that split the rows of dst across threads like get_thread_range() and only
+// access the rows of their srcs with the same index as the dst row
+static bool ggml_graph_node_is_row_parallel(const struct ggml_tensor * node) {
+    switch (node->op) {
+        case GGML_OP_ADD:
+            return node->src[0]->type == GGML_TYPE_F32 ||
+                   node->src[0]->type == GGML_TYPE_F16 ||
+                   node->src[0]->type == GGML_TYPE_BF16;
+        case GGML_OP_SUB:
+        case GGML_OP_MUL:
+        case GGML_OP_DIV:
+        case GGML_OP_SQR:
+        case GGML_OP_SQRT:
+        case GGML_OP_LOG:
+        case GGML_OP_SIN:
+        case GGML_OP_COS:
+            return true;
+        case GGML_OP_UNARY:
+            switch (ggml_get_unary_op(node)) {
+                case GGML_UNARY_OP_ABS:
+                case GGML_UNARY_OP_SGN:
+                case GGML_UNARY_OP_NEG:
+                case GGML_UNARY_OP_STEP:
+                case GGML_UNARY_OP_TANH:
+                case GGML_UNARY_OP_ELU:
+                case GGML_UNARY_OP_RELU:
+                case GGML_UNARY_OP_SIGMOID:
+                case GGML_UNARY_OP_GELU:
+                case GGML_UNARY_OP_GELU_ERF:
+                case GGML_UNARY_OP_GELU_QUICK:
+                case GGML_UNARY_OP_SILU:
+                case GGML_UNARY_OP_HARDSWISH:
+                case GGML_UNARY_OP_HARDSIGMOID:
+                case GGML_UNARY_OP_EXP:
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+static bool ggml_graph_tensors_overlap(const struct ggml_tensor * a, const struct ggml_tensor * b) {
+    return a->data && b->data &&
+        (const char *) a->data < (const char *) b->data + ggml_nbytes(b) &&
+        (const char *) b->data < (const char *) a->data + ggml_nbytes(a);
+}
+
+// check that a and b either do not share memory, or are the same rows of the same memory
+static bool ggml_graph_tensors_rows_private(const struct ggml_tensor * a, const struct ggml_tensor * b) {
+    if (!ggml_graph_tensors_overlap(a, b)) {
+        return true;
+    }
+
+    return a->data == b->data && ggml_are_same_shape(a, b) && ggml_are_same_stride(a, b) &&
+           a->nb[2] == a->nb[1]*a->ne[1] && a->nb[3] == a->nb[2]*a->ne[2];
+}
+
+// check that no thread computing node can touch a row of prev computed by another thread
+static bool ggml_graph_nodes_rows_private(const struct ggml_tensor * prev, const struct ggml_tensor * node) {
+    if (!ggml_are_same_shape(prev, node) || !ggml_graph_tensors_rows_private(prev, node)) {
+        return false;
+    }
+
+    for (int i = 0; i < GGML_MAX_SRC; i++) {
+        // node reads what prev wrote
+        if (node->src[i] && !ggml_graph_tensors_rows_private(prev, node->src[i])) {
+            return false;
+        }
+        // node overwrites what prev read
+        if (prev->src[i] && !ggml_graph_tensors_rows_private(prev->src[i], node)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// op fusion
+//
+
+static bool ggml_graph_fuse_f32_rows(const struct ggml_tensor * t) {
+    return t->type == GGML_TYPE_F32 && t->nb[0] == sizeof(float);
+}
+
+// check if mul multiplies the rows of t with a tensor that is not written by the fused nodes
+static bool ggml_graph_fuse_is_mul_of(const struct ggml_tensor * mul, const struct ggml_tensor * t) {
+    if (mul->op != GGML_OP_MUL || (mul->src[0] != t && mul->src[1] != t)) {
+        return false;
+    }
+
+    const struct ggml_tensor * w = mul->src[0] == t ? mul->src[1] : mul->src[0];
+
+    return ggml_graph_fuse_f32_rows(mul) && ggml_graph_fuse_f32_rows(w) &&
+           w->ne[0] == t->ne[0] && ggml_can_repeat(w, t) && ggml_are_same_shape(mul, t) &&
+           !ggml_graph_tensors_overlap(w, t) && !ggml_graph_tensors_overlap(w, mul);
+}
+
+// number of nodes from node_n on that are computed by a single fused kernel, 1 if none
+static int ggml_graph_node_n_fused(const struct ggml_cgraph * cgraph, int node_n) {
+    if (node_n + 1 >= cgraph->n_nodes) {
+        return 1;
+    }
+
+    const struct ggml_tensor * node = cgraph->nodes[node_n];
+    const struct ggml_tensor * next = cgraph->nodes[node_n + 1];
+
+    if (ggml_is_empty(node) || !ggml_graph_fuse_f32_rows(node) || !ggml_graph_fuse_f32_rows(node->src[0]) ||
+        !ggml_graph_tensors_rows_private(node->src[0], node)) {
+        return 1;
+    }
+
+    int n_fused = 1;
+
+    switch (node->op) {
+        case GGML_OP_ADD:
+            {
+                // residual add followed by the norm of the next block, and its weight
+                const struct ggml_tensor * b = node->src[1];
+                if (next->op != GGML_OP_RMS_NORM || next->src[0] != node || !ggml_graph_fuse_f32_rows(next) ||
+                    !ggml_graph_fuse_f32_rows(b) || b->ne[0] != node->ne[0] || ggml_graph_tensors_overlap(b, node)) {
+                    break;
+                }
+                n_fused = 2;
+                if (node_n + 2 < cgraph->n_nodes && ggml_graph_fuse_is_mul_of(cgraph->nodes[node_n + 2], next)) {
+                    n_fused = 3;
+                }
+            } break;
+        case GGML_OP_RMS_NORM:
+            {
+                if (ggml_graph_fuse_is_mul_of(next, node)) {
+                    n_fused = 2;
+                }
+            } break;
+        case GGML_OP_UNARY:
+            {
+                if (ggml_get_unary_op(node) == GGML_UNARY_OP_SILU && ggml_graph_fuse_is_mul_of(next, node)) {
+                    n_fused = 2;
+                }
+            } break;
+        default:
+            break;
+    }
+
+    // each row is carried through all the fused nodes by one thread
+    for (int i = 0; i < n_fused; i++) {
+        for (int j = i + 1; j < n_fused; j++) {
+            if (!ggml_graph_nodes_rows_private(cgraph->nodes[node_n + i], cgraph->nodes[node_n + j])) {
+                return 1;
+            }
+        }
+    }
+
+    return n_fused;
+}
+
+static void ggml_compute_forward_fused(const struct ggml_compute_params * params, struct ggml_tensor ** nodes, int n_fused) {
+    switch (nodes[0]->op) {
+        case GGML_OP_ADD:
+            {
+                ggml_compute_forward_add_rms_norm_mul(params, nodes[0], nodes[1], n_fused > 2 ? nodes[2] : NULL);
+            } break;
+        case GGML_OP_RMS_NORM:
+            {
+                ggml_compute_forward_add_rms_norm_mul(params, NULL, nodes[0], nodes[1]);
+            } break;
+        case GGML_OP_UNARY:
+            {
+                ggml_compute_forward_silu_mul(params, nodes[0], nodes[1]);
+            } break;
+        default:
+            GGML_ABORT("fatal error");
+    }
+}
+
+static bool ggml_graph_node_is_noop(const struct ggml_tensor * node) {
+    switch (node->op) {
+        case GGML_OP_NONE:
+        case GGML_OP_RESHAPE:
+        case GGML_OP_VIEW:
+        case GGML_OP_PERMUTE:
+        case GGML_OP_TRANSPOSE:
+            return true;
+        default:
+            return ggml_is_empty(node);
+    }
+}
+
+//
+// concurrent branches
+//
+// Consecutive nodes that do not depend on each other (e.g. the rope of Q and K, or the
+// copies of K and V into the cache) are computed as one group without barriers in between.
+// Every node is split in nth chunks as usual; the chunks of thread ith form its task queue,
+// and threads that run out of work steal chunks from the queues of the others.
+//
+
+// ops that split their work by ith/nth, with no barrier and no state shared between
+// the threads other than their own part of wdata
+static bool ggml_graph_node_is_branch_safe(const struct ggml_tensor * node) {
+    switch (node->op) {
+        case GGML_OP_DUP:
+        case GGML_OP_CPY:
+        case GGML_OP_CONT:
+        case GGML_OP_ADD:
+        case GGML_OP_SUB:
+        case GGML_OP_MUL:
+        case GGML_OP_DIV:
+        case GGML_OP_SCALE:
+        case GGML_OP_SQR:
+        case GGML_OP_SQRT:
+        case GGML_OP_LOG:
+        case GGML_OP_SIN:
+        case GGML_OP_COS:
+        case GGML_OP_CLAMP:
+        case GGML_OP_UNARY:
+        case GGML_OP_NORM:
+        case GGML_OP_RMS_NORM:
+        case GGML_OP_L2_NORM:
+        case GGML_OP_ROPE:
+        case GGML_OP_SOFT_MAX:
+        case GGML_OP_GET_ROWS:
+        case GGML_OP_CONCAT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// check that b does not access what a writes, and does not overwrite what a reads
+static bool ggml_graph_nodes_independent(const struct ggml_tensor * a, const struct ggml_tensor * b) {
+    if (ggml_graph_tensors_overlap(a, b)) {
+        return false;
+    }
+
+    for (int i = 0; i < GGML_MAX_SRC; i++) {
+        if (b->src[i] && ggml_graph_tensors_overlap(a, b->src[i])) {
+            return false;
+        }
+        if (a->src[i] && ggml_graph_tensors_overlap(a->src[i], b)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// number of nodes from node_n on that are computed as one group of branches, 1 if none
+static int ggml_graph_node_n_branch(const struct ggml_cgraph * cgraph, int node_n) {
+    // the task queues are reset before the barrier that precedes a group
+    if (node_n == 0 || ggml_graph_node_n_fused(cgraph, node_n) > 1) {
+        return 1;
+    }
+
+    const struct ggml_tensor * group[GGML_BRANCH_MAX_NODES];
+
+    int n_group  = 0;
+    int n_branch = 1;
+
+    for (int i = node_n; i < cgraph->n_nodes && i < node_n + GGML_BRANCH_MAX_SCAN; i++) {
+        const struct ggml_tensor * node = cgraph->nodes[i];
+
+        if (ggml_graph_node_is_noop(node)) {
+            if (n_group == 0) {
+                return 1;
+            }
+            continue;
+        }
+
+        if (n_group == GGML_BRANCH_MAX_NODES || !ggml_graph_node_is_branch_safe(node) ||
+            (i > node_n && ggml_graph_node_n_fused(cgraph, i) > 1)) {
+            break;
+        }
+
+        bool independent = true;
+        for (int j = 0; j < n_group && independent; j++) {
+            independent = ggml_graph_nodes_independent(group[j], node);
+        }
+        if (!independent) {
+            break;
+        }
+
+        group[n_group++] = node;
+        n_branch = i - node_n + 1;
+    }
+
+    return n_group > 1 ? n_branch : 1;
+}
+
+// part of the work buffer used by a node of a group
+static size_t ggml_graph_branch_node_work_size(struct ggml_tensor * node, int n_threads) {
+    const size_t cur = ggml_graph_node_work_size(node, n_threads, ggml_get_n_tasks(node, n_threads));
+
+    return cur > 0 ? GGML_PAD(cur + CACHE_LINE_SIZE*n_threads, CACHE_LINE_SIZE) : 0;
+}
+
+static size_t ggml_graph_branch_work_size(struct ggml_tensor * const * nodes, int n_branch, int n_threads) {
+    size_t size = 0;
+
+    for (int i = 0; i < n_branch; i++) {
+        if (!ggml_graph_node_is_noop(nodes[i])) {
+            size += ggml_graph_branch_node_work_size(nodes[i], n_threads);
+        }
+    }
+
+    return size;
+}
+
+static int ggml_branch_queue_tag(int node_n) {
+    return node_n & GGML_BRANCH_QUEUE_TAG_MASK;
+}
+
+static void ggml_branch_queue_reset(struct ggml_branch_queue * queue, int tag) {
+    atomic_store_explicit(&queue->state, tag << GGML_BRANCH_QUEUE_TAG_SHIFT, memory_order_relaxed);
+}
+
+// take the next task of the group tagged tag from the queue, -1 if there is none left
+static int ggml_branch_queue_take(struct ggml_branch_queue * queue, int tag, int n_group) {
+    int state = atomic_load_explicit(&queue->state, memory_order_relaxed);
+
+    for (;;) {
+        const int k = state & GGML_BRANCH_QUEUE_N_MASK;
+
+        // the owner has already reset the queue for a later group
+        if ((state >> GGML_BRANCH_QUEUE_TAG_SHIFT) != tag || k >= n_group) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(&queue->state, &state, state + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+            return k;
+        }
+    }
+}
+
+// the group starts at nodes[0], which is node node_n of the graph
+static void ggml_graph_compute_branches(const struct ggml_compute_params * params, struct ggml_tensor * const * nodes, int n_branch, int node_n) {
+    const int tag = ggml_branch_queue_tag(node_n);
+
+    struct ggml_tensor * group[GGML_BRANCH_MAX_NODES];
+    size_t               offs [GGML_BRANCH_MAX_NODES];
+
+    int    n_group = 0;
+    size_t off     = 0;
+
+    for (int i = 0; i < n_branch; i++) {
+        if (ggml_graph_node_is_noop(nodes[i])) {
+            continue;
+        }
+        group[n_group] = nodes[i];
+        offs [n_group] = off;
+        off += ggml_graph_branch_node_work_size(nodes[i], params->nth);
+        n_group++;
+    }
+
+    struct ggml_branch_queue * queues = params->threadpool->branch_queues;
+
+    // own queue first, then steal from the following threads
+    for (int i = 0; i < params->nth; i++) {
+        const int q = (params->ith + i) % params->nth;
+
+        for (;;) {
+            const int k = ggml_branch_queue_take(&queues[q], tag, n_group);
+            if (k < 0) {
+                break;
+            }
+
+            struct ggml_compute_params p = *params;
+            p.ith   = q;
+            p.wdata = (char *) params->wdata + offs[k];
+            p.wsize = params->wsize - offs[k];
+
+            ggml_compute_forward(&p, group[k]);
+        }
+    }
+}
+
+// check if the barrier before node can be skipped, given that the last barrier was before node_sync
+static bool ggml_graph_node_skip_barrier(const struct ggml_cgraph * cgraph, int node_sync, int node_n) {
+    const struct ggml_tensor * node = cgraph->nodes[node_n];
+
+    if (ggml_graph_node_is_noop(node)) {
+        return true;
+    }
+
+    // fused kernels may read rows of the following nodes' srcs from other threads
+    if (!ggml_graph_node_is_row_parallel(node) || ggml_graph_node_n_fused(cgraph, node_n) > 1) {
+        return false;
+    }
+
+    // every thread gets the same rows in all of these nodes, so each one only
+    // depends on its own results from the nodes since the last barrier
+    for (int i = node_sync; i < node_n; i++) {
+        const struct ggml_tensor * prev = cgraph->nodes[i];
+        if (!ggml_graph_node_is_row_parallel(prev) || !ggml_graph_nodes_rows_private(prev, node)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// decide once how the nodes are computed: fused nodes, groups of branches and the barriers between steps
+static void ggml_graph_sched_init(const struct ggml_cgraph * cgraph, struct ggml_graph_sched_node * sched, int n_threads) {
+    // independent nodes are computed concurrently
+    const bool branches = n_threads > 1;
+
+    for (int i = 0; i < cgraph->n_nodes; i++) {
+        struct ggml_tensor * node = cgraph->nodes[i];
+
+        sched[i].n_run = 1;
+        sched[i].flags = 0;
+
+        if (node->op != GGML_OP_NONE && !ggml_is_empty(node) &&
+            ggml_graph_node_work_size(node, n_threads, ggml_get_n_tasks(node, n_threads)) > 0) {
+            sched[i].flags |= GGML_GRAPH_SCHED_WDATA;
+        }
+    }
+
+    int node_sync = 0; // first node after the last barrier
+
+    for (int node_n = 0; node_n < cgraph->n_nodes; node_n += sched[node_n].n_run) {
+        const int n_branch = branches ? ggml_graph_node_n_branch(cgraph, node_n) : 1;
+
+        if (n_branch > 1) {
+            sched[node_n].n_run  = n_branch;
+            sched[node_n].flags |= GGML_GRAPH_SCHED_BRANCH;
+        } else {
+            sched[node_n].n_run  = ggml_graph_node_n_fused(cgraph, node_n);
+        }
+
+        const int node_next = node_n + sched[node_n].n_run;
+        if (node_next >= cgraph->n_nodes) {
+            break;
+        }
+
+        // chunks of a group may have been computed by any thread
+        if (n_branch > 1 || (branches && ggml_graph_node_n_branch(cgraph, node_next) > 1) ||
+            !ggml_graph_node_skip_barrier(cgraph, node_sync, node_next)) {
+            sched[node_n].flags |= GGML_GRAPH_SCHED_BARRIER;
+            node_sync = node_next;
+        }
+    }
+}
+
+static thread_ret_t ggml_graph_compute_thread(void * data) {
+    struct ggml_compute_state * state = (struct ggml_compute_state *) data;
+    struct ggml_threadpool    * tp    = state->threadpool;
+
+    const struct ggml_cgraph * cgraph = tp->cgraph;
+    const struct ggml_cplan  * cplan  = tp->cplan;
+
+    set_numa_thread_affinity(state->ith);
+
+    struct ggml_compute_params params = {
+        /*.ith       =*/ state->ith,
+        /*.nth       =*/ atomic_load_explicit(&tp->n_threads_cur, memory_order_relaxed),
+        /*.wsize     =*/ cplan->work_size - ggml_graph_sched_size(cgraph),
+        /*.wdata     =*/ cplan->work_data,
+        /*.threadpool=*/ tp,
+        /*.wdata_src1=*/ NULL,
+        /*.wdata_owner=*/ NULL,
+        /*.wdata_layout=*/ 0,
+    };
+
+    const struct ggml_graph_sched_node * sched = cplan->sched;
+
+    // threads that skip a barrier could miss an abort and fall out of step
+    const bool skip_barriers = cplan->abort_callback == NULL;
+
+    for (int node_n = 0; node_n < cgraph->n_nodes && atomic_load_explicit(&tp->abort, memory_order_relaxed) != node_n; node_n++) {
+        struct ggml_tensor * node = cgraph->nodes[node_n];
+
+        const uint64_t t_prof_start = ggml_prof_node_begin();
+
+        // fused nodes and groups of branches are profiled as their first node
+        const struct ggml_graph_sched_node step = sched[node_n];
+
+        if (step.flags & GGML_GRAPH_SCHED_BRANCH) {
+            ggml_graph_compute_branches(&params, cgraph->nodes + node_n, step.n_run, node_n);
+        } else if (step.n_run > 1) {
+            ggml_compute_forward_fused(&params, cgraph->nodes + node_n, step.n_run);
+        } else {
+            ggml_compute_forward(&params, node);
+        }
+
+        for (int i = 0; i < step.n_run; i++) {
+            if (params.wdata_src1 && ggml_graph_node_clobbers_wdata_src1(&params, cgraph->nodes[node_n + i], sched[node_n + i].flags)) {
+                params.wdata_src1 = NULL;
+            }
+        }
+
+        node_n += step.n_run - 1;
+
+        const uint64_t t_prof_busy = ggml_prof_node_busy_end(t_prof_start);
+
+        if (state->ith == 0 && cplan->abort_callback &&
+                cplan->abort_callback(cplan->abort_callback_data)) {
+            atomic_store_explicit(&tp->abort, node_n + 1, memory_order_relaxed);
+            tp->ec    = GGML_STATUS_ABORTED;
+        }
+
+        if (node_n + 1 < cgraph->n_nodes) {
+            if (sched[node_n + 1].flags & GGML_GRAPH_SCHED_BRANCH) {
+                ggml_branch_queue_reset(&tp->branch_queues[state->ith], ggml_branch_queue_tag(node_n + 1));
+            }
+
+            if ((step.flags & GGML_GRAPH_SCHED_BARRIER) || !skip_barriers) {
+                ggml_barrier_ith(state->threadpool, state->ith);
+            }
+        }
+
+        ggml_prof_node_end(node, state->ith, t_prof_start, t_prof_busy);
+    }
+
+    ggml_barrier_ith(state->threadpool, state->ith);
 
     return 0;
 }
@@ -2977,8 +3840,21 @@ static inline bool ggml_graph_compute_poll_for_work(struct ggml_compute_state *
         return state->pending;
     }
 
+    if (threadpool->poll == GGML_THREADPOOL_POLL_ADAPTIVE) {
+        const int64_t t_start = ggml_time_us();
+        const int64_t poll_us = atomic_load_explicit(&threadpool->poll_us, memory_order_relaxed);
+
+        for (uint64_t i = 0; poll_us > 0 && !ggml_graph_compute_thread_ready(state); i++) {
+            ggml_thread_cpu_relax();
+            if (i % 1024 == 1023 && ggml_time_us() - t_start >= poll_us) {
+                break;
+            }
+        }
+
+        return state->pending;
+    }
+
     // This seems to make 0 ... 100 a decent range for polling level across modern processors.
-    // Perhaps, we can adjust it dynamically based on load and things.
     const uint64_t n_rounds = 1024UL * 128 * threadpool->poll;
 
     for (uint64_t i=0; !ggml_graph_compute_thread_ready(state) && i < n_rounds; i++) {
@@ -2992,11 +3868,16 @@ static inline bool ggml_graph_compute_poll_for_work(struct ggml_compute_state *
 static inline bool ggml_graph_compute_check_for_work(struct ggml_compute_state * state) {
     struct ggml_threadpool * threadpool = state->threadpool;
 
+    const int64_t t_start = ggml_time_us();
+
     if (ggml_graph_compute_poll_for_work(state)) {
         ggml_graph_compute_thread_sync(state);
+        state->t_poll_us += ggml_time_us() - t_start;
         return state->pending;
     }
 
+    const int64_t t_sleep = ggml_time_us();
+
     ggml_mutex_lock_shared(&threadpool->mutex);
     while (!ggml_graph_compute_thread_ready(state)) {
         // No new work. Wait for the signal.
@@ -3005,6 +3886,12 @@ static inline bool ggml_graph_compute_check_for_work(struct ggml_compute_state *
     }
     ggml_mutex_unlock_shared(&threadpool->mutex);
 
+    if (state->pending) {
+        const int64_t t_end = ggml_time_us();
+        state->t_poll_us  += t_sleep - t_start;
+        state->t_sleep_us += t_end - t_sleep;
+    }
+
     return state->pending;
 }
 
@@ -3046,6 +3933,40 @@ static thread_ret_t ggml_graph_compute_secondary_thread(void* data) {
     return (thread_ret_t) 0;
 }
 
+// Adaptive polling: the workers poll for a bit longer than the typical (median) gap between
+// the recent graphs, so that back-to-back graphs such as decoding find them awake, while idle
+// periods between requests only cost that much polling before the workers sleep
+static void ggml_threadpool_update_poll(struct ggml_threadpool * threadpool) {
+    const int64_t t_now = ggml_time_us();
+
+    if (threadpool->t_graph_end > 0) {
+        threadpool->graph_gaps[threadpool->n_graph_gaps % GGML_THREADPOOL_POLL_N_GAPS] = t_now - threadpool->t_graph_end;
+        threadpool->n_graph_gaps++;
+    }
+
+    const int n_gaps = MIN(threadpool->n_graph_gaps, GGML_THREADPOOL_POLL_N_GAPS);
+
+    int64_t poll_us = GGML_THREADPOOL_POLL_MAX_US;
+
+    if (n_gaps > 0) {
+        int64_t gaps[GGML_THREADPOOL_POLL_N_GAPS];
+        memcpy(gaps, threadpool->graph_gaps, n_gaps*sizeof(int64_t));
+
+        // insertion sort, there are only a few
+        for (int i = 1; i < n_gaps; i++) {
+            for (int j = i; j > 0 && gaps[j - 1] > gaps[j]; j--) {
+                const int64_t tmp = gaps[j]; gaps[j] = gaps[j - 1]; gaps[j - 1] = tmp;
+            }
+        }
+
+        const int64_t gap = gaps[n_gaps/2];
+
+        poll_us = gap < GGML_THREADPOOL_POLL_MAX_US ? MIN(2*gap + 50, GGML_THREADPOOL_POLL_MAX_US) : 0;
+    }
+
+    atomic_store_explicit(&threadpool->poll_us, (int) poll_us, memory_order_relaxed);
+}
+
 // Start processing new graph
 static void ggml_graph_compute_kickoff(struct ggml_threadpool * threadpool, int n_threads)
 {
@@ -3058,6 +3979,10 @@ static void ggml_graph_compute_kickoff(struct ggml_threadpool * threadpool, int
     // Update the number of active threads
     atomic_store_explicit(&threadpool->n_threads_cur, n_threads, memory_order_relaxed);
 
+    if (threadpool->poll == GGML_THREADPOOL_POLL_ADAPTIVE) {
+        ggml_threadpool_update_poll(threadpool);
+    }
+
     // Indicate the graph is ready to be processed
     // We need the full seq-cst fence here because of the polling threads (used in thread_sync)
     atomic_fetch_add_explicit(&threadpool->n_graph, 1, memory_order_seq_cst);
@@ -3098,9 +4023,13 @@ static struct ggml_threadpool * ggml_threadpool_new_impl(
         threadpool->pause            = tpp->paused;
         threadpool->abort            = -1;
         threadpool->workers          = NULL;
+        threadpool->barrier_tree     = NULL;
         threadpool->n_threads_max    = tpp->n_threads;
         threadpool->n_threads_cur    = tpp->n_threads;
         threadpool->poll             = tpp->poll;
+        threadpool->t_graph_end      = 0;
+        threadpool->n_graph_gaps     = 0;
+        threadpool->poll_us          = GGML_THREADPOOL_POLL_MAX_US;
         threadpool->prio             = tpp->prio;
         threadpool->ec               = GGML_STATUS_SUCCESS;
     }
@@ -3117,6 +4046,15 @@ static struct ggml_threadpool * ggml_threadpool_new_impl(
 
     threadpool->workers = workers;
 
+    // a tree over n threads never has more than n nodes
+    const size_t barrier_tree_size = sizeof(struct ggml_barrier_node) * tpp->n_threads;
+    threadpool->barrier_tree = ggml_aligned_malloc(barrier_tree_size);
+    memset(threadpool->barrier_tree, 0, barrier_tree_size);
+
+    const size_t branch_queues_size = sizeof(struct ggml_branch_queue) * tpp->n_threads;
+    threadpool->branch_queues = ggml_aligned_malloc(branch_queues_size);
+    memset(threadpool->branch_queues, 0, branch_queues_size);
+
 #ifndef GGML_USE_OPENMP
     ggml_mutex_init(&threadpool->mutex);
     ggml_cond_init(&threadpool->cond);
@@ -3128,12 +4066,14 @@ static struct ggml_threadpool * ggml_threadpool_new_impl(
 
     for (int j = 1; j < tpp->n_threads; j++) {
         ggml_thread_cpumask_next(tpp->cpumask, workers[j].cpumask, tpp->strict_cpu, &cpumask_iter);
+        workers[j].capacity = ggml_thread_cpumask_capacity(workers[j].cpumask);
 
         int32_t rc = ggml_thread_create(&workers[j].thrd, NULL, ggml_graph_compute_secondary_thread, &workers[j]);
         GGML_ASSERT(rc == 0);
     }
 
     ggml_thread_cpumask_next(tpp->cpumask, workers[0].cpumask, tpp->strict_cpu, &cpumask_iter);
+    workers[0].capacity = ggml_thread_cpumask_capacity(workers[0].cpumask);
 
     if (!threadpool->pause) {
         // Update main thread prio and affinity at the start, otherwise we'll do it in resume
@@ -3148,6 +4088,12 @@ static struct ggml_threadpool * ggml_threadpool_new_impl(
 }
 
 struct ggml_threadpool * ggml_threadpool_new(struct ggml_threadpool_params * tpp) {
+#ifdef GGML_USE_OPENMP
+    // the OpenMP runtime decides how its threads wait, see OMP_WAIT_POLICY
+    if (tpp->poll == GGML_THREADPOOL_POLL_ADAPTIVE) {
+        GGML_LOG_WARN("%s: adaptive polling has no effect with OpenMP, build with GGML_OPENMP=OFF\n", __func__);
+    }
+#endif
     return ggml_threadpool_new_impl(tpp, NULL, NULL);
 }
 
@@ -3158,6 +4104,18 @@ enum ggml_status ggml_graph_compute(struct ggml_cgraph * cgraph, struct ggml_cpl
     GGML_ASSERT(cplan->n_threads > 0);
     GGML_ASSERT(cplan->work_size == 0 || cplan->work_data != NULL);
 
+    // the schedule is only built again if the caller gave the cplan another work buffer
+    {
+        const size_t sched_size = ggml_graph_sched_size(cgraph);
+        GGML_ASSERT(cplan->work_size >= sched_size);
+
+        void * sched = cplan->work_data + cplan->work_size - sched_size;
+        if (sched_size > 0 && cplan->sched != sched) {
+            ggml_graph_sched_init(cgraph, sched, cplan->n_threads);
+            cplan->sched = sched;
+        }
+    }
+
     int n_threads                               = cplan->n_threads;
     struct ggml_threadpool * threadpool = cplan->threadpool;
 
@@ -3190,6 +4148,12 @@ enum ggml_status ggml_graph_compute(struct ggml_cgraph * cgraph, struct ggml_cpl
                 atomic_store_explicit(&threadpool->n_threads_cur, n_threads, memory_order_relaxed);
             }
 
+            // weigh the rows of each thread by the cores it is bound to, all threads must see the same weights
+            if (g_state.capacity.hybrid && g_state.capacity.n_cpus > 0) {
+                threadpool->workers[omp_get_thread_num()].capacity = ggml_thread_affinity_capacity();
+                #pragma omp barrier
+            }
+
             ggml_graph_compute_thread(&threadpool->workers[omp_get_thread_num()]);
         }
     } else {
@@ -3207,6 +4171,8 @@ enum ggml_status ggml_graph_compute(struct ggml_cgraph * cgraph, struct ggml_cpl
 
     // This is a work thread too
     ggml_graph_compute_thread(&threadpool->workers[0]);
+
+    threadpool->t_graph_end = ggml_time_us();
 #endif
 
     // don't leave affinity set on the main thread
@@ -3574,6 +4540,10 @@ void ggml_cpu_init(void) {
         ggml_init_arm_arch_features();
 #endif
 
+        ggml_profiler_init_from_env();
+
+        ggml_cpu_init_capacity();
+
         is_first_call = false;
     }
 
@@ -1043,6 +1043,299 @@ class tinyBLAS_Q0_AVX {
 };
 #endif // __AVX__
 
+//////////////////////////////////////////////////////////////////////////////////////////
+// K-QUANT MATRIX MULTIPLICATION
+
+// The K-quant kernels treat every weight as an unsigned integer q with a
+// per-16-element scale sc and offset mn, so a super-block dot product with a
+// Q8_K activation reduces to
+//
+//     B.d * (A.d * Σ sc·q·b - A.dmin * Σ mn·bsum)
+//
+// Q4_K and Q5_K store sc and mn per 32 elements; Q6_K has no separate mins and
+// uses mn = 32·sc with dmin = d to fold its -32 bias into the same form.
+
+#if defined(__AVX2__)
+static inline void get_scales_min_k4(const uint8_t *scales, uint8_t *sc, uint8_t *mn) {
+    const uint32_t kmask1 = 0x3f3f3f3f;
+    const uint32_t kmask2 = 0x0f0f0f0f;
+    const uint32_t kmask3 = 0x03030303;
+    uint32_t utmp[4];
+    memcpy(utmp, scales, 12);
+    utmp[3] = ((utmp[2] >> 4) & kmask2) | (((utmp[1] >> 6) & kmask3) << 4);
+    const uint32_t uaux = utmp[1] & kmask1;
+    utmp[1] = (utmp[2] & kmask2) | (((utmp[0] >> 6) & kmask3) << 4);
+    utmp[2] = uaux;
+    utmp[0] &= kmask1;
+    memcpy(sc, utmp + 0, 8);
+    memcpy(mn, utmp + 2, 8);
+}
+#endif
+
+#if defined(__AVX2__)
+template <typename TA>
+class tinyBLAS_K_AVX {
+  public:
+    tinyBLAS_K_AVX(int64_t k,
+                   const TA *A, int64_t lda,
+                   const block_q8_K *B, int64_t ldb,
+                   float *C, int64_t ldc,
+                   int ith, int nth)
+        : A(A), B(B), C(C), k(k), lda(lda), ldb(ldb), ldc(ldc), ith(ith), nth(nth) {
+    }
+
+    void matmul(int64_t m, int64_t n) {
+        mnpack(0, m, 0, n);
+    }
+
+  private:
+    // one super-block of A expanded to unsigned bytes, 32 at a time
+    struct unpacked {
+        __m256i q[QK_K/32];
+        __m256i sc[QK_K/32]; // int16 scale of each byte pair produced by maddubs
+        __m256i mn;          // int16 offset of each group of 16
+        float d;
+        float dmin;
+    };
+
+    void mnpack(int64_t m0, int64_t m, int64_t n0, int64_t n) {
+        int64_t mc, nc, mp, np;
+        switch ((MIN(m - m0, 4) << 4) | MIN(n - n0, 4)) {
+#if VECTOR_REGISTERS == 32
+        case 0x44:
+            mc = 4;
+            nc = 4;
+            gemm<4, 4>(m0, m, n0, n);
+            break;
+        case 0x43:
+            mc = 4;
+            nc = 3;
+            gemm<4, 3>(m0, m, n0, n);
+            break;
+        case 0x34:
+            mc = 3;
+            nc = 4;
+            gemm<3, 4>(m0, m, n0, n);
+            break;
+        case 0x33:
+            mc = 3;
+            nc = 3;
+            gemm<3, 3>(m0, m, n0, n);
+            break;
+        case 0x42:
+            mc = 4;
+            nc = 2;
+            gemm<4, 2>(m0, m, n0, n);
+            break;
+        case 0x24:
+            mc = 2;
+            nc = 4;
+            gemm<2, 4>(m0, m, n0, n);
+            break;
+#else
+        case 0x44:
+        case 0x43:
+        case 0x42:
+            mc = 4;
+            nc = 2;
+            gemm<4, 2>(m0, m, n0, n);
+            break;
+        case 0x34:
+        case 0x24:
+            mc = 2;
+            nc = 4;
+            gemm<2, 4>(m0, m, n0, n);
+            break;
+        case 0x33:
+#endif
+        case 0x32:
+            mc = 3;
+            nc = 2;
+            gemm<3, 2>(m0, m, n0, n);
+            break;
+        case 0x23:
+            mc = 2;
+            nc = 3;
+            gemm<2, 3>(m0, m, n0, n);
+            break;
+        case 0x41:
+            mc = 4;
+            nc = 1;
+            gemm<4, 1>(m0, m, n0, n);
+            break;
+        case 0x22:
+            mc = 2;
+            nc = 2;
+            gemm<2, 2>(m0, m, n0, n);
+            break;
+        case 0x14:
+            mc = 1;
+            nc = 4;
+            gemm<1, 4>(m0, m, n0, n);
+            break;
+        case 0x31:
+            mc = 3;
+            nc = 1;
+            gemm<3, 1>(m0, m, n0, n);
+            break;
+        case 0x13:
+            mc = 1;
+            nc = 3;
+            gemm<1, 3>(m0, m, n0, n);
+            break;
+        case 0x21:
+            mc = 2;
+            nc = 1;
+            gemm<2, 1>(m0, m, n0, n);
+            break;
+        case 0x12:
+            mc = 1;
+            nc = 2;
+            gemm<1, 2>(m0, m, n0, n);
+            break;
+        case 0x11:
+            mc = 1;
+            nc = 1;
+            gemm<1, 1>(m0, m, n0, n);
+            break;
+        default:
+            return;
+        }
+        mp = m0 + (m - m0) / mc * mc;
+        np = n0 + (n - n0) / nc * nc;
+        mnpack(mp, m, n0, np);
+        mnpack(m0, m, np, n);
+    }
+
+    template <int RM, int RN>
+    NOINLINE void gemm(int64_t m0, int64_t m, int64_t n0, int64_t n) {
+        int64_t ytiles = (m - m0) / RM;
+        int64_t xtiles = (n - n0) / RN;
+        int64_t tiles = xtiles * ytiles;
+        int64_t duty = (tiles + nth - 1) / nth;
+        int64_t start = duty * ith;
+        int64_t end = start + duty;
+        if (end > tiles)
+            end = tiles;
+        for (int64_t job = start; job < end; ++job) {
+            int64_t ii = m0 + job / xtiles * RM;
+            int64_t jj = n0 + job % xtiles * RN;
+            __m256 Cv[RN][RM] = {};
+            for (int64_t l = 0; l < k; ++l) {
+                // unpack each super-block of A once and reuse it for the RN columns of B
+                unpacked a[RM];
+                for (int64_t i = 0; i < RM; ++i)
+                    unpack(A + lda * (ii + i) + l, a[i]);
+                __m256i sumi[RN][RM] = {};
+                for (int c = 0; c < QK_K/32; ++c)
+                    for (int64_t j = 0; j < RN; ++j) {
+                        const __m256i qb = _mm256_loadu_si256((const __m256i *)(B[ldb * (jj + j) + l].qs + 32*c));
+                        for (int64_t i = 0; i < RM; ++i)
+                            sumi[j][i] = _mm256_add_epi32(sumi[j][i],
+                                                          _mm256_madd_epi16(_mm256_maddubs_epi16(a[i].q[c], qb),
+                                                                            a[i].sc[c]));
+                    }
+                for (int64_t j = 0; j < RN; ++j) {
+                    const block_q8_K *b = B + ldb * (jj + j) + l;
+                    const __m256i bsums = _mm256_loadu_si256((const __m256i *)b->bsums);
+                    for (int64_t i = 0; i < RM; ++i) {
+                        Cv[j][i] = madd(_mm256_set1_ps(b->d * a[i].d),
+                                        _mm256_cvtepi32_ps(sumi[j][i]),
+                                        Cv[j][i]);
+                        Cv[j][i] = madd(_mm256_set1_ps(-b->d * a[i].dmin),
+                                        _mm256_cvtepi32_ps(_mm256_madd_epi16(a[i].mn, bsums)),
+                                        Cv[j][i]);
+                    }
+                }
+            }
+            for (int64_t j = 0; j < RN; ++j)
+                for (int64_t i = 0; i < RM; ++i)
+                    C[ldc * (jj + j) + (ii + i)] = hsum(Cv[j][i]);
+        }
+    }
+
+    inline void unpack(const block_q4_K *x, unpacked &u) {
+        uint8_t sc[8], mn[8];
+        get_scales_min_k4(x->scales, sc, mn);
+        const __m256i m4 = _mm256_set1_epi8(15);
+        for (int j = 0; j < QK_K/64; ++j) {
+            const __m256i bits = _mm256_loadu_si256((const __m256i *)(x->qs + 32*j));
+            u.q[2*j + 0] = _mm256_and_si256(bits, m4);
+            u.q[2*j + 1] = _mm256_and_si256(_mm256_srli_epi16(bits, 4), m4);
+            u.sc[2*j + 0] = _mm256_set1_epi16(sc[2*j + 0]);
+            u.sc[2*j + 1] = _mm256_set1_epi16(sc[2*j + 1]);
+        }
+        u.mn = mins_k4(mn);
+        u.d = unhalf(x->d);
+        u.dmin = unhalf(x->dmin);
+    }
+
+    inline void unpack(const block_q5_K *x, unpacked &u) {
+        uint8_t sc[8], mn[8];
+        get_scales_min_k4(x->scales, sc, mn);
+        const __m256i m4 = _mm256_set1_epi8(15);
+        const __m256i m16 = _mm256_set1_epi8(16);
+        // bit c of qh is the fifth bit of chunk c
+        __m256i hbits = _mm256_loadu_si256((const __m256i *)x->qh);
+        for (int j = 0; j < QK_K/64; ++j) {
+            const __m256i bits = _mm256_loadu_si256((const __m256i *)(x->qs + 32*j));
+            u.q[2*j + 0] = _mm256_or_si256(_mm256_and_si256(bits, m4),
+                                           _mm256_and_si256(_mm256_slli_epi16(hbits, 4), m16));
+            hbits = _mm256_srli_epi16(hbits, 1);
+            u.q[2*j + 1] = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(bits, 4), m4),
+                                           _mm256_and_si256(_mm256_slli_epi16(hbits, 4), m16));
+            hbits = _mm256_srli_epi16(hbits, 1);
+            u.sc[2*j + 0] = _mm256_set1_epi16(sc[2*j + 0]);
+            u.sc[2*j + 1] = _mm256_set1_epi16(sc[2*j + 1]);
+        }
+        u.mn = mins_k4(mn);
+        u.d = unhalf(x->d);
+        u.dmin = unhalf(x->dmin);
+    }
+
+    inline void unpack(const block_q6_K *x, unpacked &u) {
+        const __m256i m4 = _mm256_set1_epi8(15);
+        const __m256i m2 = _mm256_set1_epi8(0x30);
+        for (int j = 0; j < QK_K/128; ++j) {
+            const __m256i ql0 = _mm256_loadu_si256((const __m256i *)(x->ql + 64*j));
+            const __m256i ql1 = _mm256_loadu_si256((const __m256i *)(x->ql + 64*j + 32));
+            const __m256i qh = _mm256_loadu_si256((const __m256i *)(x->qh + 32*j));
+            u.q[4*j + 0] = _mm256_or_si256(_mm256_and_si256(ql0, m4),
+                                           _mm256_and_si256(_mm256_slli_epi16(qh, 4), m2));
+            u.q[4*j + 1] = _mm256_or_si256(_mm256_and_si256(ql1, m4),
+                                           _mm256_and_si256(_mm256_slli_epi16(qh, 2), m2));
+            u.q[4*j + 2] = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(ql0, 4), m4),
+                                           _mm256_and_si256(qh, m2));
+            u.q[4*j + 3] = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(ql1, 4), m4),
+                                           _mm256_and_si256(_mm256_srli_epi16(qh, 2), m2));
+        }
+        for (int c = 0; c < QK_K/32; ++c)
+            u.sc[c] = MM256_SET_M128I(_mm_set1_epi16(x->scales[2*c + 1]),
+                                      _mm_set1_epi16(x->scales[2*c + 0]));
+        u.mn = _mm256_slli_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)x->scales)), 5);
+        u.d = unhalf(x->d);
+        u.dmin = u.d;
+    }
+
+    // each of the eight mins covers two groups of 16
+    static inline __m256i mins_k4(const uint8_t *mn) {
+        const __m128i m = _mm_loadl_epi64((const __m128i *)mn);
+        return _mm256_cvtepu8_epi16(_mm_shuffle_epi8(m, _mm_set_epi8(7, 7, 6, 6, 5, 5, 4, 4,
+                                                                     3, 3, 2, 2, 1, 1, 0, 0)));
+    }
+
+    const TA *const A;
+    const block_q8_K *const B;
+    float *const C;
+    const int64_t k;
+    const int64_t lda;
+    const int64_t ldb;
+    const int64_t ldc;
+    const int ith;
+    const int nth;
+};
+#endif // __AVX2__
+
 //PPC Implementation
 #if defined(__MMA__)
 
@@ -3508,6 +3801,54 @@ bool llamafile_sgemm(const struct ggml_compute_params * params, int64_t m, int64
 #endif
     }
 
+    case GGML_TYPE_Q4_K: {
+        if (Btype != GGML_TYPE_Q8_K)
+            return false;
+#if defined(__AVX2__)
+        tinyBLAS_K_AVX<block_q4_K> tb{
+            k, (const block_q4_K *)A, lda,
+            (const block_q8_K *)B, ldb,
+            (float *)C, ldc,
+            params->ith, params->nth};
+        tb.matmul(m, n);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    case GGML_TYPE_Q5_K: {
+        if (Btype != GGML_TYPE_Q8_K)
+            return false;
+#if defined(__AVX2__)
+        tinyBLAS_K_AVX<block_q5_K> tb{
+            k, (const block_q5_K *)A, lda,
+            (const block_q8_K *)B, ldb,
+            (float *)C, ldc,
+            params->ith, params->nth};
+        tb.matmul(m, n);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    case GGML_TYPE_Q6_K: {
+        if (Btype != GGML_TYPE_Q8_K)
+            return false;
+#if defined(__AVX2__)
+        tinyBLAS_K_AVX<block_q6_K> tb{
+            k, (const block_q6_K *)A, lda,
+            (const block_q8_K *)B, ldb,
+            (float *)C, ldc,
+            params->ith, params->nth};
+        tb.matmul(m, n);
+        return true;
+#else
+        return false;
+#endif
+    }
+
     case GGML_TYPE_IQ4_NL: {
         if (Btype != GGML_TYPE_Q8_0)
             return false;
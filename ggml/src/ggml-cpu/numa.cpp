@@ -0,0 +1,236 @@
+#include "ggml-backend-impl.h"
+#include "ggml-backend.h"
+#include "ggml-cpu.h"
+#include "ggml-cpu-impl.h"
+#include "ggml-impl.h"
+#include "traits.h"
+
+#include "numa.h"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#if defined(__gnu_linux__)
+#include <sys/mman.h>
+
+// buffer type NUMA
+//
+// The buffer holds one copy of its data per NUMA node, each allocated on its node. The tensors
+// point into the copy of node 0; a mul_mat reads src0 from the copy of the node of its thread.
+
+namespace ggml::cpu::numa {
+
+struct buffer_context {
+    std::vector<void *> replicas; // one per node
+    size_t              size;
+};
+
+static char * replica_data(const struct ggml_tensor * tensor, int node) {
+    auto * ctx = (buffer_context *) tensor->buffer->context;
+
+    return (char *) ctx->replicas[node] + ((const char *) tensor->data - (const char *) ctx->replicas[0]);
+}
+
+class tensor_traits : public ggml::cpu::tensor_traits {
+    bool work_size(int /* n_threads */, const struct ggml_tensor * /* op */, size_t & /* size */) override {
+        // same as with the CPU buffer
+        return false;
+    }
+
+    bool compute_forward(struct ggml_compute_params * params, struct ggml_tensor * op) override {
+        auto * ctx = (buffer_context *) op->src[0]->buffer->context;
+
+        const int node = ggml_cpu_numa_thread_node(params->ith) % (int) ctx->replicas.size();
+
+        struct ggml_tensor src0 = *op->src[0];
+        src0.data = replica_data(op->src[0], node);
+
+        struct ggml_tensor dst = *op;
+        dst.src[0] = &src0;
+
+        switch (op->op) {
+            case GGML_OP_MUL_MAT:
+                ggml_compute_forward_mul_mat(params, &dst);
+                break;
+            case GGML_OP_MUL_MAT_ID:
+                ggml_compute_forward_mul_mat_id(params, &dst);
+                break;
+            default:
+                return false;
+        }
+
+        // the src1 conversion in wdata belongs to op, not to the local copy
+        if (params->wdata_owner == &dst) {
+            params->wdata_owner = op;
+        }
+
+        return true;
+    }
+};
+
+static tensor_traits traits;
+
+class extra_buffer_type : ggml::cpu::extra_buffer_type {
+    bool supports_op(ggml_backend_dev_t, const struct ggml_tensor * op) override {
+        if ((op->op != GGML_OP_MUL_MAT && op->op != GGML_OP_MUL_MAT_ID) || ggml_cpu_numa_n_replicas() == 0) {
+            return false;
+        }
+
+        const struct ggml_tensor * src0 = op->src[0];
+        const struct ggml_tensor * src1 = op->src[1];
+
+        if (!src0->buffer || src0->buffer->buft != ggml_backend_cpu_numa_buffer_type()) {
+            return false;
+        }
+        if (src1->buffer && !ggml_backend_buft_is_host(src1->buffer->buft)) {
+            return false;
+        }
+
+        return src1->type == GGML_TYPE_F32 || src1->type == ggml_get_type_traits_cpu(src0->type)->vec_dot_type;
+    }
+
+    ggml::cpu::tensor_traits * get_tensor_traits(const struct ggml_tensor * op) override {
+        if ((op->op == GGML_OP_MUL_MAT || op->op == GGML_OP_MUL_MAT_ID) &&
+            op->src[0]->buffer && op->src[0]->buffer->buft == ggml_backend_cpu_numa_buffer_type()) {
+            return (ggml::cpu::tensor_traits *) op->src[0]->extra;
+        }
+        return nullptr;
+    }
+};
+
+}  // namespace ggml::cpu::numa
+
+using ggml::cpu::numa::buffer_context;
+
+static void ggml_backend_cpu_numa_buffer_free_buffer(ggml_backend_buffer_t buffer) {
+    auto * ctx = (buffer_context *) buffer->context;
+
+    for (void * replica : ctx->replicas) {
+        munmap(replica, ctx->size);
+    }
+
+    delete ctx;
+}
+
+static void * ggml_backend_cpu_numa_buffer_get_base(ggml_backend_buffer_t buffer) {
+    return ((buffer_context *) buffer->context)->replicas[0];
+}
+
+static enum ggml_status ggml_backend_cpu_numa_buffer_init_tensor(ggml_backend_buffer_t buffer, struct ggml_tensor * tensor) {
+    tensor->extra = (void *) &ggml::cpu::numa::traits;
+
+    GGML_UNUSED(buffer);
+    return GGML_STATUS_SUCCESS;
+}
+
+static void ggml_backend_cpu_numa_buffer_memset_tensor(ggml_backend_buffer_t buffer, struct ggml_tensor * tensor,
+                                                       uint8_t value, size_t offset, size_t size) {
+    auto * ctx = (buffer_context *) buffer->context;
+
+    for (size_t node = 0; node < ctx->replicas.size(); node++) {
+        memset(ggml::cpu::numa::replica_data(tensor, node) + offset, value, size);
+    }
+}
+
+static void ggml_backend_cpu_numa_buffer_set_tensor(ggml_backend_buffer_t buffer, struct ggml_tensor * tensor,
+                                                    const void * data, size_t offset, size_t size) {
+    auto * ctx = (buffer_context *) buffer->context;
+
+    for (size_t node = 0; node < ctx->replicas.size(); node++) {
+        memcpy(ggml::cpu::numa::replica_data(tensor, node) + offset, data, size);
+    }
+}
+
+static void ggml_backend_cpu_numa_buffer_get_tensor(ggml_backend_buffer_t buffer, const struct ggml_tensor * tensor,
+                                                    void * data, size_t offset, size_t size) {
+    memcpy(data, (const char *) tensor->data + offset, size);
+
+    GGML_UNUSED(buffer);
+}
+
+static void ggml_backend_cpu_numa_buffer_clear(ggml_backend_buffer_t buffer, uint8_t value) {
+    auto * ctx = (buffer_context *) buffer->context;
+
+    for (void * replica : ctx->replicas) {
+        memset(replica, value, ctx->size);
+    }
+}
+
+static const struct ggml_backend_buffer_i ggml_backend_cpu_numa_buffer_i = {
+    /* .free_buffer     = */ ggml_backend_cpu_numa_buffer_free_buffer,
+    /* .get_base        = */ ggml_backend_cpu_numa_buffer_get_base,
+    /* .init_tensor     = */ ggml_backend_cpu_numa_buffer_init_tensor,
+    /* .memset_tensor   = */ ggml_backend_cpu_numa_buffer_memset_tensor,
+    /* .set_tensor      = */ ggml_backend_cpu_numa_buffer_set_tensor,
+    /* .get_tensor      = */ ggml_backend_cpu_numa_buffer_get_tensor,
+    /* .cpy_tensor      = */ nullptr,
+    /* .clear           = */ ggml_backend_cpu_numa_buffer_clear,
+    /* .reset           = */ nullptr,
+};
+
+static const char * ggml_backend_cpu_numa_buffer_type_get_name(ggml_backend_buffer_type_t buft) {
+    return "CPU_NUMA";
+
+    GGML_UNUSED(buft);
+}
+
+static ggml_backend_buffer_t ggml_backend_cpu_numa_buffer_type_alloc_buffer(ggml_backend_buffer_type_t buft, size_t size) {
+    const int n_replicas = ggml_cpu_numa_n_replicas();
+    if (n_replicas == 0) {
+        GGML_LOG_ERROR("%s: the weights are only replicated with GGML_NUMA_STRATEGY_MIRROR\n", __func__);
+        return nullptr;
+    }
+
+    auto * ctx = new buffer_context;
+    ctx->size = size;
+
+    for (int node = 0; node < n_replicas; node++) {
+        void * replica = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (replica == MAP_FAILED) {
+            GGML_LOG_ERROR("%s: failed to allocate %zu bytes for node %d: %s\n", __func__, size, node, strerror(errno));
+            for (void * r : ctx->replicas) {
+                munmap(r, size);
+            }
+            delete ctx;
+            return nullptr;
+        }
+
+        // the pages are placed when they are first written
+        if (!ggml_cpu_numa_bind(replica, size, node)) {
+            GGML_LOG_WARN("%s: failed to bind the weights to node %d: %s\n", __func__, node, strerror(errno));
+        }
+
+        ctx->replicas.push_back(replica);
+    }
+
+    return ggml_backend_buffer_init(buft, ggml_backend_cpu_numa_buffer_i, ctx, size);
+}
+
+static size_t ggml_backend_cpu_numa_buffer_type_get_alignment(ggml_backend_buffer_type_t buft) {
+    return TENSOR_ALIGNMENT;
+
+    GGML_UNUSED(buft);
+}
+
+ggml_backend_buffer_type_t ggml_backend_cpu_numa_buffer_type(void) {
+    static struct ggml_backend_buffer_type ggml_backend_cpu_buffer_type_numa = {
+        /* .iface    = */ {
+                           /* .get_name         = */ ggml_backend_cpu_numa_buffer_type_get_name,
+                           /* .alloc_buffer     = */ ggml_backend_cpu_numa_buffer_type_alloc_buffer,
+                           /* .get_alignment    = */ ggml_backend_cpu_numa_buffer_type_get_alignment,
+                           /* .get_max_size     = */ nullptr,  // defaults to SIZE_MAX
+                           /* .get_alloc_size   = */ nullptr,  // defaults to ggml_nbytes
+                           /* .is_host          = */ nullptr,
+                           },
+        /* .device  = */ ggml_backend_reg_dev_get(ggml_backend_cpu_reg(), 0),
+        /* .context = */ new ggml::cpu::numa::extra_buffer_type(),
+    };
+
+    return &ggml_backend_cpu_buffer_type_numa;
+}
+#else
+ggml_backend_buffer_type_t ggml_backend_cpu_numa_buffer_type(void) {
+    return nullptr;
+}
+#endif
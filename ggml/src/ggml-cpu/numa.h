@@ -0,0 +1,9 @@
+#pragma once
+
+#include "ggml-backend.h"
+#include "ggml.h"
+
+// GGML CPU internal header
+
+// weights with a copy on each NUMA node, used with GGML_NUMA_STRATEGY_MIRROR
+ggml_backend_buffer_type_t ggml_backend_cpu_numa_buffer_type(void);
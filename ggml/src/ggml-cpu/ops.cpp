@@ -1,3 +1,6 @@
+#define GGML_COMMON_DECL_CPP
+#include "ggml-common.h"
+
 #include "ops.h"
 
 #include "ggml-cpu.h"
@@ -3333,6 +3336,104 @@ void ggml_compute_forward_rms_norm(
     }
 }
 
+// ggml_compute_forward_add_rms_norm_mul
+
+// pointer to row (i1, i2, i3) of t, broadcast like in binary ops
+static inline float * ggml_fused_row_f32(const ggml_tensor * t, int64_t i1, int64_t i2, int64_t i3) {
+    return (float *) ((char *) t->data + (i1 % t->ne[1])*t->nb[1] + (i2 % t->ne[2])*t->nb[2] + (i3 % t->ne[3])*t->nb[3]);
+}
+
+// fused [ADD ->] RMS_NORM [-> MUL], add and mul are optional
+// each row goes through all the ops while it is in cache, the outputs of all nodes are written
+void ggml_compute_forward_add_rms_norm_mul(
+        const ggml_compute_params * params,
+        ggml_tensor * add,
+        ggml_tensor * norm,
+        ggml_tensor * mul) {
+
+    const ggml_tensor * src0 = norm->src[0];
+    const ggml_tensor * w    = mul ? (mul->src[0] == norm ? mul->src[1] : mul->src[0]) : nullptr;
+
+    GGML_ASSERT(src0->type == GGML_TYPE_F32 && norm->type == GGML_TYPE_F32);
+    GGML_ASSERT(ggml_are_same_shape(src0, norm));
+
+    float eps;
+    memcpy(&eps, norm->op_params, sizeof(float));
+
+    GGML_ASSERT(eps >= 0.0f);
+
+    const int64_t ne00 = src0->ne[0];
+    const int64_t ne01 = src0->ne[1];
+    const int64_t ne02 = src0->ne[2];
+
+    const auto [ir0, ir1] = get_thread_range(params, norm);
+
+    for (int64_t ir = ir0; ir < ir1; ++ir) {
+        const int64_t i03 = ir/(ne02*ne01);
+        const int64_t i02 = (ir - i03*ne02*ne01)/ne01;
+        const int64_t i01 = (ir - i03*ne02*ne01 - i02*ne01);
+
+        float * x = ggml_fused_row_f32(src0, i01, i02, i03);
+
+        if (add) {
+            ggml_vec_add_f32(ne00, x,
+                    ggml_fused_row_f32(add->src[0], i01, i02, i03),
+                    ggml_fused_row_f32(add->src[1], i01, i02, i03));
+        }
+
+        ggml_float sum = 0.0;
+        for (int64_t i00 = 0; i00 < ne00; i00++) {
+            sum += (ggml_float)(x[i00] * x[i00]);
+        }
+
+        const float mean  = sum/ne00;
+        const float scale = 1.0f/sqrtf(mean + eps);
+
+        float * y = ggml_fused_row_f32(norm, i01, i02, i03);
+
+        if (mul) {
+            ggml_vec_scale_mul_f32(ne00, y, ggml_fused_row_f32(mul, i01, i02, i03), x, scale,
+                    ggml_fused_row_f32(w, i01, i02, i03));
+        } else {
+            memmove(y, x, ne00 * sizeof(float));
+            ggml_vec_scale_f32(ne00, y, scale);
+        }
+    }
+}
+
+// ggml_compute_forward_silu_mul
+
+// fused SILU -> MUL, the output of both nodes is written
+void ggml_compute_forward_silu_mul(
+        const ggml_compute_params * params,
+        ggml_tensor * silu,
+        ggml_tensor * mul) {
+
+    const ggml_tensor * src0 = silu->src[0];
+    const ggml_tensor * g    = mul->src[0] == silu ? mul->src[1] : mul->src[0];
+
+    GGML_ASSERT(src0->type == GGML_TYPE_F32 && silu->type == GGML_TYPE_F32);
+    GGML_ASSERT(ggml_are_same_shape(src0, silu));
+
+    const int64_t ne00 = src0->ne[0];
+    const int64_t ne01 = src0->ne[1];
+    const int64_t ne02 = src0->ne[2];
+
+    const auto [ir0, ir1] = get_thread_range(params, silu);
+
+    for (int64_t ir = ir0; ir < ir1; ++ir) {
+        const int64_t i03 = ir/(ne02*ne01);
+        const int64_t i02 = (ir - i03*ne02*ne01)/ne01;
+        const int64_t i01 = (ir - i03*ne02*ne01 - i02*ne01);
+
+        ggml_vec_swiglu_f32(ne00,
+                ggml_fused_row_f32(silu, i01, i02, i03),
+                ggml_fused_row_f32(mul,  i01, i02, i03),
+                ggml_fused_row_f32(src0, i01, i02, i03),
+                ggml_fused_row_f32(g,    i01, i02, i03));
+    }
+}
+
 static void ggml_compute_forward_rms_norm_back_f32(
         const ggml_compute_params * params,
         ggml_tensor * dst) {
@@ -6945,6 +7046,81 @@ void ggml_compute_forward_argsort(
 
 // ggml_compute_forward_flash_attn_ext
 
+// quantized V rows are dequantized here rather than with the to_float of the type traits:
+// these loops are built with the CPU backend's instruction set and vectorize
+
+// y = v for a row of V
+static void ggml_fa_v_to_float(ggml_type type, const char * GGML_RESTRICT v_data, float * GGML_RESTRICT y, int64_t n) {
+    switch (type) {
+        case GGML_TYPE_F16:
+            {
+                ggml_cpu_fp16_to_fp32((const ggml_fp16_t *) v_data, y, n);
+            } break;
+        case GGML_TYPE_Q8_0:
+            {
+                const block_q8_0 * GGML_RESTRICT x = (const block_q8_0 *) v_data;
+                for (int64_t ib = 0; ib < n/QK8_0; ++ib) {
+                    const float d = GGML_FP16_TO_FP32(x[ib].d);
+                    for (int j = 0; j < QK8_0; ++j) {
+                        y[ib*QK8_0 + j] = d*x[ib].qs[j];
+                    }
+                }
+            } break;
+        case GGML_TYPE_Q4_0:
+            {
+                const block_q4_0 * GGML_RESTRICT x = (const block_q4_0 *) v_data;
+                for (int64_t ib = 0; ib < n/QK4_0; ++ib) {
+                    const float d = GGML_FP16_TO_FP32(x[ib].d);
+                    for (int j = 0; j < QK4_0/2; ++j) {
+                        y[ib*QK4_0 + j          ] = d*((x[ib].qs[j] & 0x0F) - 8);
+                        y[ib*QK4_0 + j + QK4_0/2] = d*((x[ib].qs[j] >>   4) - 8);
+                    }
+                }
+            } break;
+        default:
+            {
+                ggml_get_type_traits(type)->to_float(v_data, y, n);
+            } break;
+    }
+}
+
+// y += v*s for a row of V, Q8_0 and Q4_0 are dequantized on the fly
+// TODO: KV block types with per-channel K and per-token V scales (KIVI), with fused dequant-dot kernels here
+static void ggml_fa_v_mad(ggml_type type, const char * GGML_RESTRICT v_data, float * GGML_RESTRICT y, float * GGML_RESTRICT tmp, int64_t n, float s) {
+    switch (type) {
+        case GGML_TYPE_F32:
+            {
+                ggml_vec_mad_f32(n, y, (const float *) v_data, s);
+            } break;
+        case GGML_TYPE_Q8_0:
+            {
+                const block_q8_0 * GGML_RESTRICT x = (const block_q8_0 *) v_data;
+                for (int64_t ib = 0; ib < n/QK8_0; ++ib) {
+                    const float d = GGML_FP16_TO_FP32(x[ib].d)*s;
+                    for (int j = 0; j < QK8_0; ++j) {
+                        y[ib*QK8_0 + j] += d*x[ib].qs[j];
+                    }
+                }
+            } break;
+        case GGML_TYPE_Q4_0:
+            {
+                const block_q4_0 * GGML_RESTRICT x = (const block_q4_0 *) v_data;
+                for (int64_t ib = 0; ib < n/QK4_0; ++ib) {
+                    const float d = GGML_FP16_TO_FP32(x[ib].d)*s;
+                    for (int j = 0; j < QK4_0/2; ++j) {
+                        y[ib*QK4_0 + j          ] += d*((x[ib].qs[j] & 0x0F) - 8);
+                        y[ib*QK4_0 + j + QK4_0/2] += d*((x[ib].qs[j] >>   4) - 8);
+                    }
+                }
+            } break;
+        default:
+            {
+                ggml_fa_v_to_float(type, v_data, tmp, n);
+                ggml_vec_mad_f32(n, y, tmp, s);
+            } break;
+    }
+}
+
 static void ggml_compute_forward_flash_attn_ext_f16(
         const ggml_compute_params * params,
         const ggml_tensor * q,
@@ -6997,16 +7173,26 @@ static void ggml_compute_forward_flash_attn_ext_f16(
     const int64_t rv3 = neq3/nev3;
 
     // parallelize by q rows using ggml_vec_dot_f32
+    // with few q rows and a long KV, the KV of each row is also split across threads and the
+    // partial results of the splits are merged at the end (flash-decoding)
 
     // total rows in q
     const int nr = neq1*neq2*neq3;
 
-    // rows per thread
-    const int dr = (nr + nth - 1)/nth;
+    // KV splits per row and KV rows per split
+    const int n_split = ggml_flash_attn_ext_n_kv_split(dst, nth);
+    const int dc      = (nek1 + n_split - 1)/n_split;
 
-    // row range for this thread
-    const int ir0 = dr*ith;
-    const int ir1 = MIN(ir0 + dr, nr);
+    // total tasks and tasks per thread
+    const int nt = nr*n_split;
+    const int dt = (nt + nth - 1)/nth;
+
+    // task range for this thread
+    const int it0 = dt*ith;
+    const int it1 = MIN(it0 + dt, nt);
+
+    // partial results of the splits: max, sum and unnormalized VKQ of each task
+    float * part = (float *) params->wdata + nth*(1*DK + 2*DV + CACHE_LINE_SIZE_F32);
 
     float scale         = 1.0f;
     float max_bias      = 0.0f;
@@ -7034,8 +7220,14 @@ static void ggml_compute_forward_flash_attn_ext_f16(
     GGML_ASSERT((                            q_to_vec_dot) && "fattn: unsupported K-type");
     GGML_ASSERT((v->type == GGML_TYPE_F32 || v_to_float  ) && "fattn: unsupported V-type");
 
-    // loop over n_batch and n_head
-    for (int ir = ir0; ir < ir1; ++ir) {
+    // loop over n_batch, n_head and the KV splits
+    for (int it = it0; it < it1; ++it) {
+        const int ir = it/n_split;
+
+        // KV range of this split
+        const int64_t ic0 = (it - ir*n_split)*dc;
+        const int64_t ic1 = MIN(ic0 + dc, nek1);
+
         // q indices
         const int iq3 = ir/(neq2*neq1);
         const int iq2 = (ir - iq3*neq2*neq1)/neq1;
@@ -7074,7 +7266,7 @@ static void ggml_compute_forward_flash_attn_ext_f16(
         // online softmax / attention
         // loop over n_kv and n_head_kv
         // ref: https://arxiv.org/pdf/2112.05682.pdf
-        for (int64_t ic = 0; ic < nek1; ++ic) {
+        for (int64_t ic = ic0; ic < ic1; ++ic) {
             const float mv = mp ? slope*GGML_FP16_TO_FP32(mp[ic]) : 0.0f;
             if (mv == -INFINITY) {
                 continue;
@@ -7129,13 +7321,7 @@ static void ggml_compute_forward_flash_attn_ext_f16(
                 }
 
                 // V += v*expf(s - M)
-                if (v_to_float) {
-                    v_to_float(v_data, V32, DV);
-                    ggml_vec_mad_f32(DV, VKQ32, V32, vs);
-                } else {
-                    // V is F32
-                    ggml_vec_mad_f32(DV, VKQ32, (const float *) v_data, vs);
-                }
+                ggml_fa_v_mad(v->type, v_data, VKQ32, V32, DV, vs);
             }
 
             S = S*ms + vs; // scale and increment sum with partial sum
@@ -7147,6 +7333,15 @@ static void ggml_compute_forward_flash_attn_ext_f16(
             }
         }
 
+        if (n_split > 1) {
+            float * pt = part + it*(DV + 2);
+
+            pt[0] = M;
+            pt[1] = S;
+            memcpy(pt + 2, VKQ32, DV*sizeof(float));
+            continue;
+        }
+
         // V /= S
         const float S_inv = 1.0f/S;
         ggml_vec_scale_f32(DV, VKQ32, S_inv);
@@ -7162,6 +7357,317 @@ static void ggml_compute_forward_flash_attn_ext_f16(
         // permute(0, 2, 1, 3)
         memcpy((char *) dst->data + (i3*ne2*ne1 + i2 + i1*ne1)*nb1, VKQ32, nb1);
     }
+
+    if (n_split == 1) {
+        return;
+    }
+
+    // all the splits are done before they are merged
+    ggml_barrier(params->threadpool);
+
+    // rows per thread
+    const int dr = (nr + nth - 1)/nth;
+
+    // row range for this thread
+    const int ir0 = dr*ith;
+    const int ir1 = MIN(ir0 + dr, nr);
+
+    float * VKQ32 = (float *) params->wdata + ith*(1*DK + 2*DV + CACHE_LINE_SIZE_F32);
+
+    for (int ir = ir0; ir < ir1; ++ir) {
+        const float * pr = part + ir*n_split*(DV + 2);
+
+        // rescale the splits to their common maximum
+        float M = -INFINITY;
+        for (int is = 0; is < n_split; ++is) {
+            M = MAX(M, pr[is*(DV + 2)]);
+        }
+
+        float S = 0.0f;
+        memset(VKQ32, 0, DV*sizeof(float));
+
+        for (int is = 0; is < n_split; ++is) {
+            const float * pt = pr + is*(DV + 2);
+            if (pt[1] == 0.0f) {
+                // fully masked split
+                continue;
+            }
+
+            const float ms = expf(pt[0] - M);
+
+            S += pt[1]*ms;
+            ggml_vec_mad_f32(DV, VKQ32, pt + 2, ms);
+        }
+
+        // V /= S
+        const float S_inv = 1.0f/S;
+        ggml_vec_scale_f32(DV, VKQ32, S_inv);
+
+        // dst indices
+        const int i3 = ir/(neq2*neq1);
+        const int i2 = (ir - i3*neq2*neq1)/neq1;
+        const int i1 = (ir - i3*neq2*neq1 - i2*neq1);
+
+        // permute(0, 2, 1, 3)
+        memcpy((char *) dst->data + (i3*ne2*ne1 + i2 + i1*ne1)*nb1, VKQ32, nb1);
+    }
+}
+
+int64_t ggml_flash_attn_ext_n_kv_split(const ggml_tensor * dst, int nth) {
+    const ggml_tensor * q = dst->src[0];
+    const ggml_tensor * k = dst->src[1];
+
+    // several q rows per head use the tiled kernel
+    if (q->ne[1] > 1) {
+        return 1;
+    }
+
+    // total rows in q
+    const int64_t nr = ggml_nrows(q);
+
+    // enough tasks to keep all the threads busy, with splits long enough to be worth merging
+    const int64_t n_split = MIN((GGML_FA_SPLIT_TASKS*nth + nr - 1)/nr, k->ne[1]/GGML_FA_SPLIT_KV_MIN);
+
+    return MAX(n_split, 1);
+}
+
+// tiled version for several query rows per head (prompt processing):
+// each thread takes tiles of GGML_FA_TILE_Q query rows of the same head and walks the KV in
+// blocks of GGML_FA_TILE_KV rows, so that every K and V row is read (and converted) once per
+// tile instead of once per query row. the softmax max and sum of each query row are updated
+// once per block, and fully masked rows and blocks skip the dot products
+static void ggml_compute_forward_flash_attn_ext_f16_tiled(
+        const ggml_compute_params * params,
+        const ggml_tensor * q,
+        const ggml_tensor * k,
+        const ggml_tensor * v,
+        const ggml_tensor * mask,
+        ggml_tensor * dst) {
+
+    GGML_TENSOR_LOCALS(int64_t, neq, q,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbq, q,   nb)
+    GGML_TENSOR_LOCALS(int64_t, nek, k,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbk, k,   nb)
+    GGML_TENSOR_LOCALS(int64_t, nev, v,   ne)
+    GGML_TENSOR_LOCALS(size_t,  nbv, v,   nb)
+    GGML_TENSOR_LOCALS(int64_t, ne,  dst, ne)
+    GGML_TENSOR_LOCALS(size_t,  nb,  dst, nb)
+
+    const int ith = params->ith;
+    const int nth = params->nth;
+
+    const int64_t DK = nek0;
+    const int64_t DV = nev0;
+    const int64_t N  = neq1;
+
+    const int64_t BR = GGML_FA_TILE_Q;
+    const int64_t BC = GGML_FA_TILE_KV;
+
+    GGML_ASSERT(ne0 == DV);
+    GGML_ASSERT(ne2 == N);
+
+    // input tensor rows must be contiguous
+    GGML_ASSERT(nbq0 == ggml_type_size(q->type));
+    GGML_ASSERT(nbk0 == ggml_type_size(k->type));
+    GGML_ASSERT(nbv0 == ggml_type_size(v->type));
+
+    GGML_ASSERT(neq0 == DK);
+    GGML_ASSERT(nek0 == DK);
+    GGML_ASSERT(nev0 == DV);
+
+    GGML_ASSERT(neq1 == N);
+
+    // dst cannot be transposed or permuted
+    GGML_ASSERT(nb0 == sizeof(float));
+    GGML_ASSERT(nb0 <= nb1);
+    GGML_ASSERT(nb1 <= nb2);
+    GGML_ASSERT(nb2 <= nb3);
+
+    // broadcast factors
+    const int64_t rk2 = neq2/nek2;
+    const int64_t rk3 = neq3/nek3;
+
+    const int64_t rv2 = neq2/nev2;
+    const int64_t rv3 = neq3/nev3;
+
+    // parallelize by tiles of q rows of the same head
+
+    // tiles per head and total tiles
+    const int64_t nt1 = (neq1 + BR - 1)/BR;
+    const int64_t nr  = nt1*neq2*neq3;
+
+    // tiles per thread
+    const int64_t dr = (nr + nth - 1)/nth;
+
+    // tile range for this thread
+    const int64_t ir0 = dr*ith;
+    const int64_t ir1 = MIN(ir0 + dr, nr);
+
+    float scale         = 1.0f;
+    float max_bias      = 0.0f;
+    float logit_softcap = 0.0f;
+
+    memcpy(&scale,         (float *) dst->op_params + 0, sizeof(float));
+    memcpy(&max_bias,      (float *) dst->op_params + 1, sizeof(float));
+    memcpy(&logit_softcap, (float *) dst->op_params + 2, sizeof(float));
+
+    if (logit_softcap != 0) {
+        scale /= logit_softcap;
+    }
+
+    const uint32_t n_head      = neq2;
+    const uint32_t n_head_log2 = 1u << (uint32_t) floor(log2(n_head));
+
+    const float m0 = powf(2.0f, -(max_bias       ) / n_head_log2);
+    const float m1 = powf(2.0f, -(max_bias / 2.0f) / n_head_log2);
+
+    ggml_type    const k_vec_dot_type      = ggml_get_type_traits_cpu(k->type)->vec_dot_type;
+    ggml_from_float_t const q_to_vec_dot   = ggml_get_type_traits_cpu(k_vec_dot_type)->from_float;
+    ggml_vec_dot_t    const kq_vec_dot     = ggml_get_type_traits_cpu(k->type)->vec_dot;
+    ggml_to_float_t   const v_to_float     = ggml_get_type_traits(v->type)->to_float;
+
+    GGML_ASSERT((                            q_to_vec_dot) && "fattn: unsupported K-type");
+    GGML_ASSERT((v->type == GGML_TYPE_F32 || v_to_float  ) && "fattn: unsupported V-type");
+
+    // the converted Q rows are at most as large as the F32 rows
+    GGML_ASSERT(ggml_row_size(k_vec_dot_type, DK) <= DK*sizeof(float));
+
+    float * Q_q = (float *) params->wdata + ith*(BR*(DK + DV + BC + 2) + DV + CACHE_LINE_SIZE_F32); // BR x DK Q rows converted to quantized/FP16
+    float * VKQ = Q_q + BR*DK; // BR x DV FP32 VKQ accumulators
+    float * KQ  = VKQ + BR*DV; // BR x BC KQ values of the current block, then their softmax
+    float * M   = KQ  + BR*BC; // maximum KQ value of each row
+    float * S   = M   + BR;    // sum of each row
+    float * V32 = S   + BR;    // (temporary) FP32 V row
+
+    // loop over the tiles of n_batch and n_head
+    for (int64_t ir = ir0; ir < ir1; ++ir) {
+        // q indices
+        const int64_t iq3 = ir/(neq2*nt1);
+        const int64_t iq2 = (ir - iq3*neq2*nt1)/nt1;
+        const int64_t iq1 = (ir - iq3*neq2*nt1 - iq2*nt1)*BR;
+
+        // number of q rows in this tile
+        const int64_t nq = MIN(BR, neq1 - iq1);
+
+        const uint32_t h = iq2; // head index
+        const float slope = (max_bias > 0.0f) ? h < n_head_log2 ? powf(m0, h + 1) : powf(m1, 2*(h - n_head_log2) + 1) : 1.0f;
+
+        // k indices
+        const int64_t ik3 = iq3 / rk3;
+        const int64_t ik2 = iq2 / rk2;
+
+        // v indices
+        const int64_t iv3 = iq3 / rv3;
+        const int64_t iv2 = iq2 / rv2;
+
+        for (int64_t i = 0; i < nq; ++i) {
+            const float * pq = (const float *) ((char *) q->data + ((iq1 + i)*nbq1 + iq2*nbq2 + iq3*nbq3));
+            q_to_vec_dot(pq, Q_q + i*DK, DK);
+
+            M[i] = -INFINITY;
+            S[i] = 0.0f;
+        }
+
+        memset(VKQ, 0, nq*DV*sizeof(float));
+
+        // online softmax / attention, one block of KV rows at a time
+        // ref: https://arxiv.org/pdf/2205.14135.pdf
+        for (int64_t ic0 = 0; ic0 < nek1; ic0 += BC) {
+            const int64_t nc = MIN(BC, nek1 - ic0);
+
+            // KQ = K*Q for the block, each K row is used for all the q rows of the tile
+            for (int64_t ic = 0; ic < nc; ++ic) {
+                const char * k_data = (const char *) k->data + ((ic0 + ic)*nbk1 + ik2*nbk2 + ik3*nbk3);
+
+                for (int64_t i = 0; i < nq; ++i) {
+                    const ggml_fp16_t * mp = mask ? (ggml_fp16_t *)((char *) mask->data + (iq1 + i)*mask->nb[1]) : NULL;
+
+                    const float mv = mp ? slope*GGML_FP16_TO_FP32(mp[ic0 + ic]) : 0.0f;
+                    if (mv == -INFINITY) {
+                        KQ[i*BC + ic] = -INFINITY;
+                        continue;
+                    }
+
+                    float s; // KQ value
+
+                    kq_vec_dot(DK, &s, 0, k_data, 0, Q_q + i*DK, 0, 1);
+
+                    s = s*scale; // scale KQ value
+
+                    if (logit_softcap != 0.0f) {
+                        s = logit_softcap*tanhf(s);
+                    }
+
+                    KQ[i*BC + ic] = s + mv; // apply mask
+                }
+            }
+
+            // KQ = expf(KQ - M) with the new maximum of each row, and rescale what was accumulated so far
+            for (int64_t i = 0; i < nq; ++i) {
+                float * kq = KQ + i*BC;
+
+                float Mnew;
+                ggml_vec_max_f32(nc, &Mnew, kq);
+                Mnew = MAX(Mnew, M[i]);
+
+                if (Mnew == -INFINITY) {
+                    // everything masked so far
+                    memset(kq, 0, nc*sizeof(float));
+                    continue;
+                }
+
+                const float ms = expf(M[i] - Mnew);
+                if (ms != 1.0f) {
+                    ggml_vec_scale_f32(DV, VKQ + i*DV, ms);
+                }
+
+                const ggml_float sum = ggml_vec_soft_max_f32(nc, kq, kq, Mnew);
+
+                S[i] = S[i]*ms + (float) sum;
+                M[i] = Mnew;
+            }
+
+            // VKQ += KQ*V for the block, each V row is converted once for all the q rows of the tile
+            for (int64_t ic = 0; ic < nc; ++ic) {
+                bool used = false;
+                for (int64_t i = 0; i < nq; ++i) {
+                    used = used || KQ[i*BC + ic] != 0.0f;
+                }
+                if (!used) {
+                    continue;
+                }
+
+                const char * v_data = (const char *) v->data + ((ic0 + ic)*nbv1 + iv2*nbv2 + iv3*nbv3);
+
+                const float * vr = (const float *) v_data;
+                if (v->type != GGML_TYPE_F32) {
+                    ggml_fa_v_to_float(v->type, v_data, V32, DV);
+                    vr = V32;
+                }
+
+                for (int64_t i = 0; i < nq; ++i) {
+                    const float vs = KQ[i*BC + ic];
+                    if (vs != 0.0f) {
+                        ggml_vec_mad_f32(DV, VKQ + i*DV, vr, vs);
+                    }
+                }
+            }
+        }
+
+        for (int64_t i = 0; i < nq; ++i) {
+            // V /= S
+            const float S_inv = 1.0f/S[i];
+            ggml_vec_scale_f32(DV, VKQ + i*DV, S_inv);
+
+            // dst indices
+            const int64_t i1 = iq1 + i;
+            const int64_t i2 = iq2;
+            const int64_t i3 = iq3;
+
+            // permute(0, 2, 1, 3)
+            memcpy((char *) dst->data + (i3*ne2*ne1 + i2 + i1*ne1)*nb1, VKQ + i*DV, nb1);
+        }
+    }
 }
 
 void ggml_compute_forward_flash_attn_ext(
@@ -7176,7 +7682,11 @@ void ggml_compute_forward_flash_attn_ext(
         case GGML_PREC_F32:
             {
                 // uses F32 accumulators
-                ggml_compute_forward_flash_attn_ext_f16(params, q, k, v, mask, dst);
+                if (q->ne[1] > 1) {
+                    ggml_compute_forward_flash_attn_ext_f16_tiled(params, q, k, v, mask, dst);
+                } else {
+                    ggml_compute_forward_flash_attn_ext_f16(params, q, k, v, mask, dst);
+                }
             } break;
         default:
             {
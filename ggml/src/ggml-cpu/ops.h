@@ -20,6 +20,19 @@
 
 static const size_t CACHE_LINE_SIZE_F32 = CACHE_LINE_SIZE/sizeof(float);
 
+//
+// flash attention
+//
+
+// query rows x KV rows per tile of the tiled flash attention
+#define GGML_FA_TILE_Q  8
+#define GGML_FA_TILE_KV 64
+
+// split-KV flash attention for single query rows: tasks per thread to aim for, and the
+// shortest KV split worth the merge of the partial results
+#define GGML_FA_SPLIT_TASKS  4
+#define GGML_FA_SPLIT_KV_MIN 256
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +53,8 @@ void ggml_compute_forward_silu_back(const struct ggml_compute_params * params, s
 void ggml_compute_forward_norm(const struct ggml_compute_params * params, struct ggml_tensor * dst);
 void ggml_compute_forward_rms_norm(const struct ggml_compute_params * params, struct ggml_tensor * dst);
 void ggml_compute_forward_rms_norm_back(const struct ggml_compute_params * params, struct ggml_tensor * dst);
+void ggml_compute_forward_add_rms_norm_mul(const struct ggml_compute_params * params, struct ggml_tensor * add, struct ggml_tensor * norm, struct ggml_tensor * mul);
+void ggml_compute_forward_silu_mul(const struct ggml_compute_params * params, struct ggml_tensor * silu, struct ggml_tensor * mul);
 void ggml_compute_forward_group_norm(const struct ggml_compute_params * params, struct ggml_tensor * dst);
 void ggml_compute_forward_l2_norm(const struct ggml_compute_params * params, struct ggml_tensor * dst);
 void ggml_compute_forward_out_prod(const struct ggml_compute_params * params, struct ggml_tensor * dst);
@@ -83,6 +98,7 @@ void ggml_compute_forward_flash_attn_ext(
     const struct ggml_tensor * v,
     const struct ggml_tensor * mask,
     struct ggml_tensor * dst);
+int64_t ggml_flash_attn_ext_n_kv_split(const struct ggml_tensor * dst, int nth);
 void ggml_compute_forward_flash_attn_back(
         const struct ggml_compute_params * params,
         const bool masked,
@@ -199,6 +199,180 @@ template <> void ggml_quantize_mat_t<8, GGML_TYPE_Q8_K>(const float * GGML_RESTR
     ggml_quantize_mat_q8_K_4x8(x, vy, n_per_row);
 }
 
+// Q2_K, Q3_K, Q5_K and Q6_K are all evaluated the same way: unsigned quants, one scale per group of 16
+// and a per-group offset that is applied through the q8_K bsums (the mins for Q2_K/Q5_K, 4*scale / 32*scale
+// for the signed Q3_K/Q6_K quants)
+struct block_kx8_unpacked {
+    float   d[8];         // multiplier of the group scales
+    float   dmin[8];      // multiplier of the group offsets
+    int16_t sc[8][16];    // group scales
+    int16_t mn[8][16];    // group offsets
+    uint8_t q[8][QK_K];   // unsigned quants
+};
+
+// byte `i` of row `j` in a block interleaved 8 bytes at a time
+static inline int kx8_index(int j, int i) {
+    return (i / 8) * 64 + j * 8 + (i % 8);
+}
+
+static void unpack_block_x8(const block_q2_Kx8 & in, block_kx8_unpacked & out) {
+    for (int j = 0; j < 8; j++) {
+        out.d[j]    = GGML_FP16_TO_FP32(in.d[j]);
+        out.dmin[j] = GGML_FP16_TO_FP32(in.dmin[j]);
+        for (int g = 0; g < 16; g++) {
+            out.sc[j][g] = in.scales[g * 8 + j] & 0xF;
+            out.mn[j][g] = in.scales[g * 8 + j] >> 4;
+        }
+        for (int v = 0; v < QK_K; v++) {
+            const int shift = 2 * ((v % 128) / 32);
+            out.q[j][v] = (in.qs[kx8_index(j, (v / 128) * 32 + v % 32)] >> shift) & 3;
+        }
+    }
+}
+
+static void unpack_block_x8(const block_q3_Kx8 & in, block_kx8_unpacked & out) {
+    for (int j = 0; j < 8; j++) {
+        out.d[j]    = GGML_FP16_TO_FP32(in.d[j]);
+        out.dmin[j] = out.d[j];
+        for (int g = 0; g < 16; g++) {
+            const int lo = (in.scales[g * 4 + j % 4] >> (4 * (j / 4))) & 0xF;
+            const int hi = (in.scales[64 + g * 2 + j / 4] >> (2 * (j % 4))) & 3;
+            out.sc[j][g] = (lo | (hi << 4)) - 32;
+            out.mn[j][g] = 4 * out.sc[j][g];
+        }
+        for (int v = 0; v < QK_K; v++) {
+            const int shift = 2 * ((v % 128) / 32);
+            const int lo = (in.qs[kx8_index(j, (v / 128) * 32 + v % 32)] >> shift) & 3;
+            const int hi = (in.hmask[kx8_index(j, v % 32)] >> (v / 32)) & 1;
+            out.q[j][v] = lo | (hi << 2);
+        }
+    }
+}
+
+static void unpack_block_x8(const block_q5_Kx8 & in, block_kx8_unpacked & out) {
+    static const uint32_t kmask1 = 0x3f3f3f3f;
+    static const uint32_t kmask2 = 0x0f0f0f0f;
+    static const uint32_t kmask3 = 0x03030303;
+
+    // same scales layout as block_q4_Kx8: 16 bytes per sub-block, the 8 scales followed by the 8 mins
+    uint32_t utmp[32];
+    for (int sb = 0; sb < 8; sb++) {
+        memcpy(utmp + sb * 4, in.scales + sb * 12, 12);
+        utmp[sb * 4 + 3] = ((utmp[sb * 4 + 2] >> 4) & kmask2) | (((utmp[sb * 4 + 1] >> 6) & kmask3) << 4);
+        const uint32_t uaux_0 = utmp[sb * 4 + 1] & kmask1;
+        utmp[sb * 4 + 1] = (utmp[sb * 4 + 2] & kmask2) | (((utmp[sb * 4 + 0] >> 6) & kmask3) << 4);
+        utmp[sb * 4 + 2] = uaux_0;
+        utmp[sb * 4 + 0] &= kmask1;
+    }
+    const uint8_t * scales = (const uint8_t *) utmp;
+
+    for (int j = 0; j < 8; j++) {
+        out.d[j]    = GGML_FP16_TO_FP32(in.d[j]);
+        out.dmin[j] = GGML_FP16_TO_FP32(in.dmin[j]);
+        for (int g = 0; g < 16; g++) {
+            out.sc[j][g] = scales[(g / 2) * 16 + j];
+            out.mn[j][g] = scales[(g / 2) * 16 + 8 + j];
+        }
+        for (int v = 0; v < QK_K; v++) {
+            const int shift = 4 * ((v % 64) / 32);
+            const int lo = (in.qs[kx8_index(j, (v / 64) * 32 + v % 32)] >> shift) & 0xF;
+            const int hi = (in.qh[kx8_index(j, v % 32)] >> (v / 32)) & 1;
+            out.q[j][v] = lo | (hi << 4);
+        }
+    }
+}
+
+static void unpack_block_x8(const block_q6_Kx8 & in, block_kx8_unpacked & out) {
+    for (int j = 0; j < 8; j++) {
+        out.d[j]    = GGML_FP16_TO_FP32(in.d[j]);
+        out.dmin[j] = out.d[j];
+        for (int g = 0; g < 16; g++) {
+            out.sc[j][g] = in.scales[g * 8 + j];
+            out.mn[j][g] = 32 * out.sc[j][g];
+        }
+        for (int v = 0; v < QK_K; v++) {
+            const int h = v / 128;
+            const int r = v % 128;
+            const int lo = (in.ql[kx8_index(j, h * 64 + ((r / 32) % 2) * 32 + r % 32)] >> (4 * (r / 64))) & 0xF;
+            const int hi = (in.qh[kx8_index(j, h * 32 + r % 32)] >> (2 * (r / 32))) & 3;
+            out.q[j][v] = lo | (hi << 4);
+        }
+    }
+}
+
+template <typename BLOC_TYPE>
+static void gemv_kx8_q8_K_generic(int n, float * GGML_RESTRICT s, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nc) {
+    const int nb = n / QK_K;
+
+    block_kx8_unpacked b;
+    float sumf[8];
+
+    const block_q8_K * a_ptr = (const block_q8_K *) vy;
+    for (int x = 0; x < nc / 8; x++) {
+        const BLOC_TYPE * b_ptr = (const BLOC_TYPE *) vx + (x * nb);
+
+        for (int j = 0; j < 8; j++) sumf[j] = 0.0;
+        for (int l = 0; l < nb; l++) {
+            unpack_block_x8(b_ptr[l], b);
+            for (int j = 0; j < 8; j++) {
+                int sumi = 0;
+                int summ = 0;
+                for (int g = 0; g < 16; g++) {
+                    int sumg = 0;
+                    for (int i = 0; i < 16; i++) {
+                        sumg += b.q[j][g * 16 + i] * a_ptr[l].qs[g * 16 + i];
+                    }
+                    sumi += sumg * b.sc[j][g];
+                    summ += b.mn[j][g] * a_ptr[l].bsums[g];
+                }
+                sumf[j] += (sumi * b.d[j] - summ * b.dmin[j]) * a_ptr[l].d;
+            }
+        }
+        for (int j = 0; j < 8; j++) s[x * 8 + j] = sumf[j];
+    }
+}
+
+template <typename BLOC_TYPE>
+static void gemm_kx8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int nb = n / QK_K;
+
+    block_kx8_unpacked b;
+    float sumf[4][8];
+
+    for (int y = 0; y < nr / 4; y++) {
+        const block_q8_Kx4 * a_ptr = (const block_q8_Kx4 *) vy + (y * nb);
+        for (int x = 0; x < nc / 8; x++) {
+            const BLOC_TYPE * b_ptr = (const BLOC_TYPE *) vx + (x * nb);
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < 8; j++) sumf[m][j] = 0.0;
+            }
+            for (int l = 0; l < nb; l++) {
+                unpack_block_x8(b_ptr[l], b);
+                for (int m = 0; m < 4; m++) {
+                    for (int j = 0; j < 8; j++) {
+                        int sumi = 0;
+                        int summ = 0;
+                        for (int g = 0; g < 16; g++) {
+                            int sumg = 0;
+                            for (int i = 0; i < 16; i++) {
+                                const int v = g * 16 + i;
+                                sumg += b.q[j][v] * a_ptr[l].qs[(v / 8) * 32 + m * 8 + v % 8];
+                            }
+                            sumi += sumg * b.sc[j][g];
+                            summ += b.mn[j][g] * a_ptr[l].bsums[(g / 4) * 16 + m * 4 + g % 4];
+                        }
+                        sumf[m][j] += (sumi * b.d[j] - summ * b.dmin[j]) * a_ptr[l].d[m];
+                    }
+                }
+            }
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < 8; j++)
+                    s[(y * 4 + m) * bs + x * 8 + j] = sumf[m][j];
+            }
+        }
+    }
+}
+
 extern "C" {
 
 void ggml_gemv_q4_0_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
@@ -417,6 +591,50 @@ void ggml_gemv_q4_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs,
 }
 GGML_CPU_NATIVE_IMPL(ggml_gemv_q4_K_8x8_q8_K)
 
+void ggml_gemv_q2_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K_generic<block_q2_Kx8>(n, s, vx, vy, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemv_q2_K_8x8_q8_K)
+
+void ggml_gemv_q3_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K_generic<block_q3_Kx8>(n, s, vx, vy, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemv_q3_K_8x8_q8_K)
+
+void ggml_gemv_q5_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K_generic<block_q5_Kx8>(n, s, vx, vy, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemv_q5_K_8x8_q8_K)
+
+void ggml_gemv_q6_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nc % 8 == 0);
+
+    UNUSED(bs);
+    UNUSED(nr);
+
+    gemv_kx8_q8_K_generic<block_q6_Kx8>(n, s, vx, vy, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemv_q6_K_8x8_q8_K)
+
 void ggml_gemv_iq4_nl_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK8_0;
     const int nb = n / qk;
@@ -464,6 +682,49 @@ void ggml_gemv_iq4_nl_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs
 }
 GGML_CPU_NATIVE_IMPL(ggml_gemv_iq4_nl_4x4_q8_0)
 
+void ggml_gemv_q8_0_8x8_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(s);
+    UNUSED(bs);
+    UNUSED(vx);
+    UNUSED(vy);
+    UNUSED(nr);
+    UNUSED(nc);
+    UNUSED(nb);
+    UNUSED(ncols_interleaved);
+    UNUSED(blocklen);
+
+    float sumf[8];
+    int sumi;
+
+    const block_q8_0 * a_ptr = (const block_q8_0 *) vy;
+    for (int x = 0; x < nc / ncols_interleaved; x++) {
+        const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+
+        for (int j = 0; j < ncols_interleaved; j++) sumf[j] = 0.0;
+        for (int l = 0; l < nb; l++) {
+            for (int j = 0; j < ncols_interleaved; j++) {
+                sumi = 0;
+                for (int k = 0; k < (qk / blocklen); k++) {
+                    for (int i = 0; i < blocklen; ++i) {
+                        sumi += b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i] * a_ptr[l].qs[k * blocklen + i];
+                    }
+                }
+                sumf[j] += sumi * GGML_FP16_TO_FP32(b_ptr[l].d[j]) * GGML_FP16_TO_FP32(a_ptr[l].d);
+            }
+        }
+        for (int j = 0; j < ncols_interleaved; j++) s[x * ncols_interleaved + j] = sumf[j];
+    }
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemv_q8_0_8x8_q8_0)
+
 void ggml_gemm_q4_0_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK8_0;
     const int nb = n / qk;
@@ -721,6 +982,42 @@ void ggml_gemm_q4_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs,
 }
 GGML_CPU_NATIVE_IMPL(ggml_gemm_q4_K_8x8_q8_K)
 
+void ggml_gemm_q2_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+    gemm_kx8_q8_K_generic<block_q2_Kx8>(n, s, bs, vx, vy, nr, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemm_q2_K_8x8_q8_K)
+
+void ggml_gemm_q3_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+    gemm_kx8_q8_K_generic<block_q3_Kx8>(n, s, bs, vx, vy, nr, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemm_q3_K_8x8_q8_K)
+
+void ggml_gemm_q5_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+    gemm_kx8_q8_K_generic<block_q5_Kx8>(n, s, bs, vx, vy, nr, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemm_q5_K_8x8_q8_K)
+
+void ggml_gemm_q6_K_8x8_q8_K_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    assert (n % QK_K == 0);
+    assert (nr % 4 == 0);
+    assert (nc % 8 == 0);
+
+    gemm_kx8_q8_K_generic<block_q6_Kx8>(n, s, bs, vx, vy, nr, nc);
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemm_q6_K_8x8_q8_K)
+
 void ggml_gemm_iq4_nl_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
     const int qk = QK8_0;
     const int nb = n / qk;
@@ -778,6 +1075,59 @@ void ggml_gemm_iq4_nl_4x4_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs
 }
 GGML_CPU_NATIVE_IMPL(ggml_gemm_iq4_nl_4x4_q8_0)
 
+void ggml_gemm_q8_0_8x8_q8_0_generic(int n, float * GGML_RESTRICT s, size_t bs, const void * GGML_RESTRICT vx, const void * GGML_RESTRICT vy, int nr, int nc) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+    const int ncols_interleaved = 8;
+    const int blocklen = 8;
+
+    assert (n % qk == 0);
+    assert (nr % 4 == 0);
+    assert (nc % ncols_interleaved == 0);
+
+    UNUSED(s);
+    UNUSED(bs);
+    UNUSED(vx);
+    UNUSED(vy);
+    UNUSED(nr);
+    UNUSED(nc);
+    UNUSED(nb);
+    UNUSED(ncols_interleaved);
+    UNUSED(blocklen);
+
+    float sumf[4][8];
+    int sumi;
+
+    for (int y = 0; y < nr / 4; y++) {
+        const block_q8_0x4 * a_ptr = (const block_q8_0x4 *) vy + (y * nb);
+        for (int x = 0; x < nc / ncols_interleaved; x++) {
+            const block_q8_0x8 * b_ptr = (const block_q8_0x8 *) vx + (x * nb);
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++) sumf[m][j] = 0.0;
+            }
+            for (int l = 0; l < nb; l++) {
+                for (int m = 0; m < 4; m++) {
+                    for (int j = 0; j < ncols_interleaved; j++) {
+                        sumi = 0;
+                        for (int k = 0; k < (qk / blocklen); k++) {
+                            for (int i = 0; i < blocklen; ++i) {
+                                sumi += b_ptr[l].qs[k * ncols_interleaved * blocklen + j * blocklen + i] *
+                                        a_ptr[l].qs[k * 4 * blocklen + m * blocklen + i];
+                            }
+                        }
+                        sumf[m][j] += sumi * GGML_FP16_TO_FP32(b_ptr[l].d[j]) * GGML_FP16_TO_FP32(a_ptr[l].d[m]);
+                    }
+                }
+            }
+            for (int m = 0; m < 4; m++) {
+                for (int j = 0; j < ncols_interleaved; j++)
+                    s[(y * 4 + m) * bs + x * ncols_interleaved + j] = sumf[m][j];
+            }
+        }
+    }
+}
+GGML_CPU_NATIVE_IMPL(ggml_gemm_q8_0_8x8_q8_0)
+
 } // extern "C"
 
 static block_q4_0x4 make_block_q4_0x4(block_q4_0 * in, unsigned int blck_size_interleave) {
@@ -849,6 +1199,58 @@ static block_q4_0x8 make_block_q4_0x8(block_q4_0 * in, unsigned int blck_size_in
     return out;
 }
 
+// The below logic is designed so as to unpack and rearrange scales and mins values in Q4_K / Q5_K
+template <typename BLOC_TYPE>
+static void make_scales_q4_Kx8(uint8_t * out_scales, const BLOC_TYPE * in) {
+    // Currently the Q4_K structure has 8 scales and 8 mins packed in 12 bytes ( 6 bits for each value)
+    // The output Q4_Kx8 structure has 96 bytes
+    // Every 12 byte is packed such that it contains scales and mins for corresponding sub blocks from Q4_K structure
+    // For eg - First 12 bytes contains 8 scales and 8 mins - each of first sub block from different Q4_K structures
+    uint8_t s[8], m[8];
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            s[j] = in[j].scales[i] & 63;
+            m[j] = in[j].scales[i + 4] & 63;
+        }
+
+        out_scales[i * 12]      = (s[0] & 63) + ((s[4] & 48) << 2);
+        out_scales[i * 12 + 1]  = (s[1] & 63) + ((s[5] & 48) << 2);
+        out_scales[i * 12 + 2]  = (s[2] & 63) + ((s[6] & 48) << 2);
+        out_scales[i * 12 + 3]  = (s[3] & 63) + ((s[7] & 48) << 2);
+        out_scales[i * 12 + 4]  = (m[0] & 63) + ((m[4] & 48) << 2);
+        out_scales[i * 12 + 5]  = (m[1] & 63) + ((m[5] & 48) << 2);
+        out_scales[i * 12 + 6]  = (m[2] & 63) + ((m[6] & 48) << 2);
+        out_scales[i * 12 + 7]  = (m[3] & 63) + ((m[7] & 48) << 2);
+        out_scales[i * 12 + 8]  = (s[4] & 15) + ((m[4] & 15) << 4);
+        out_scales[i * 12 + 9]  = (s[5] & 15) + ((m[5] & 15) << 4);
+        out_scales[i * 12 + 10] = (s[6] & 15) + ((m[6] & 15) << 4);
+        out_scales[i * 12 + 11] = (s[7] & 15) + ((m[7] & 15) << 4);
+
+    }
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            s[j] = ((in[j].scales[i] & 192) >> 2) | (in[j].scales[i+8] & 15);
+            m[j] = ((in[j].scales[i + 4] & 192) >> 2) | ((in[j].scales[i+8] & 240) >> 4);
+        }
+
+        out_scales[i * 12 + 48] = (s[0] & 63) + ((s[4] & 48) << 2);
+        out_scales[i * 12 + 49] = (s[1] & 63) + ((s[5] & 48) << 2);
+        out_scales[i * 12 + 50] = (s[2] & 63) + ((s[6] & 48) << 2);
+        out_scales[i * 12 + 51] = (s[3] & 63) + ((s[7] & 48) << 2);
+        out_scales[i * 12 + 52] = (m[0] & 63) + ((m[4] & 48) << 2);
+        out_scales[i * 12 + 53] = (m[1] & 63) + ((m[5] & 48) << 2);
+        out_scales[i * 12 + 54] = (m[2] & 63) + ((m[6] & 48) << 2);
+        out_scales[i * 12 + 55] = (m[3] & 63) + ((m[7] & 48) << 2);
+        out_scales[i * 12 + 56] = (s[4] & 15) + ((m[4] & 15) << 4);
+        out_scales[i * 12 + 57] = (s[5] & 15) + ((m[5] & 15) << 4);
+        out_scales[i * 12 + 58] = (s[6] & 15) + ((m[6] & 15) << 4);
+        out_scales[i * 12 + 59] = (s[7] & 15) + ((m[7] & 15) << 4);
+
+    }
+}
+
 static block_q4_Kx8 make_block_q4_Kx8(block_q4_K * in, unsigned int blck_size_interleave) {
     block_q4_Kx8 out;
     //Delta(scale) and dmin values of the eight Q4_K structures are copied onto the output interleaved structure
@@ -873,55 +1275,109 @@ static block_q4_Kx8 make_block_q4_Kx8(block_q4_K * in, unsigned int blck_size_in
         memcpy(&out.qs[dst_offset], &elems, sizeof(uint64_t));
     }
 
-    // The below logic is designed so as to unpack and rearrange scales and mins values in Q4_K
-    // Currently the Q4_K structure has 8 scales and 8 mins packed in 12 bytes ( 6 bits for each value)
-    // The output Q4_Kx8 structure has 96 bytes
-    // Every 12 byte is packed such that it contains scales and mins for corresponding sub blocks from Q4_K structure
-    // For eg - First 12 bytes contains 8 scales and 8 mins - each of first sub block from different Q4_K structures
-    uint8_t s[8], m[8];
+    make_scales_q4_Kx8(out.scales, in);
 
-    for (int i = 0; i < 4; i++) {
+    return out;
+}
+
+// Interleave a quant array of 8 K-quant blocks 8 bytes at a time: bytes [8k, 8k + 8) of row j go to out[(8k + j) * 8]
+template <typename BLOC_TYPE>
+static void interleave_kx8(uint8_t * out, const BLOC_TYPE * in, size_t offset, int nbytes) {
+    for (int k = 0; k < nbytes / 8; k++) {
         for (int j = 0; j < 8; j++) {
-            s[j] = in[j].scales[i] & 63;
-            m[j] = in[j].scales[i + 4] & 63;
+            memcpy(out + (k * 8 + j) * 8, (const uint8_t *) (in + j) + offset + k * 8, 8);
         }
+    }
+}
 
-        out.scales[i * 12]      = (s[0] & 63) + ((s[4] & 48) << 2);
-        out.scales[i * 12 + 1]  = (s[1] & 63) + ((s[5] & 48) << 2);
-        out.scales[i * 12 + 2]  = (s[2] & 63) + ((s[6] & 48) << 2);
-        out.scales[i * 12 + 3]  = (s[3] & 63) + ((s[7] & 48) << 2);
-        out.scales[i * 12 + 4]  = (m[0] & 63) + ((m[4] & 48) << 2);
-        out.scales[i * 12 + 5]  = (m[1] & 63) + ((m[5] & 48) << 2);
-        out.scales[i * 12 + 6]  = (m[2] & 63) + ((m[6] & 48) << 2);
-        out.scales[i * 12 + 7]  = (m[3] & 63) + ((m[7] & 48) << 2);
-        out.scales[i * 12 + 8]  = (s[4] & 15) + ((m[4] & 15) << 4);
-        out.scales[i * 12 + 9]  = (s[5] & 15) + ((m[5] & 15) << 4);
-        out.scales[i * 12 + 10] = (s[6] & 15) + ((m[6] & 15) << 4);
-        out.scales[i * 12 + 11] = (s[7] & 15) + ((m[7] & 15) << 4);
+static block_q2_Kx8 make_block_q2_Kx8(block_q2_K * in) {
+    block_q2_Kx8 out;
 
+    for (int i = 0; i < 8; i++) {
+        out.d[i]    = in[i].GGML_COMMON_AGGR_U.GGML_COMMON_AGGR_S.d;
+        out.dmin[i] = in[i].GGML_COMMON_AGGR_U.GGML_COMMON_AGGR_S.dmin;
     }
 
-    for (int i = 0; i < 4; i++) {
-        for (int j = 0; j < 8; j++) {
-            s[j] = ((in[j].scales[i] & 192) >> 2) | (in[j].scales[i+8] & 15);
-            m[j] = ((in[j].scales[i + 4] & 192) >> 2) | ((in[j].scales[i+8] & 240) >> 4);
+    // one byte per row and sub-block, sub-block major
+    for (int g = 0; g < QK_K / 16; g++) {
+        for (int i = 0; i < 8; i++) {
+            out.scales[g * 8 + i] = in[i].scales[g];
+        }
+    }
+
+    interleave_kx8(out.qs, in, offsetof(block_q2_K, qs), QK_K / 4);
+
+    return out;
+}
+
+static block_q3_Kx8 make_block_q3_Kx8(block_q3_K * in) {
+    static const uint32_t kmask1 = 0x03030303;
+    static const uint32_t kmask2 = 0x0f0f0f0f;
+
+    block_q3_Kx8 out;
+
+    for (int i = 0; i < 8; i++) {
+        out.d[i] = in[i].d;
+    }
+
+    // The 16 6-bit scales of each row are unpacked and stored sub-block major:
+    // low nibbles of rows 0-3 / 4-7 in the first 64 bytes, the upper 2 bits in the last 32
+    memset(out.scales, 0, sizeof(out.scales));
+    for (int i = 0; i < 8; i++) {
+        uint32_t aux[4];
+        memcpy(aux, in[i].scales, 12);
+        const uint32_t tmp = aux[2];
+        aux[2] = ((aux[0] >> 4) & kmask2) | (((tmp >> 4) & kmask1) << 4);
+        aux[3] = ((aux[1] >> 4) & kmask2) | (((tmp >> 6) & kmask1) << 4);
+        aux[0] = (aux[0] & kmask2) | (((tmp >> 0) & kmask1) << 4);
+        aux[1] = (aux[1] & kmask2) | (((tmp >> 2) & kmask1) << 4);
+        const uint8_t * sc = (const uint8_t *) aux;
+
+        for (int g = 0; g < QK_K / 16; g++) {
+            out.scales[g * 4 + i % 4]      |= (sc[g] & 0xF) << (4 * (i / 4));
+            out.scales[64 + g * 2 + i / 4] |= (sc[g] >> 4) << (2 * (i % 4));
         }
+    }
+
+    interleave_kx8(out.hmask, in, offsetof(block_q3_K, hmask), QK_K / 8);
+    interleave_kx8(out.qs,    in, offsetof(block_q3_K, qs),    QK_K / 4);
+
+    return out;
+}
 
-        out.scales[i * 12 + 48] = (s[0] & 63) + ((s[4] & 48) << 2);
-        out.scales[i * 12 + 49] = (s[1] & 63) + ((s[5] & 48) << 2);
-        out.scales[i * 12 + 50] = (s[2] & 63) + ((s[6] & 48) << 2);
-        out.scales[i * 12 + 51] = (s[3] & 63) + ((s[7] & 48) << 2);
-        out.scales[i * 12 + 52] = (m[0] & 63) + ((m[4] & 48) << 2);
-        out.scales[i * 12 + 53] = (m[1] & 63) + ((m[5] & 48) << 2);
-        out.scales[i * 12 + 54] = (m[2] & 63) + ((m[6] & 48) << 2);
-        out.scales[i * 12 + 55] = (m[3] & 63) + ((m[7] & 48) << 2);
-        out.scales[i * 12 + 56] = (s[4] & 15) + ((m[4] & 15) << 4);
-        out.scales[i * 12 + 57] = (s[5] & 15) + ((m[5] & 15) << 4);
-        out.scales[i * 12 + 58] = (s[6] & 15) + ((m[6] & 15) << 4);
-        out.scales[i * 12 + 59] = (s[7] & 15) + ((m[7] & 15) << 4);
+static block_q5_Kx8 make_block_q5_Kx8(block_q5_K * in) {
+    block_q5_Kx8 out;
 
+    for (int i = 0; i < 8; i++) {
+        out.d[i]    = in[i].GGML_COMMON_AGGR_U.GGML_COMMON_AGGR_S.d;
+        out.dmin[i] = in[i].GGML_COMMON_AGGR_U.GGML_COMMON_AGGR_S.dmin;
     }
 
+    make_scales_q4_Kx8(out.scales, in);
+
+    interleave_kx8(out.qh, in, offsetof(block_q5_K, qh), QK_K / 8);
+    interleave_kx8(out.qs, in, offsetof(block_q5_K, qs), QK_K / 2);
+
+    return out;
+}
+
+static block_q6_Kx8 make_block_q6_Kx8(block_q6_K * in) {
+    block_q6_Kx8 out;
+
+    for (int i = 0; i < 8; i++) {
+        out.d[i] = in[i].d;
+    }
+
+    // one byte per row and sub-block, sub-block major
+    for (int g = 0; g < QK_K / 16; g++) {
+        for (int i = 0; i < 8; i++) {
+            out.scales[g * 8 + i] = in[i].scales[g];
+        }
+    }
+
+    interleave_kx8(out.qh, in, offsetof(block_q6_K, qh), QK_K / 4);
+    interleave_kx8(out.ql, in, offsetof(block_q6_K, ql), QK_K / 2);
+
     return out;
 }
 
@@ -986,6 +1442,36 @@ static int repack_q4_K_to_q4_K_8_bl(struct ggml_tensor * t, int interleave_block
     GGML_UNUSED(data_size);
 }
 
+template <typename BLOC_TYPE, typename BLOC_TYPE_X8>
+static int repack_kquant_to_kquant_8_bl(struct ggml_tensor * t, BLOC_TYPE_X8 (*make_block)(BLOC_TYPE *), const void * GGML_RESTRICT data, size_t data_size) {
+    constexpr int nrows_interleaved = 8;
+
+    BLOC_TYPE_X8 * dst = (BLOC_TYPE_X8 *) t->data;
+    const BLOC_TYPE * src = (const BLOC_TYPE *) data;
+    BLOC_TYPE dst_tmp[8];
+    int nrow = ggml_nrows(t);
+    int nblocks = t->ne[0] / QK_K;
+
+    GGML_ASSERT(data_size == nrow * nblocks * sizeof(BLOC_TYPE));
+
+    if (t->ne[1] % nrows_interleaved != 0 || t->ne[0] % QK_K != 0) {
+        return -1;
+    }
+
+    for (int b = 0; b < nrow; b += nrows_interleaved) {
+        for (int64_t x = 0; x < nblocks; x++) {
+            for (int i = 0; i < nrows_interleaved; i++) {
+                dst_tmp[i] = src[x + i * nblocks];
+            }
+            *dst++ = make_block(dst_tmp);
+        }
+        src += nrows_interleaved * nblocks;
+    }
+    return 0;
+
+    GGML_UNUSED(data_size);
+}
+
 static int repack_q4_0_to_q4_0_8_bl(struct ggml_tensor * t, int interleave_block, const void * GGML_RESTRICT data, size_t data_size) {
     GGML_ASSERT(t->type == GGML_TYPE_Q4_0);
     GGML_ASSERT(interleave_block == 8);
@@ -1017,6 +1503,60 @@ static int repack_q4_0_to_q4_0_8_bl(struct ggml_tensor * t, int interleave_block
     GGML_UNUSED(data_size);
 }
 
+// interleave N block_q8_0s in blocks of blck_size_interleave
+// returns an interleaved block_q8_0xN with the deltas of the N blocks first, then
+// the quants of the N blocks interleaved in blocks of blck_size_interleave bytes
+template <int N> static block<8, N> make_block_q8_0xN(block_q8_0 * in, unsigned int blck_size_interleave) {
+    block<8, N> out;
+
+    for (int i = 0; i < N; i++) {
+        out.d[i] = in[i].d;
+    }
+
+    const int end = QK8_0 * N / blck_size_interleave;
+
+    for (int i = 0; i < end; ++i) {
+        int src_id = i % N;
+        int src_offset = (i / N) * blck_size_interleave;
+        int dst_offset = i * blck_size_interleave;
+
+        memcpy(&out.qs[dst_offset], &in[src_id].qs[src_offset], blck_size_interleave);
+    }
+
+    return out;
+}
+
+template <int N> static int repack_q8_0_to_q8_0_N_bl(struct ggml_tensor * t, int interleave_block, const void * GGML_RESTRICT data, size_t data_size) {
+    GGML_ASSERT(t->type == GGML_TYPE_Q8_0);
+    GGML_ASSERT(interleave_block == 4 || interleave_block == 8);
+    constexpr int nrows_interleaved = N;
+
+    block<8, N> * dst = (block<8, N> *)t->data;
+    const block_q8_0 * src = (const block_q8_0 *)data;
+    block_q8_0 dst_tmp[N];
+    int nrow = ggml_nrows(t);
+    int nblocks = t->ne[0] / QK8_0;
+
+    GGML_ASSERT(data_size == nrow * nblocks * sizeof(block_q8_0));
+
+    if (t->ne[1] % nrows_interleaved != 0) {
+        return -1;
+    }
+
+    for (int b = 0; b < nrow; b += nrows_interleaved) {
+        for (int64_t x = 0; x < nblocks; x++) {
+            for (int i = 0; i < nrows_interleaved; i++) {
+                dst_tmp[i] = src[x + i * nblocks];
+            }
+            *dst++ = make_block_q8_0xN<N>(dst_tmp, interleave_block);
+        }
+        src += nrows_interleaved * nblocks;
+    }
+    return 0;
+
+    GGML_UNUSED(data_size);
+}
+
 static block_iq4_nlx4 make_block_iq4_nlx4(block_iq4_nl * in, unsigned int blck_size_interleave) {
     block_iq4_nlx4 out;
 
@@ -1106,10 +1646,34 @@ template <> int repack<block_q4_K, 8, 8>(struct ggml_tensor * t, const void * da
     return repack_q4_K_to_q4_K_8_bl(t, 8, data, data_size);
 }
 
+template <> int repack<block_q2_K, 8, 8>(struct ggml_tensor * t, const void * data, size_t data_size) {
+    GGML_ASSERT(t->type == GGML_TYPE_Q2_K);
+    return repack_kquant_to_kquant_8_bl(t, make_block_q2_Kx8, data, data_size);
+}
+
+template <> int repack<block_q3_K, 8, 8>(struct ggml_tensor * t, const void * data, size_t data_size) {
+    GGML_ASSERT(t->type == GGML_TYPE_Q3_K);
+    return repack_kquant_to_kquant_8_bl(t, make_block_q3_Kx8, data, data_size);
+}
+
+template <> int repack<block_q5_K, 8, 8>(struct ggml_tensor * t, const void * data, size_t data_size) {
+    GGML_ASSERT(t->type == GGML_TYPE_Q5_K);
+    return repack_kquant_to_kquant_8_bl(t, make_block_q5_Kx8, data, data_size);
+}
+
+template <> int repack<block_q6_K, 8, 8>(struct ggml_tensor * t, const void * data, size_t data_size) {
+    GGML_ASSERT(t->type == GGML_TYPE_Q6_K);
+    return repack_kquant_to_kquant_8_bl(t, make_block_q6_Kx8, data, data_size);
+}
+
 template <> int repack<block_iq4_nl, 4, 4>(struct ggml_tensor * t, const void * data, size_t data_size) {
     return repack_iq4_nl_to_iq4_nl_4_bl(t, 4, data, data_size);
 }
 
+template <> int repack<block_q8_0, 8, 8>(struct ggml_tensor * t, const void * data, size_t data_size) {
+    return repack_q8_0_to_q8_0_N_bl<8>(t, 8, data, data_size);
+}
+
 // TODO: needs to be revisited
 //template <> int repack<block_iq4_nl, 8, 4>(struct ggml_tensor * t, const void * data, size_t data_size) {
 //    return repack_iq4_nl_to_iq4_nl_4_bl(t, 8, data, data_size);
@@ -1135,10 +1699,30 @@ template <> void gemv<block_q4_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t
     ggml_gemv_q4_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemv<block_q2_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemv_q2_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemv<block_q3_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemv_q3_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemv<block_q5_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemv_q5_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemv<block_q6_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemv_q6_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
 template <> void gemv<block_iq4_nl, 4, 4, GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
     ggml_gemv_iq4_nl_4x4_q8_0(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemv<block_q8_0, 8, 8, GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemv_q8_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
 // gemm
 template <typename BLOC_TYPE, int64_t INTER_SIZE, int64_t NB_COLS, ggml_type PARAM_TYPE>
 void gemm(int, float *, size_t, const void *, const void *, int, int);
@@ -1159,10 +1743,30 @@ template <> void gemm<block_q4_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t
     ggml_gemm_q4_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemm<block_q2_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemm_q2_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemm<block_q3_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemm_q3_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemm<block_q5_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemm_q5_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
+template <> void gemm<block_q6_K, 8, 8, GGML_TYPE_Q8_K>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemm_q6_K_8x8_q8_K(n, s, bs, vx, vy, nr, nc);
+}
+
 template <> void gemm<block_iq4_nl, 4, 4, GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
     ggml_gemm_iq4_nl_4x4_q8_0(n, s, bs, vx, vy, nr, nc);
 }
 
+template <> void gemm<block_q8_0, 8, 8, GGML_TYPE_Q8_0>(int n, float * s, size_t bs, const void * vx, const void * vy, int nr, int nc) {
+    ggml_gemm_q8_0_8x8_q8_0(n, s, bs, vx, vy, nr, nc);
+}
+
 class tensor_traits_base : public ggml::cpu::tensor_traits {
   public:
     virtual int repack(struct ggml_tensor * t, const void * data, size_t data_size) = 0;
@@ -1236,22 +1840,29 @@ template <typename BLOC_TYPE, int64_t INTER_SIZE, int64_t NB_COLS, ggml_type PAR
 
         const ggml_from_float_t from_float = ggml_get_type_traits_cpu(PARAM_TYPE)->from_float;
 
-        int64_t i11_processed = 0;
-        for (int64_t i11 = ith * 4; i11 < ne11 - ne11 % 4; i11 += nth * 4) {
-            ggml_quantize_mat_t<INTER_SIZE, PARAM_TYPE>((float *) ((char *) src1->data + i11 * nb11), (void *) (wdata + i11 * nbw1), 4, ne10);
-        }
+        // rows are only interleaved when there are groups of 4 of them
+        const int layout = ggml_cpu_wdata_layout(PARAM_TYPE, ne11 >= 4 ? INTER_SIZE : 0);
+
+        if (!ggml_cpu_wdata_has_src1(params, op, layout)) {
+            int64_t i11_processed = 0;
+            for (int64_t i11 = ith * 4; i11 < ne11 - ne11 % 4; i11 += nth * 4) {
+                ggml_quantize_mat_t<INTER_SIZE, PARAM_TYPE>((float *) ((char *) src1->data + i11 * nb11), (void *) (wdata + i11 * nbw1), 4, ne10);
+            }
 
-        i11_processed = ne11 - ne11 % 4;
-        for (int64_t i11 = i11_processed + ith; i11 < ne11; i11 += nth) {
-            from_float((float *) ((char *) src1->data + i11 * nb11), (void *) (wdata + i11 * nbw1), ne10);
+            i11_processed = ne11 - ne11 % 4;
+            for (int64_t i11 = i11_processed + ith; i11 < ne11; i11 += nth) {
+                from_float((float *) ((char *) src1->data + i11 * nb11), (void *) (wdata + i11 * nbw1), ne10);
+            }
         }
 
         ggml_barrier(params->threadpool);
 
         const void * src1_wdata      = params->wdata;
         const size_t src1_col_stride = ggml_row_size(PARAM_TYPE, ne10);
-        int64_t      src0_start      = (ith * ne01) / nth;
-        int64_t      src0_end        = ((ith + 1) * ne01) / nth;
+        int64_t      src0_start;
+        int64_t      src0_end;
+        // the split is static, so weight it by core capacity on hybrid CPUs
+        ggml_cpu_thread_range(params, ne01, &src0_start, &src0_end);
         src0_start = (src0_start % NB_COLS) ? src0_start + NB_COLS - (src0_start % NB_COLS) : src0_start;
         src0_end   = (src0_end   % NB_COLS) ? src0_end   + NB_COLS - (src0_end   % NB_COLS) : src0_end;
         if (src0_start >= src0_end) {
@@ -1413,10 +2024,17 @@ static const tensor_traits<block_q4_0, 4, 4, GGML_TYPE_Q8_0> q4_0_4x4_q8_0;
 static const tensor_traits<block_q4_0, 8, 4, GGML_TYPE_Q8_0> q4_0_4x8_q8_0;
 static const tensor_traits<block_q4_0, 8, 8, GGML_TYPE_Q8_0> q4_0_8x8_q8_0;
 static const tensor_traits<block_q4_K, 8, 8, GGML_TYPE_Q8_K> q4_K_8x8_q8_K;
+static const tensor_traits<block_q2_K, 8, 8, GGML_TYPE_Q8_K> q2_K_8x8_q8_K;
+static const tensor_traits<block_q3_K, 8, 8, GGML_TYPE_Q8_K> q3_K_8x8_q8_K;
+static const tensor_traits<block_q5_K, 8, 8, GGML_TYPE_Q8_K> q5_K_8x8_q8_K;
+static const tensor_traits<block_q6_K, 8, 8, GGML_TYPE_Q8_K> q6_K_8x8_q8_K;
 
 // instance for IQ4
 static const tensor_traits<block_iq4_nl, 4, 4, GGML_TYPE_Q8_0> iq4_nl_4x4_q8_0;
 
+// instance for Q8
+static const tensor_traits<block_q8_0, 8, 8, GGML_TYPE_Q8_0> q8_0_8x8_q8_0;
+
 }  // namespace ggml::cpu::repack
 
 static const ggml::cpu::tensor_traits * ggml_repack_get_optimal_repack_type(const struct ggml_tensor * cur) {
@@ -1442,6 +2060,36 @@ static const ggml::cpu::tensor_traits * ggml_repack_get_optimal_repack_type(cons
                 return &ggml::cpu::repack::q4_K_8x8_q8_K;
             }
         }
+    } else if (cur->type == GGML_TYPE_Q2_K) {
+        if (ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &ggml::cpu::repack::q2_K_8x8_q8_K;
+            }
+        }
+    } else if (cur->type == GGML_TYPE_Q3_K) {
+        if (ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &ggml::cpu::repack::q3_K_8x8_q8_K;
+            }
+        }
+    } else if (cur->type == GGML_TYPE_Q5_K) {
+        if (ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &ggml::cpu::repack::q5_K_8x8_q8_K;
+            }
+        }
+    } else if (cur->type == GGML_TYPE_Q6_K) {
+        if (ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &ggml::cpu::repack::q6_K_8x8_q8_K;
+            }
+        }
+    } else if (cur->type == GGML_TYPE_Q8_0) {
+        if (ggml_cpu_has_avx2()) {
+            if (cur->ne[1] % 8 == 0) {
+                return &ggml::cpu::repack::q8_0_8x8_q8_0;
+            }
+        }
     } else if (cur->type == GGML_TYPE_IQ4_NL) {
         if (ggml_cpu_has_neon() && ggml_cpu_has_dotprod()) {
             if (cur->ne[1] % 4 == 0) {
@@ -254,6 +254,45 @@ void ggml_vec_silu_f32(const int n, float * y, const float * x) {
     }
 }
 
+// s = silu(x), z = s*g
+void ggml_vec_swiglu_f32(const int n, float * s, float * z, const float * x, const float * g) {
+    int i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+    for (; i + 15 < n; i += 16) {
+        const __m512 gi = _mm512_loadu_ps(g + i);
+        const __m512 si = ggml_v_silu(_mm512_loadu_ps(x + i));
+        _mm512_storeu_ps(s + i, si);
+        _mm512_storeu_ps(z + i, _mm512_mul_ps(si, gi));
+    }
+#elif defined(__AVX2__) && defined(__FMA__)
+    for (; i + 7 < n; i += 8) {
+        const __m256 gi = _mm256_loadu_ps(g + i);
+        const __m256 si = ggml_v_silu(_mm256_loadu_ps(x + i));
+        _mm256_storeu_ps(s + i, si);
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(si, gi));
+    }
+#elif defined(__SSE2__)
+    for (; i + 3 < n; i += 4) {
+        const __m128 gi = _mm_loadu_ps(g + i);
+        const __m128 si = ggml_v_silu(_mm_loadu_ps(x + i));
+        _mm_storeu_ps(s + i, si);
+        _mm_storeu_ps(z + i, _mm_mul_ps(si, gi));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 3 < n; i += 4) {
+        const float32x4_t gi = vld1q_f32(g + i);
+        const float32x4_t si = ggml_v_silu(vld1q_f32(x + i));
+        vst1q_f32(s + i, si);
+        vst1q_f32(z + i, vmulq_f32(si, gi));
+    }
+#endif
+    for (; i < n; ++i) {
+        const float gi = g[i];
+        s[i] = ggml_silu_f32(x[i]);
+        z[i] = s[i]*gi;
+    }
+}
+
 ggml_float ggml_vec_soft_max_f32(const int n, float * y, const float * x, float max) {
     int i = 0;
     ggml_float sum = 0;
@@ -44,6 +44,7 @@ void ggml_vec_dot_bf16(int n, float * GGML_RESTRICT s, size_t bs, ggml_bf16_t *
 void ggml_vec_dot_f16(int n, float * GGML_RESTRICT s, size_t bs, ggml_fp16_t * GGML_RESTRICT x, size_t bx, ggml_fp16_t * GGML_RESTRICT y, size_t by, int nrc);
 
 void ggml_vec_silu_f32(const int n, float * y, const float * x);
+void ggml_vec_swiglu_f32(const int n, float * s, float * z, const float * x, const float * g);
 ggml_float ggml_vec_soft_max_f32(const int n, float * y, const float * x, float max);
 ggml_float ggml_vec_log_soft_max_f32(const int n, float * y, const float * x, float max);
 
@@ -351,6 +352,36 @@ inline static void ggml_vec_mad_f32_unroll(const int n, const int xs, const int
 #endif
 }
 
+// y = x*v, z = y*w: rms_norm followed by the multiplication with the norm weight
+inline static void ggml_vec_scale_mul_f32(const int n, float * y, float * z, const float * x, const float v, const float * w) {
+    int i = 0;
+#if defined(GGML_SIMD) && !defined(__ARM_FEATURE_SVE)
+    const int np = (n & ~(GGML_F32_STEP - 1));
+
+    GGML_F32_VEC vx = GGML_F32_VEC_SET1(v);
+
+    GGML_F32_VEC ay[GGML_F32_ARR];
+    GGML_F32_VEC aw[GGML_F32_ARR];
+
+    for (; i < np; i += GGML_F32_STEP) {
+        for (int j = 0; j < GGML_F32_ARR; j++) {
+            ay[j] = GGML_F32_VEC_LOAD(x + i + j*GGML_F32_EPR);
+            aw[j] = GGML_F32_VEC_LOAD(w + i + j*GGML_F32_EPR);
+            ay[j] = GGML_F32_VEC_MUL(ay[j], vx);
+
+            GGML_F32_VEC_STORE(y + i + j*GGML_F32_EPR, ay[j]);
+            GGML_F32_VEC_STORE(z + i + j*GGML_F32_EPR, GGML_F32_VEC_MUL(ay[j], aw[j]));
+        }
+    }
+#endif
+    // leftovers
+    for (; i < n; ++i) {
+        const float yi = x[i]*v;
+        y[i] = yi;
+        z[i] = yi*w[i];
+    }
+}
+
 //inline static void ggml_vec_scale_f32(const int n, float * y, const float   v) { for (int i = 0; i < n; ++i) y[i] *= v;          }
 inline static void ggml_vec_scale_f32(const int n, float * y, const float   v) {
 #if defined(GGML_USE_ACCELERATE)
@@ -0,0 +1,40 @@
+#!/bin/bash
+#
+# Measure the overhead of the CPU profiler build modes on test-quantize-perf
+#
+# usage: ./scripts/bench-cpu-profiling.sh [additional test-quantize-perf arguments]
+#
+# example:
+#   ./scripts/bench-cpu-profiling.sh --op vec_dot_q --type q4_0 --type q8_0
+#
+
+set -e
+
+perf_args="${@:-"--op vec_dot_q --type q4_0 --type q4_K --type q8_0"}"
+
+function build {
+    local mode=$1
+    local dir="build-prof-${mode,,}"
+
+    cmake -B ${dir} -S . ${CMAKE_OPTS} -DGGML_CPU_PROFILING=${mode} -DLLAMA_CURL=OFF > /dev/null
+    cmake --build ${dir} -t test-quantize-perf -j > /dev/null
+}
+
+function run {
+    local mode=$1
+    local label=$2
+    local dir="build-prof-${mode,,}"
+
+    echo "### ${label}"
+    ${dir}/bin/test-quantize-perf ${perf_args}
+    echo
+}
+
+for mode in OFF ON RUNTIME; do
+    build ${mode}
+done
+
+run OFF     "GGML_CPU_PROFILING=OFF"
+GGML_PROFILING=1 run ON      "GGML_CPU_PROFILING=ON (active)"
+run RUNTIME "GGML_CPU_PROFILING=RUNTIME (disabled)"
+GGML_PROFILING=1 run RUNTIME "GGML_CPU_PROFILING=RUNTIME (GGML_PROFILING=1)"
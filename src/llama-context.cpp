@@ -58,6 +58,9 @@ llama_context::llama_context(
     cparams.cb_eval           = params.cb_eval;
     cparams.cb_eval_user_data = params.cb_eval_user_data;
 
+    // the previous graph is reused when the next ubatch has the same shape
+    graph_reuse_disable = getenv("LLAMA_GRAPH_REUSE_DISABLE") != nullptr;
+
     auto rope_scaling_type = params.rope_scaling_type;
     if (rope_scaling_type == LLAMA_ROPE_SCALING_TYPE_UNSPECIFIED) {
         rope_scaling_type = hparams.rope_scaling_type_train;
@@ -626,18 +629,24 @@ void llama_context::set_embeddings(bool value) {
     LLAMA_LOG_DEBUG("%s: value = %d\n", __func__, value);
 
     cparams.embeddings = value;
+
+    gf_res_prev.reset();
 }
 
 void llama_context::set_causal_attn(bool value) {
     LLAMA_LOG_DEBUG("%s: value = %d\n", __func__, value);
 
     cparams.causal_attn = value;
+
+    gf_res_prev.reset();
 }
 
 void llama_context::set_warmup(bool value) {
     LLAMA_LOG_DEBUG("%s: value = %d\n", __func__, value);
 
     cparams.warmup = value;
+
+    gf_res_prev.reset();
 }
 
 void llama_context::set_adapter_lora(
@@ -646,6 +655,8 @@ void llama_context::set_adapter_lora(
     LLAMA_LOG_DEBUG("%s: adapter = %p, scale = %f\n", __func__, (void *) adapter, scale);
 
     loras[adapter] = scale;
+
+    gf_res_prev.reset();
 }
 
 bool llama_context::rm_adapter_lora(
@@ -655,6 +666,7 @@ bool llama_context::rm_adapter_lora(
     auto pos = loras.find(adapter);
     if (pos != loras.end()) {
         loras.erase(pos);
+        gf_res_prev.reset();
         return true;
     }
 
@@ -665,6 +677,8 @@ void llama_context::clear_adapter_lora() {
     LLAMA_LOG_DEBUG("%s: call\n", __func__);
 
     loras.clear();
+
+    gf_res_prev.reset();
 }
 
 bool llama_context::apply_adapter_cvec(
@@ -675,50 +689,63 @@ bool llama_context::apply_adapter_cvec(
                 int32_t   il_end) {
     LLAMA_LOG_DEBUG("%s: il_start = %d, il_end = %d\n", __func__, il_start, il_end);
 
+    gf_res_prev.reset();
+
     return cvec.apply(model, data, len, n_embd, il_start, il_end);
 }
 
-llm_graph_result_ptr llama_context::process_ubatch(const llama_ubatch & ubatch, llm_graph_type gtype, llama_memory_state_i * mstate, ggml_status & ret) {
+llm_graph_result_i * llama_context::process_ubatch(const llama_ubatch & ubatch, llm_graph_type gtype, llama_memory_state_i * mstate, ggml_status & ret) {
     if (mstate && !mstate->apply()) {
         LLAMA_LOG_ERROR("%s: failed to apply memory state\n", __func__);
         ret = GGML_STATUS_FAILED;
         return nullptr;
     }
 
-    auto * gf = graph_init();
-    if (!gf) {
-        LLAMA_LOG_ERROR("%s: failed to initialize graph\n", __func__);
-        ret = GGML_STATUS_FAILED;
-        return nullptr;
-    }
+    if (graph_can_reuse(ubatch, gtype, mstate)) {
+        LLAMA_LOG_DEBUG("%s: reusing the previous graph\n", __func__);
+    } else {
+        ggml_backend_sched_reset(sched.get());
 
-    auto res = graph_build(ctx_compute.get(), gf, ubatch, gtype, mstate);
-    if (!res) {
-        LLAMA_LOG_ERROR("%s: failed to build graph\n", __func__);
-        ret = GGML_STATUS_FAILED;
-        return nullptr;
-    }
+        auto * gf = graph_init();
+        if (!gf) {
+            LLAMA_LOG_ERROR("%s: failed to initialize graph\n", __func__);
+            ret = GGML_STATUS_FAILED;
+            return nullptr;
+        }
+
+        auto res = graph_build(ctx_compute.get(), gf, ubatch, gtype, mstate);
+        if (!res) {
+            LLAMA_LOG_ERROR("%s: failed to build graph\n", __func__);
+            ret = GGML_STATUS_FAILED;
+            return nullptr;
+        }
 
-    // LLAMA_LOG_INFO("graph build time: %.3f ms (%d nodes, %d leafs)\n", (ggml_time_us() - t_start_us)/1000.0, gf->n_nodes, gf->n_leafs);
+        // LLAMA_LOG_INFO("graph build time: %.3f ms (%d nodes, %d leafs)\n", (ggml_time_us() - t_start_us)/1000.0, gf->n_nodes, gf->n_leafs);
 
-    if (!ggml_backend_sched_alloc_graph(sched.get(), gf)) {
-        LLAMA_LOG_ERROR("%s: failed to allocate graph\n", __func__);
-        ret = GGML_STATUS_ALLOC_FAILED;
-        return nullptr;
+        if (!ggml_backend_sched_alloc_graph(sched.get(), gf)) {
+            LLAMA_LOG_ERROR("%s: failed to allocate graph\n", __func__);
+            ret = GGML_STATUS_ALLOC_FAILED;
+            return nullptr;
+        }
+
+        gf_res_prev = std::move(res);
+        gf_prev     = gf;
+        gf_key_prev = { gtype, ubatch.n_tokens, ubatch.n_seq_tokens, ubatch.n_seqs, ubatch.equal_seqs, ubatch.token != nullptr, n_outputs };
     }
 
-    res->set_inputs(&ubatch);
+    gf_res_prev->set_inputs(&ubatch);
 
-    const auto status = graph_compute(gf, ubatch.n_tokens > 1);
+    const auto status = graph_compute(gf_prev, ubatch.n_tokens > 1);
     if (status != GGML_STATUS_SUCCESS) {
         LLAMA_LOG_ERROR("%s: failed to compute graph, compute status: %d\n", __func__, status);
+        gf_res_prev.reset();
         ret = status;
         return nullptr;
     }
 
     ret = GGML_STATUS_SUCCESS;
 
-    return res;
+    return gf_res_prev.get();
 }
 
 int llama_context::encode(const llama_batch & batch_inp) {
@@ -1015,7 +1042,6 @@ int llama_context::decode(const llama_batch & batch_inp) {
             n_outputs = n_outputs_new;
         }
 
-        ggml_backend_sched_reset(sched.get());
         ggml_backend_sched_set_eval_callback(sched.get(), cparams.cb_eval, cparams.cb_eval_user_data);
 
         ggml_status status;
@@ -1203,7 +1229,10 @@ int llama_context::decode(const llama_batch & batch_inp) {
 
     // Reset state for the next token before backend sync, to allow the CPU activities in the reset to
     // overlap with device computation.
-    ggml_backend_sched_reset(sched.get());
+    // The allocation is kept when the graph may be reused for the next token.
+    if (!gf_res_prev) {
+        ggml_backend_sched_reset(sched.get());
+    }
 
     return 0;
 }
@@ -1291,7 +1320,26 @@ int32_t llama_context::graph_max_nodes() const {
     return std::max<int32_t>(65536, 5*model.n_tensors());
 }
 
+bool llama_context::graph_can_reuse(const llama_ubatch & ubatch, llm_graph_type gtype, const llama_memory_state_i * mstate) {
+    if (graph_reuse_disable || !gf_res_prev || gtype != LLM_GRAPH_TYPE_DECODER || !mstate) {
+        return false;
+    }
+
+    // with pipeline parallelism the splits alternate between copies of their inputs
+    if (ggml_backend_sched_get_n_copies(sched.get()) > 1) {
+        return false;
+    }
+
+    const graph_key key = { gtype, ubatch.n_tokens, ubatch.n_seq_tokens, ubatch.n_seqs, ubatch.equal_seqs, ubatch.token != nullptr, n_outputs };
+
+    return key == gf_key_prev && gf_res_prev->rebind(mstate);
+}
+
 ggml_cgraph * llama_context::graph_init() {
+    // the graph and its allocation are about to be replaced
+    gf_res_prev.reset();
+    gf_prev = nullptr;
+
     ggml_init_params params = {
         /*.mem_size   =*/ buf_compute_meta.size(),
         /*.mem_buffer =*/ buf_compute_meta.data(),
@@ -96,7 +96,8 @@ struct llama_context {
     // if memory_state is provided, it will be applied first to the context's memory
     // ret contains the status of the graph computation
     // returns nullptr only if ret != GGML_STATUS_SUCCESS
-    llm_graph_result_ptr process_ubatch(
+    // the result is owned by the context and stays valid until the next graph is built
+    llm_graph_result_i * process_ubatch(
               const llama_ubatch & ubatch,
                   llm_graph_type   gtype,
             llama_memory_state_i * mstate,
@@ -200,6 +201,9 @@ public:
     ggml_cgraph * graph_reserve(uint32_t n_tokens, uint32_t n_seqs, uint32_t n_outputs, const llama_memory_state_i * mstate);
 
 private:
+    // check if the previous decoder graph can be computed again for this ubatch
+    bool graph_can_reuse(const llama_ubatch & ubatch, llm_graph_type gtype, const llama_memory_state_i * mstate);
+
     llm_graph_result_ptr graph_build(
                     ggml_context * ctx,
                      ggml_cgraph * gf,
@@ -260,6 +264,34 @@ private:
 
     ggml_context_ptr ctx_compute;
 
+    // the last graph built by process_ubatch, allocated in sched as long as gf_res_prev is set
+    // steady-state decoding with ubatches of the same shape keeps computing it and only updates the inputs
+    struct graph_key {
+        llm_graph_type gtype;
+        uint32_t       n_tokens;
+        uint32_t       n_seq_tokens;
+        uint32_t       n_seqs;
+        bool           equal_seqs;
+        bool           has_token;
+        uint32_t       n_outputs;
+
+        bool operator==(const graph_key & other) const {
+            return gtype        == other.gtype        &&
+                   n_tokens     == other.n_tokens     &&
+                   n_seq_tokens == other.n_seq_tokens &&
+                   n_seqs       == other.n_seqs       &&
+                   equal_seqs   == other.equal_seqs   &&
+                   has_token    == other.has_token    &&
+                   n_outputs    == other.n_outputs;
+        }
+    };
+
+    bool graph_reuse_disable = false; // LLAMA_GRAPH_REUSE_DISABLE
+
+    llm_graph_result_ptr gf_res_prev;
+    ggml_cgraph *        gf_prev = nullptr;
+    graph_key            gf_key_prev = {};
+
     // training
     ggml_opt_context_t opt_ctx = nullptr;
 
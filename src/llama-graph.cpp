@@ -353,10 +353,41 @@ void llm_graph_input_attn_no_cache::set_input(const llama_ubatch * ubatch) {
     }
 }
 
+// move a copy into the cache, and the view it writes to, to another offset in the cache tensor
+static void llm_graph_set_cpy_offs(ggml_tensor * cpy, size_t offs) {
+    for (ggml_tensor * t : { cpy, cpy->src[1] }) {
+        if (t->view_offs != offs) {
+            t->data      = (char *) t->view_src->data + offs;
+            t->view_offs = offs;
+        }
+    }
+}
+
 void llm_graph_input_attn_kv_unified::set_input(const llama_ubatch * ubatch) {
     if (self_kq_mask) {
         kv_state->set_input_kq_mask(self_kq_mask, ubatch, cparams.causal_attn);
     }
+
+    // no-op unless the graph was built for a ubatch stored at another place in the cache
+    for (const auto & [il, cpy] : k_cpy) {
+        llm_graph_set_cpy_offs(cpy, kv_state->get_k_offs(il));
+    }
+    for (const auto & [il, cpy] : v_cpy) {
+        llm_graph_set_cpy_offs(cpy, kv_state->get_v_offs(il));
+    }
+}
+
+bool llm_graph_input_attn_kv_unified::rebind(const llama_memory_state_i * mstate) {
+    const auto * kv_state_new = dynamic_cast<const llama_kv_cache_unified_state *>(mstate);
+
+    // the views of the cache cover n_kv cells
+    if (!kv_state_new || !self_kq_mask || kv_state_new->get_n_kv() != self_kq_mask->ne[0]) {
+        return false;
+    }
+
+    kv_state = kv_state_new;
+
+    return true;
 }
 
 void llm_graph_input_attn_kv_unified_iswa::set_input(const llama_ubatch * ubatch) {
@@ -1263,8 +1294,14 @@ ggml_tensor * llm_graph_context::build_attn(
 
     // store to KV cache
     {
-        ggml_build_forward_expand(gf, kv_state->cpy_k(ctx0, k_cur, il));
-        ggml_build_forward_expand(gf, kv_state->cpy_v(ctx0, v_cur, il));
+        ggml_tensor * k_cpy = kv_state->cpy_k(ctx0, k_cur, il);
+        ggml_tensor * v_cpy = kv_state->cpy_v(ctx0, v_cur, il);
+
+        inp->k_cpy.emplace_back(il, k_cpy);
+        inp->v_cpy.emplace_back(il, v_cpy);
+
+        ggml_build_forward_expand(gf, k_cpy);
+        ggml_build_forward_expand(gf, v_cpy);
     }
 
     const auto & kq_mask = inp->get_kq_mask();
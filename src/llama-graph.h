@@ -76,6 +76,11 @@ public:
     virtual ~llm_graph_input_i() = default;
 
     virtual void set_input(const llama_ubatch * ubatch) = 0;
+
+    // point the input to the memory state of a new ubatch, so that the graph built for
+    // an earlier ubatch of the same shape can be computed again for it
+    // returns false if the graph has to be rebuilt instead
+    virtual bool rebind(const llama_memory_state_i * /*mstate*/) { return false; }
 };
 
 using llm_graph_input_ptr = std::unique_ptr<llm_graph_input_i>;
@@ -88,6 +93,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * tokens = nullptr; // I32 [n_batch]
     ggml_tensor * embd   = nullptr; // F32 [n_embd, n_batch]
 };
@@ -99,6 +106,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * pos = nullptr; // I32 [n_batch]
 
     const int64_t n_pos_per_embd = 1;
@@ -113,6 +122,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * attn_scale = nullptr; // F32 [n_batch]
 
     const uint32_t n_attn_temp_floor_scale;
@@ -126,6 +137,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * pos_bucket = nullptr; // I32 [n_batch, n_batch]
 
     const llama_hparams & hparams;
@@ -156,6 +169,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * out_ids; // I32 [n_outputs]
 
     const llama_hparams & hparams;
@@ -171,6 +186,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * mean; // F32 [n_batch, n_batch]
 
     const llama_cparams & cparams;
@@ -183,6 +200,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * cls; // I32 [n_batch]
 
     const llama_cparams & cparams;
@@ -223,6 +242,8 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * /*mstate*/) override { return true; }
+
     ggml_tensor * get_kq_mask() const { return kq_mask_cnv; }
 
     ggml_tensor * kq_mask     = nullptr; // F32 [n_tokens, n_batch]
@@ -246,11 +267,18 @@ public:
 
     void set_input(const llama_ubatch * ubatch) override;
 
+    bool rebind(const llama_memory_state_i * mstate) override;
+
     ggml_tensor * get_kq_mask() const { return self_kq_mask_cnv; }
 
     ggml_tensor * self_kq_mask     = nullptr; // F32 [n_kv, n_batch]
     ggml_tensor * self_kq_mask_cnv = nullptr; //     [n_kv, n_batch]
 
+    // the copies of k_cur and v_cur into the cache, with their layer
+    // set_input() moves them to the cells of the current ubatch
+    std::vector<std::pair<int32_t, ggml_tensor *>> k_cpy;
+    std::vector<std::pair<int32_t, ggml_tensor *>> v_cpy;
+
     const llama_hparams & hparams;
     const llama_cparams & cparams;
 
@@ -320,6 +348,9 @@ public:
     virtual ggml_tensor * get_embd_pooled() = 0;
 
     virtual void set_inputs(const llama_ubatch * ubatch) = 0;
+
+    // check if the graph can be computed again for a ubatch of the same shape, see llm_graph_input_i::rebind()
+    virtual bool rebind(const llama_memory_state_i * mstate) = 0;
 };
 
 using llm_graph_result_ptr = std::unique_ptr<llm_graph_result_i>;
@@ -340,6 +371,15 @@ public:
         }
     }
 
+    bool rebind(const llama_memory_state_i * mstate) override {
+        for (auto & input : inputs) {
+            if (!input->rebind(mstate)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     llm_graph_input_i * add_input(llm_graph_input_ptr input) {
         inputs.emplace_back(std::move(input));
         return inputs.back().get();
@@ -12,6 +12,19 @@
 #include <map>
 #include <stdexcept>
 
+static void llama_numa_interleave(void * data, size_t size) {
+    auto * dev = ggml_backend_dev_by_type(GGML_BACKEND_DEVICE_TYPE_CPU);
+    if (!dev) {
+        return;
+    }
+
+    auto * reg = ggml_backend_dev_backend_reg(dev);
+    auto * numa_interleave_fn = (decltype(ggml_numa_interleave) *) ggml_backend_reg_get_proc_address(reg, "ggml_backend_cpu_numa_interleave");
+    if (numa_interleave_fn) {
+        numa_interleave_fn(data, size);
+    }
+}
+
 //
 // llama_kv_cache_unified
 //
@@ -114,6 +127,11 @@ llama_kv_cache_unified::llama_kv_cache_unified(
 
         LLAMA_LOG_INFO("%s: %10s KV buffer size = %8.2f MiB\n", __func__, ggml_backend_buffer_name(buf), ggml_backend_buffer_get_size(buf)/1024.0/1024.0);
 
+        // with the weights replicated on each NUMA node, spread the cache over all of them
+        if (ggml_backend_buffer_is_host(buf)) {
+            llama_numa_interleave(ggml_backend_buffer_get_base(buf), ggml_backend_buffer_get_size(buf));
+        }
+
         ggml_backend_buffer_clear(buf, 0);
         bufs.emplace_back(buf);
     }
@@ -759,7 +777,7 @@ ggml_tensor * llama_kv_cache_unified::cpy_k(ggml_context * ctx, ggml_tensor * k_
 
     ggml_tensor * k_view = ggml_view_1d(ctx, k,
             n_tokens*hparams.n_embd_k_gqa(il),
-            ggml_row_size(k->type, hparams.n_embd_k_gqa(il))*head_cur);
+            get_k_offs(il, head_cur));
 
     return ggml_cpy(ctx, k_cur, k_view);
 }
@@ -778,12 +796,12 @@ ggml_tensor * llama_kv_cache_unified::cpy_v(ggml_context * ctx, ggml_tensor * v_
     if (!v_trans) {
         v_view = ggml_view_1d(ctx, v,
                 n_tokens*hparams.n_embd_v_gqa(il),
-                ggml_row_size(v->type, hparams.n_embd_v_gqa(il))*head_cur);
+                get_v_offs(il, head_cur));
     } else {
         // note: the V cache is transposed when not using flash attention
         v_view = ggml_view_2d(ctx, v, n_tokens, hparams.n_embd_v_gqa(il),
                 (v->ne[1])*ggml_element_size(v),
-                (head_cur)*ggml_element_size(v));
+                get_v_offs(il, head_cur));
 
         v_cur = ggml_transpose(ctx, v_cur);
     }
@@ -791,6 +809,24 @@ ggml_tensor * llama_kv_cache_unified::cpy_v(ggml_context * ctx, ggml_tensor * v_
     return ggml_cpy(ctx, v_cur, v_view);
 }
 
+size_t llama_kv_cache_unified::get_k_offs(int32_t il, uint32_t head_cur) const {
+    const int32_t ikv = map_layer_ids.at(il);
+
+    return ggml_row_size(layers[ikv].k->type, hparams.n_embd_k_gqa(il))*head_cur;
+}
+
+size_t llama_kv_cache_unified::get_v_offs(int32_t il, uint32_t head_cur) const {
+    const int32_t ikv = map_layer_ids.at(il);
+
+    auto * v = layers[ikv].v;
+
+    if (!v_trans) {
+        return ggml_row_size(v->type, hparams.n_embd_v_gqa(il))*head_cur;
+    }
+
+    return head_cur*ggml_element_size(v);
+}
+
 void llama_kv_cache_unified::set_input_kq_mask(ggml_tensor * dst, const llama_ubatch * ubatch, bool causal_attn) const {
     const uint32_t n_tokens     = ubatch->n_tokens;
     const uint32_t n_seq_tokens = ubatch->n_seq_tokens;
@@ -1817,6 +1853,14 @@ ggml_tensor * llama_kv_cache_unified_state::cpy_v(ggml_context * ctx, ggml_tenso
     return kv->cpy_v(ctx, v_cur, il, head);
 }
 
+size_t llama_kv_cache_unified_state::get_k_offs(int32_t il) const {
+    return kv->get_k_offs(il, head);
+}
+
+size_t llama_kv_cache_unified_state::get_v_offs(int32_t il) const {
+    return kv->get_v_offs(il, head);
+}
+
 void llama_kv_cache_unified_state::set_input_k_shift(ggml_tensor * dst) const {
     kv->set_input_k_shift(dst);
 }
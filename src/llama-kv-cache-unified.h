@@ -105,6 +105,10 @@ public:
     ggml_tensor * cpy_k(ggml_context * ctx, ggml_tensor * k_cur, int32_t il, uint32_t head_cur) const;
     ggml_tensor * cpy_v(ggml_context * ctx, ggml_tensor * v_cur, int32_t il, uint32_t head_cur) const;
 
+    // offset of the views written by cpy_k and cpy_v in the layer's K and V tensors
+    size_t get_k_offs(int32_t il, uint32_t head_cur) const;
+    size_t get_v_offs(int32_t il, uint32_t head_cur) const;
+
     //
     // preparation API
     //
@@ -263,6 +267,9 @@ public:
     ggml_tensor * cpy_k(ggml_context * ctx, ggml_tensor * k_cur, int32_t il) const;
     ggml_tensor * cpy_v(ggml_context * ctx, ggml_tensor * v_cur, int32_t il) const;
 
+    size_t get_k_offs(int32_t il) const;
+    size_t get_v_offs(int32_t il) const;
+
     void set_input_k_shift(ggml_tensor * dst) const;
 
     void set_input_kq_mask   (ggml_tensor * dst, const llama_ubatch * ubatch, bool causal_attn) const;
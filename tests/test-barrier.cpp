@@ -6,11 +6,313 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
+#include <cmath>
+#include <thread>
 #include <vector>
 
 #define MAX_NARGS 2
 
+// Chains of elementwise ops run with some barriers skipped, check that the
+// result does not depend on the number of threads (including enough threads
+// for the tree barrier)
+static bool test_elementwise_chain(int n_threads) {
+    const int ne0 = 32;
+    const int ne1 = 67;
+
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 16*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * y = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * w = ggml_new_tensor_1d(ctx, GGML_TYPE_F32, ne0);
+
+    for (int i = 0; i < ne0*ne1; i++) {
+        ((float *) x->data)[i] = 0.01f*(i % 97) - 0.5f;
+        ((float *) y->data)[i] = 0.02f*(i % 13) + 0.1f;
+    }
+    for (int i = 0; i < ne0; i++) {
+        ((float *) w->data)[i] = 1.0f + 0.1f*i;
+    }
+
+    // row-parallel ops, in place and not, then a reduction over rows that needs a barrier
+    struct ggml_tensor * out = x;
+    for (int i = 0; i < 8; i++) {
+        out = ggml_add(ctx, out, ggml_view_2d(ctx, y, ne0, out->ne[1], y->nb[1], 0));
+        out = ggml_mul(ctx, out, w);
+        out = ggml_silu_inplace(ctx, out);
+        out = ggml_rms_norm(ctx, out, 1e-6f);
+        out = ggml_sqr(ctx, out);
+        // rows shifted by one, each thread reads rows computed by its neighbour
+        out = ggml_add(ctx,
+                ggml_view_2d(ctx, out, ne0, out->ne[1] - 1, out->nb[1], out->nb[1]),
+                ggml_view_2d(ctx, out, ne0, out->ne[1] - 1, out->nb[1], 0));
+    }
+
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out);
+
+    const int nr = out->ne[1];
+
+    // reference, single threaded
+    std::vector<float> ref(ne0*nr);
+    {
+        ggml_graph_compute_with_ctx(ctx, gf, 1);
+        for (int i = 0; i < nr; i++) {
+            for (int j = 0; j < ne0; j++) {
+                ref[i*ne0 + j] = *(float *) ((char *) out->data + i*out->nb[1] + j*out->nb[0]);
+            }
+        }
+    }
+
+    struct ggml_threadpool_params tpp  = ggml_threadpool_params_default(n_threads);
+    struct ggml_threadpool* threadpool = ggml_threadpool_new(&tpp);
+
+    struct ggml_cplan cplan = ggml_graph_plan(gf, n_threads, threadpool);
+    std::vector<uint8_t> work_data(cplan.work_size);
+    cplan.work_data = work_data.data();
+
+    bool ok = true;
+    for (int r = 0; r < 3 && ok; r++) {
+        ggml_graph_compute(gf, &cplan);
+        for (int i = 0; i < nr && ok; i++) {
+            for (int j = 0; j < ne0 && ok; j++) {
+                const float v = *(float *) ((char *) out->data + i*out->nb[1] + j*out->nb[0]);
+                if (std::fabs(v - ref[i*ne0 + j]) > 1e-5f) {
+                    fprintf(stderr, "elementwise chain mismatch with %d threads at (%d, %d): %f != %f\n",
+                            n_threads, i, j, v, ref[i*ne0 + j]);
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    ggml_threadpool_free(threadpool);
+    ggml_free(ctx);
+
+    return ok;
+}
+
+// Independent branches that are computed as one group by the threads that are free,
+// check that each of them matches the single threaded result
+static bool test_branches(int n_threads) {
+    const int ne0 = 64;
+    const int ne1 = 37;
+
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 16*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * y = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * z = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+
+    for (int i = 0; i < ne0*ne1; i++) {
+        ((float *) x->data)[i] = 0.01f*(i % 97) - 0.5f;
+        ((float *) y->data)[i] = 0.02f*(i % 13) + 0.1f;
+        ((float *) z->data)[i] = 0.03f*(i % 31) - 0.4f;
+    }
+
+    struct ggml_tensor * out = ggml_add(ctx, x, y);
+    for (int i = 0; i < 4; i++) {
+        // soft_max uses the work buffer, each branch needs its own part of it
+        struct ggml_tensor * a = ggml_soft_max(ctx, out);
+        struct ggml_tensor * b = ggml_scale(ctx, ggml_reshape_2d(ctx, out, ne0/2, 2*ne1), 0.5f);
+        struct ggml_tensor * c = ggml_cpy(ctx, out, ggml_new_tensor_2d(ctx, GGML_TYPE_F16, ne0, ne1));
+        struct ggml_tensor * d = ggml_rms_norm(ctx, z, 1e-6f);
+
+        out = ggml_add(ctx, a, ggml_reshape_2d(ctx, b, ne0, ne1));
+        out = ggml_add(ctx, out, ggml_cpy(ctx, c, ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1)));
+        out = ggml_add(ctx, out, d);
+    }
+
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out);
+
+    // reference, single threaded
+    std::vector<float> ref(ne0*ne1);
+    ggml_graph_compute_with_ctx(ctx, gf, 1);
+    memcpy(ref.data(), out->data, ggml_nbytes(out));
+
+    struct ggml_threadpool_params tpp  = ggml_threadpool_params_default(n_threads);
+    struct ggml_threadpool* threadpool = ggml_threadpool_new(&tpp);
+
+    struct ggml_cplan cplan = ggml_graph_plan(gf, n_threads, threadpool);
+    std::vector<uint8_t> work_data(cplan.work_size);
+    cplan.work_data = work_data.data();
+
+    bool ok = true;
+    for (int r = 0; r < 3 && ok; r++) {
+        ggml_graph_compute(gf, &cplan);
+        for (int i = 0; i < ne0*ne1 && ok; i++) {
+            const float v = ((float *) out->data)[i];
+            if (std::fabs(v - ref[i]) > 1e-5f) {
+                fprintf(stderr, "branches mismatch with %d threads at %d: %f != %f\n", n_threads, i, v, ref[i]);
+                ok = false;
+            }
+        }
+    }
+
+    ggml_threadpool_free(threadpool);
+    ggml_free(ctx);
+
+    return ok;
+}
+
+// Consecutive groups of in-place branches with a single barrier between them. A chunk
+// that is computed twice or not at all changes the result, so it has to match exactly.
+static bool test_branches_inplace(int n_threads) {
+    const int ne0      = 32;
+    const int ne1      = 61;
+    const int n_chains = 4;
+    const int n_groups = 32;
+
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 16*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * y = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    for (int i = 0; i < ne0*ne1; i++) {
+        ((float *) y->data)[i] = 0.02f*(i % 13) + 0.1f;
+    }
+
+    struct ggml_tensor * x  [n_chains];
+    struct ggml_tensor * out[n_chains];
+    for (int c = 0; c < n_chains; c++) {
+        x[c]   = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+        out[c] = x[c];
+    }
+
+    // each group has one node of every chain, the next node of a chain depends on the
+    // previous one, so every group is followed by another one
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    for (int g = 0; g < n_groups; g++) {
+        for (int c = 0; c < n_chains; c++) {
+            out[c] = g % 2 == 0 ? ggml_scale_inplace(ctx, out[c], 0.5f + 0.1f*c) : ggml_add_inplace(ctx, out[c], y);
+            ggml_build_forward_expand(gf, out[c]);
+        }
+    }
+
+    auto init = [&]() {
+        for (int c = 0; c < n_chains; c++) {
+            for (int i = 0; i < ne0*ne1; i++) {
+                ((float *) x[c]->data)[i] = 0.01f*((i + 7*c) % 97) - 0.5f;
+            }
+        }
+    };
+
+    // reference, single threaded
+    std::vector<float> ref(n_chains*ne0*ne1);
+    init();
+    ggml_graph_compute_with_ctx(ctx, gf, 1);
+    for (int c = 0; c < n_chains; c++) {
+        memcpy(ref.data() + c*ne0*ne1, out[c]->data, ggml_nbytes(out[c]));
+    }
+
+    struct ggml_threadpool_params tpp  = ggml_threadpool_params_default(n_threads);
+    struct ggml_threadpool* threadpool = ggml_threadpool_new(&tpp);
+
+    struct ggml_cplan cplan = ggml_graph_plan(gf, n_threads, threadpool);
+    std::vector<uint8_t> work_data(cplan.work_size);
+    cplan.work_data = work_data.data();
+
+    bool ok = true;
+    for (int r = 0; r < 20 && ok; r++) {
+        init();
+        ggml_graph_compute(gf, &cplan);
+        for (int c = 0; c < n_chains && ok; c++) {
+            if (memcmp(ref.data() + c*ne0*ne1, out[c]->data, ggml_nbytes(out[c])) != 0) {
+                fprintf(stderr, "in-place branches mismatch with %d threads in chain %d\n", n_threads, c);
+                ok = false;
+            }
+        }
+    }
+
+    ggml_threadpool_free(threadpool);
+    ggml_free(ctx);
+
+    return ok;
+}
+
+// With adaptive polling the workers poll or sleep depending on the time between graphs,
+// check that they still pick up every graph and account for the time they waited
+static bool test_adaptive_poll(int n_threads) {
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * x = ggml_new_tensor_1d(ctx, GGML_TYPE_F32, 256);
+    struct ggml_tensor * out = ggml_add(ctx, x, x);
+
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out);
+
+    struct ggml_threadpool_params tpp = ggml_threadpool_params_default(n_threads);
+    tpp.poll = GGML_THREADPOOL_POLL_ADAPTIVE;
+    struct ggml_threadpool * threadpool = ggml_threadpool_new(&tpp);
+
+    struct ggml_cplan cplan = ggml_graph_plan(gf, n_threads, threadpool);
+    std::vector<uint8_t> work_data(cplan.work_size);
+    cplan.work_data = work_data.data();
+
+    bool ok = true;
+    for (int r = 0; r < 20 && ok; r++) {
+        for (int i = 0; i < 256; i++) {
+            ((float *) x->data)[i] = (float) (r + i);
+        }
+
+        // back-to-back graphs, then gaps longer than the workers poll
+        if (r >= 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        ggml_graph_compute(gf, &cplan);
+
+        for (int i = 0; i < 256 && ok; i++) {
+            if (((float *) out->data)[i] != 2.0f*(r + i)) {
+                fprintf(stderr, "adaptive poll mismatch with %d threads in round %d\n", n_threads, r);
+                ok = false;
+            }
+        }
+    }
+
+    int64_t t_poll_us  = 0;
+    int64_t t_sleep_us = 0;
+    ggml_threadpool_get_wait_time(threadpool, &t_poll_us, &t_sleep_us);
+
+    // the wait time stays 0 with OpenMP, which does not use the threadpool's workers
+    if (t_poll_us < 0 || t_sleep_us < 0) {
+        fprintf(stderr, "adaptive poll with %d threads: bad wait time, poll %lld us, sleep %lld us\n",
+                n_threads, (long long) t_poll_us, (long long) t_sleep_us);
+        ok = false;
+    }
+
+    printf("adaptive poll: %lld us polling, %lld us sleeping\n", (long long) t_poll_us, (long long) t_sleep_us);
+
+    ggml_threadpool_free(threadpool);
+    ggml_free(ctx);
+
+    return ok;
+}
+
 int main(int argc, char *argv[]) {
 
     int n_threads = 4;
@@ -90,5 +392,12 @@ int main(int argc, char *argv[]) {
     ggml_threadpool_free(threadpool);
     ggml_free(ctx);
 
+    if (!test_elementwise_chain(n_threads) || !test_elementwise_chain(12) ||
+        !test_branches(n_threads) || !test_branches(12) ||
+        !test_branches_inplace(n_threads) || !test_branches_inplace(12) ||
+        !test_adaptive_poll(n_threads)) {
+        return 1;
+    }
+
     return 0;
 }
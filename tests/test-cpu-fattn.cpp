@@ -0,0 +1,171 @@
+// check the CPU backend's flash attention, one query row at a time (decode, with the KV split
+// across threads when it is long) and in tiles of query rows (prompt processing), against a
+// plain softmax(K*Q)*V reference with F16 and quantized K/V, masking, ALiBi and logit softcapping
+
+#include "ggml.h"
+#include "ggml-cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static void fill(struct ggml_tensor * t, int seed) {
+    std::vector<float> data(ggml_nelements(t));
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 0.011f*((i*13 + seed*101) % 181) - 1.0f;
+    }
+    if (t->type == GGML_TYPE_F32) {
+        memcpy(t->data, data.data(), data.size()*sizeof(float));
+    } else {
+        ggml_quantize_chunk(t->type, data.data(), t->data, 0, ggml_nrows(t), t->ne[0], nullptr);
+    }
+}
+
+// row i1 of head i2 of t, converted to F32
+static std::vector<float> get_row(const struct ggml_tensor * t, int64_t i1, int64_t i2) {
+    std::vector<float> row(t->ne[0]);
+    const char * data = (const char *) t->data + i1*t->nb[1] + i2*t->nb[2];
+    if (t->type == GGML_TYPE_F32) {
+        memcpy(row.data(), data, row.size()*sizeof(float));
+    } else {
+        ggml_get_type_traits(t->type)->to_float(data, row.data(), row.size());
+    }
+    return row;
+}
+
+static bool test_fattn(ggml_type type_kv, int64_t n_q, int64_t n_kv, int64_t dk, int64_t dv,
+        float max_bias, float logit_softcap, int n_threads) {
+    const int64_t n_head    = 4;
+    const int64_t n_head_kv = 2;
+    const float   scale     = 1.0f/sqrtf((float) dk);
+
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 64*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * q = ggml_new_tensor_3d(ctx, GGML_TYPE_F32, dk, n_q,  n_head);
+    struct ggml_tensor * k = ggml_new_tensor_3d(ctx, type_kv,       dk, n_kv, n_head_kv);
+    struct ggml_tensor * v = ggml_new_tensor_3d(ctx, type_kv,       dv, n_kv, n_head_kv);
+    struct ggml_tensor * m = ggml_new_tensor_2d(ctx, GGML_TYPE_F16, n_kv, GGML_PAD(n_q, GGML_KQ_MASK_PAD));
+
+    fill(q, 1);
+    fill(k, 2);
+    fill(v, 3);
+
+    // causal mask over the last n_q positions, with a hole of masked positions
+    for (int64_t i1 = 0; i1 < m->ne[1]; i1++) {
+        for (int64_t i0 = 0; i0 < n_kv; i0++) {
+            const bool masked = i0 > n_kv - n_q + i1 || (i0 >= 70 && i0 < 100);
+            ((ggml_fp16_t *) m->data)[i1*n_kv + i0] = ggml_fp32_to_fp16(masked ? -INFINITY : 0.0f);
+        }
+    }
+
+    struct ggml_tensor * out = ggml_flash_attn_ext(ctx, q, k, v, m, scale, max_bias, logit_softcap);
+    ggml_flash_attn_ext_set_prec(out, GGML_PREC_F32);
+
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out);
+
+    ggml_graph_compute_with_ctx(ctx, gf, n_threads);
+
+    const uint32_t n_head_log2 = 1u << (uint32_t) floor(log2(n_head));
+
+    const float m0 = powf(2.0f, -(max_bias       ) / n_head_log2);
+    const float m1 = powf(2.0f, -(max_bias / 2.0f) / n_head_log2);
+
+    // Q is converted to the K dot product type, so quantized K/V only match approximately,
+    // and the single row kernel accumulates F16 V in F16
+    const float eps = type_kv == GGML_TYPE_F16 && n_q > 1 ? 2e-3f : 3e-2f;
+
+    bool ok = true;
+
+    for (int64_t h = 0; h < n_head && ok; h++) {
+        const float slope = max_bias > 0.0f ? h < n_head_log2 ? powf(m0, h + 1) : powf(m1, 2*(h - n_head_log2) + 1) : 1.0f;
+        const int64_t h_kv = h/(n_head/n_head_kv);
+
+        for (int64_t i = 0; i < n_q && ok; i++) {
+            const std::vector<float> qr = get_row(q, i, h);
+
+            std::vector<float> kq(n_kv);
+            float kq_max = -INFINITY;
+            for (int64_t j = 0; j < n_kv; j++) {
+                const std::vector<float> kr = get_row(k, j, h_kv);
+
+                float s = 0.0f;
+                for (int64_t d = 0; d < dk; d++) {
+                    s += qr[d]*kr[d];
+                }
+                s *= scale;
+                if (logit_softcap != 0.0f) {
+                    s = logit_softcap*tanhf(s/logit_softcap);
+                }
+                kq[j] = s + slope*ggml_fp16_to_fp32(((ggml_fp16_t *) m->data)[i*n_kv + j]);
+                kq_max = std::max(kq_max, kq[j]);
+            }
+
+            std::vector<float> ref(dv, 0.0f);
+            float sum = 0.0f;
+            for (int64_t j = 0; j < n_kv; j++) {
+                const float p = expf(kq[j] - kq_max);
+                if (p == 0.0f) {
+                    continue;
+                }
+                const std::vector<float> vr = get_row(v, j, h_kv);
+                for (int64_t d = 0; d < dv; d++) {
+                    ref[d] += p*vr[d];
+                }
+                sum += p;
+            }
+
+            // out: [dv, n_head, n_q]
+            const float * res = (const float *) ((const char *) out->data + h*out->nb[1] + i*out->nb[2]);
+            for (int64_t d = 0; d < dv; d++) {
+                const float r = ref[d]/sum;
+                if (std::fabs(res[d] - r) > eps) {
+                    fprintf(stderr, "%s n_q = %lld, n_kv = %lld, dk = %lld, dv = %lld, max_bias = %.1f, softcap = %.1f (%d threads): "
+                            "mismatch at head %lld, row %lld, %lld: %f != %f\n",
+                            ggml_type_name(type_kv), (long long) n_q, (long long) n_kv, (long long) dk, (long long) dv,
+                            max_bias, logit_softcap, n_threads, (long long) h, (long long) i, (long long) d, res[d], r);
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    ggml_free(ctx);
+
+    return ok;
+}
+
+int main(void) {
+    for (ggml_type type : { GGML_TYPE_F16, GGML_TYPE_Q8_0, GGML_TYPE_Q4_0 }) {
+        for (int64_t n_q : { 1, 5, 19 }) {
+            for (int n_threads : { 1, 3 }) {
+                if (!test_fattn(type, n_q, 150, 64, 64, 0.0f, 0.0f, n_threads) ||
+                    !test_fattn(type, n_q, 150, 64, 32, 8.0f, 0.0f, n_threads) ||
+                    !test_fattn(type, n_q, 150, 64, 64, 0.0f, 20.0f, n_threads)) {
+                    return 1;
+                }
+            }
+        }
+
+        // long KV for a single query row, split in 3 and 4 with 3 and 8 threads
+        for (int n_threads : { 1, 3, 8 }) {
+            if (!test_fattn(type, 1, 1100, 64, 64, 0.0f, 0.0f, n_threads) ||
+                !test_fattn(type, 1, 1100, 64, 32, 8.0f, 20.0f, n_threads)) {
+                return 1;
+            }
+        }
+    }
+
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+// check the CPU backend's fused kernels (add + rms_norm + mul, rms_norm + mul, silu + mul)
+// against a plain reference, including the outputs of the intermediate nodes
+
+#include "ggml.h"
+#include "ggml-cpu.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static float ref_silu(float x) {
+    return x/(1.0f + expf(-x));
+}
+
+static void fill(struct ggml_tensor * t, float offset) {
+    float * data = (float *) t->data;
+    for (int64_t i = 0; i < ggml_nelements(t); i++) {
+        data[i] = 0.013f*((i*7 + (int64_t) (offset*100)) % 151) - 1.0f;
+    }
+}
+
+static float get(const struct ggml_tensor * t, int64_t i0, int64_t i1) {
+    return *(const float *) ((const char *) t->data + i0*t->nb[0] + i1*t->nb[1]);
+}
+
+static bool check(const char * name, const struct ggml_tensor * t, const std::vector<float> & ref, int n_threads) {
+    const int64_t ne0 = t->ne[0];
+    for (int64_t i1 = 0; i1 < t->ne[1]; i1++) {
+        for (int64_t i0 = 0; i0 < ne0; i0++) {
+            const float v = get(t, i0, i1);
+            const float r = ref[i1*ne0 + i0];
+            if (std::fabs(v - r) > 1e-4f*(1.0f + std::fabs(r))) {
+                fprintf(stderr, "%s (%d threads): mismatch at (%lld, %lld): %f != %f\n",
+                        name, n_threads, (long long) i0, (long long) i1, v, r);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool test_fusion(int n_threads) {
+    const int64_t ne0 = 67;
+    const int64_t ne1 = 13;
+    const float   eps = 1e-5f;
+
+    struct ggml_init_params params = {
+        /* .mem_size   = */ 16*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+
+    struct ggml_context * ctx = ggml_init(params);
+
+    struct ggml_tensor * cur  = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * res  = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * nw   = ggml_new_tensor_1d(ctx, GGML_TYPE_F32, ne0);
+    struct ggml_tensor * gate = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+    struct ggml_tensor * up   = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, ne0, ne1);
+
+    fill(cur, 0.1f);
+    fill(res, 0.2f);
+    fill(nw,  0.3f);
+    fill(gate, 0.4f);
+    fill(up,  0.5f);
+
+    // residual add -> rms_norm -> mul with the norm weight
+    struct ggml_tensor * inp  = ggml_add(ctx, cur, res);
+    struct ggml_tensor * norm = ggml_rms_norm(ctx, inp, eps);
+    struct ggml_tensor * out0 = ggml_mul(ctx, norm, nw);
+
+    // silu(gate) * up, with the operands swapped in the mul
+    struct ggml_tensor * act  = ggml_silu(ctx, gate);
+    struct ggml_tensor * out1 = ggml_mul(ctx, up, act);
+
+    // rms_norm -> mul on its own
+    struct ggml_tensor * norm3 = ggml_rms_norm(ctx, gate, eps);
+    struct ggml_tensor * out3  = ggml_mul(ctx, norm3, nw);
+
+    // rms_norm -> mul with rows of the norm itself, must not be fused
+    struct ggml_tensor * norm2 = ggml_rms_norm(ctx, up, eps);
+    struct ggml_tensor * out2  = ggml_mul(ctx, norm2, ggml_view_1d(ctx, norm2, ne0, norm2->nb[1]));
+
+    struct ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out0);
+    ggml_build_forward_expand(gf, out1);
+    ggml_build_forward_expand(gf, out2);
+    ggml_build_forward_expand(gf, out3);
+
+    ggml_graph_compute_with_ctx(ctx, gf, n_threads);
+
+    std::vector<float> ref_inp(ne0*ne1), ref_norm(ne0*ne1), ref_out0(ne0*ne1);
+    std::vector<float> ref_act(ne0*ne1), ref_out1(ne0*ne1);
+    std::vector<float> ref_norm2(ne0*ne1), ref_out2(ne0*ne1);
+    std::vector<float> ref_norm3(ne0*ne1), ref_out3(ne0*ne1);
+
+    for (int64_t i1 = 0; i1 < ne1; i1++) {
+        double sum = 0.0, sum2 = 0.0, sum3 = 0.0;
+        for (int64_t i0 = 0; i0 < ne0; i0++) {
+            const float x = get(cur, i0, i1) + get(res, i0, i1);
+            ref_inp[i1*ne0 + i0] = x;
+            sum += (double) x*x;
+            sum2 += (double) get(up, i0, i1)*get(up, i0, i1);
+            sum3 += (double) get(gate, i0, i1)*get(gate, i0, i1);
+        }
+        const float scale  = 1.0f/sqrtf((float) (sum/ne0) + eps);
+        const float scale2 = 1.0f/sqrtf((float) (sum2/ne0) + eps);
+        const float scale3 = 1.0f/sqrtf((float) (sum3/ne0) + eps);
+        for (int64_t i0 = 0; i0 < ne0; i0++) {
+            ref_norm [i1*ne0 + i0] = ref_inp[i1*ne0 + i0]*scale;
+            ref_out0 [i1*ne0 + i0] = ref_norm[i1*ne0 + i0]*get(nw, i0, 0);
+            ref_act  [i1*ne0 + i0] = ref_silu(get(gate, i0, i1));
+            ref_out1 [i1*ne0 + i0] = ref_act[i1*ne0 + i0]*get(up, i0, i1);
+            ref_norm2[i1*ne0 + i0] = get(up, i0, i1)*scale2;
+            ref_norm3[i1*ne0 + i0] = get(gate, i0, i1)*scale3;
+            ref_out3 [i1*ne0 + i0] = ref_norm3[i1*ne0 + i0]*get(nw, i0, 0);
+        }
+    }
+    for (int64_t i1 = 0; i1 < ne1; i1++) {
+        for (int64_t i0 = 0; i0 < ne0; i0++) {
+            ref_out2[i1*ne0 + i0] = ref_norm2[i1*ne0 + i0]*ref_norm2[1*ne0 + i0];
+        }
+    }
+
+    const bool ok =
+        check("add",      inp,   ref_inp,   n_threads) &&
+        check("rms_norm", norm,  ref_norm,  n_threads) &&
+        check("mul",      out0,  ref_out0,  n_threads) &&
+        check("silu",     act,   ref_act,   n_threads) &&
+        check("silu_mul", out1,  ref_out1,  n_threads) &&
+        check("rms_norm", norm2, ref_norm2, n_threads) &&
+        check("mul_self", out2,  ref_out2,  n_threads) &&
+        check("rms_norm", norm3, ref_norm3, n_threads) &&
+        check("norm_mul", out3,  ref_out3,  n_threads);
+
+    ggml_free(ctx);
+
+    return ok;
+}
+
+int main(void) {
+    for (int n_threads : { 1, 3, 4 }) {
+        if (!test_fusion(n_threads)) {
+            return 1;
+        }
+    }
+
+    printf("OK\n");
+
+    return 0;
+}
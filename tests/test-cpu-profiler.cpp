@@ -0,0 +1,219 @@
+// tests for the GGML CPU profiler (per-thread tables and merging)
+
+#include "../ggml/src/ggml-cpu/ggml-cpu-profiling.h"
+
+#include "ggml.h"
+#include "ggml-cpu.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if GGML_PROFILING_ENABLED
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+static void worker(int n_iter) {
+    for (int i = 0; i < n_iter; i++) {
+        GGML_PROF_START(test_outer, 16);
+        GGML_PROF_START(test_inner, 4);
+        GGML_PROF_END(test_inner);
+        GGML_PROF_END(test_outer);
+    }
+}
+
+static void nest(int depth) {
+    GGML_PROF_START(test_nest, 0);
+    if (depth > 1) {
+        nest(depth - 1);
+    }
+    GGML_PROF_END(test_nest);
+}
+
+static std::string read_file(const char * path) {
+    std::ifstream file(path);
+    CHECK(file.good());
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+#ifndef GGML_PROFILING_STANDALONE
+// per-node statistics recorded by ggml_graph_compute_thread
+static void test_nodes(void) {
+    ggml_init_params params = {
+        /* .mem_size   = */ 16*1024*1024,
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ false,
+    };
+    ggml_context * ctx = ggml_init(params);
+
+    ggml_tensor * w = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, 64, 32);
+    ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, 64, 4);
+    ggml_set_f32(w, 1.0f);
+    ggml_set_f32(x, 1.0f);
+
+    ggml_tensor * cur = ggml_mul_mat(ctx, w, x);
+    ggml_set_name(cur, "Qcur-3");
+    cur = ggml_scale(ctx, cur, 0.5f);
+    ggml_set_name(cur, "Qcur-3 (scaled)");
+
+    ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, cur);
+
+    ggml_profiler_reset();
+    ggml_profiler_nodes_enable(1);
+    for (int i = 0; i < 5; i++) {
+        ggml_graph_compute_with_ctx(ctx, gf, 2);
+    }
+    ggml_profiler_nodes_enable(0);
+
+    const char * path = "test-cpu-profiler-nodes.csv";
+    ggml_profiler_save_nodes(path);
+    const std::string csv = read_file(path);
+    std::remove(path);
+
+    CHECK(csv.find("3,Qcur,MUL_MAT,5,")  != std::string::npos);
+    CHECK(csv.find("3,Qcur,SCALE,5,")    != std::string::npos);
+
+    ggml_free(ctx);
+}
+#endif
+
+int main(void) {
+    const int n_threads = 8;
+    const int n_iter    = 10000;
+
+    ggml_profiler_init();
+    ggml_profiler_enable(1);
+    CHECK(ggml_profiler_is_enabled());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; i++) {
+        threads.emplace_back(worker, n_iter);
+    }
+    for (auto & t : threads) {
+        t.join();
+    }
+
+    // tables of exited threads must still be merged
+    const ggml_prof_stat_t * outer = ggml_profiler_get_stat("test_outer");
+    CHECK(outer != NULL);
+    CHECK(outer->call_count  == (uint64_t) n_threads * n_iter);
+    CHECK(outer->total_bytes == (uint64_t) n_threads * n_iter * 16);
+    CHECK(outer->min_time_us <= outer->max_time_us);
+
+    const ggml_prof_stat_t * inner = ggml_profiler_get_stat("test_inner");
+    CHECK(inner != NULL);
+    CHECK(inner->call_count  == (uint64_t) n_threads * n_iter);
+    CHECK(inner->total_bytes == (uint64_t) n_threads * n_iter * 4);
+
+    // tables of exited threads are handed to new threads instead of growing the list
+    const int n_tables = g_ggml_profiler.n_threads;
+    threads.clear();
+    for (int i = 0; i < n_threads; i++) {
+        threads.emplace_back(worker, 1);
+        threads.back().join();
+    }
+    CHECK(g_ggml_profiler.n_threads == n_tables);
+    CHECK(ggml_profiler_get_stat("test_outer")->call_count == (uint64_t) n_threads * (n_iter + 1));
+
+    // the same name always maps to the same id
+    CHECK(ggml_profiler_intern("test_outer") == ggml_profiler_intern("test_outer"));
+    CHECK(ggml_profiler_intern("test_outer") != ggml_profiler_intern("test_inner"));
+
+    ggml_profiler_reset();
+    CHECK(ggml_profiler_get_stat("test_outer") == NULL);
+
+    worker(10);
+    outer = ggml_profiler_get_stat("test_outer");
+    CHECK(outer != NULL);
+    CHECK(outer->call_count == 10);
+
+    // nothing is recorded while disabled
+    ggml_profiler_enable(0);
+    worker(10);
+    ggml_profiler_enable(1);
+    outer = ggml_profiler_get_stat("test_outer");
+    CHECK(outer != NULL);
+    CHECK(outer->call_count == 10);
+
+    // hardware counters depend on the kernel and the PMU, only check them when they can be opened
+    ggml_profiler_reset();
+    if (ggml_profiler_hw_enable(1)) {
+        worker(10);
+        outer = ggml_profiler_get_stat("test_outer");
+        CHECK(outer != NULL);
+        CHECK(outer->hw_calls == 10);
+        CHECK(outer->hw[GGML_PROF_HW_CYCLES] > 0);
+        inner = ggml_profiler_get_stat("test_inner");
+        CHECK(inner != NULL && inner->hw_calls == 0);
+        ggml_profiler_hw_enable(0);
+    }
+
+    // trace export: the ring keeps only the most recent events of each thread
+    ggml_profiler_reset();
+    ggml_profiler_trace_enable(1, 8);
+    worker(100);
+    ggml_profiler_trace_enable(0, 0);
+
+    const char * trace_path = "test-cpu-profiler-trace.json";
+    ggml_profiler_save_trace(trace_path);
+
+    const std::string trace = read_file(trace_path);
+    std::remove(trace_path);
+
+    size_t n_events = 0;
+    for (size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos + 1)) {
+        n_events++;
+    }
+    CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+    CHECK(trace.find("\"test_inner\"") != std::string::npos);
+    CHECK(n_events == 8);
+
+#ifndef GGML_PROFILING_STANDALONE
+    test_nodes();
+#endif
+
+    // regions nested deeper than the stack are not recorded, but every end still matches its start
+    ggml_profiler_reset();
+    nest(GGML_MAX_PROF_DEPTH + 8);
+    CHECK(ggml_prof_stack_depth == 0);
+    CHECK(ggml_profiler_get_stat("test_nest")->call_count == GGML_MAX_PROF_DEPTH);
+
+    // once the names table is full, new call sites record nothing and do not break the nesting
+    for (int i = 0; ggml_profiler_intern(("test_fill_" + std::to_string(i)).c_str()) >= 0; i++) {
+    }
+    ggml_profiler_reset();
+    for (int i = 0; i < 10; i++) {
+        GGML_PROF_START(test_outer, 16);
+        GGML_PROF_START(test_untracked, 1);
+        GGML_PROF_END(test_untracked);
+        GGML_PROF_END(test_outer);
+    }
+    CHECK(ggml_prof_stack_depth == 0);
+    CHECK(ggml_profiler_get_stat("test_untracked") == NULL);
+    CHECK(ggml_profiler_get_stat("test_outer")->call_count == 10);
+
+    printf("OK\n");
+    return 0;
+}
+
+#else
+
+int main(void) {
+    printf("profiling disabled, skipping\n");
+    return 0;
+}
+
+#endif // GGML_PROFILING_ENABLED
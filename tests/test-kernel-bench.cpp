@@ -0,0 +1,644 @@
+// Benchmark the CPU matmul kernels on LLaMA-sized shapes
+//
+// vec_dot     - type_traits_cpu[type].vec_dot over all rows of the weight, single thread
+// from_float  - type_traits_cpu[vec_dot_type].from_float over a batch of activations, single thread
+// mul_mat/cpu - GGML_OP_MUL_MAT with the weight in a regular CPU buffer (llamafile_sgemm if
+//               compiled in and the type/ISA is handled by it, vec_dot otherwise)
+// mul_mat/repack - GGML_OP_MUL_MAT with the weight in the CPU_REPACK buffer (repack gemv/gemm)
+
+#include "ggml.h"
+#include "ggml-cpu.h"
+#include "ggml-backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(disable: 4244 4267) // possible loss of data
+#endif
+
+#define WARMUP 1
+#define ITERATIONS 5
+
+// the repack and regular paths quantize the activations the same way, only the summation order differs
+#define MAX_REPACK_NMSE 1e-5
+
+struct bench_shape {
+    int64_t n; // output rows of the weight
+    int64_t k; // input features
+};
+
+struct bench_params {
+    std::vector<ggml_type>   types;
+    std::vector<bench_shape> shapes;
+    std::vector<int64_t>     batches;
+    int         n_threads  = 0;
+    int         iterations = ITERATIONS;
+    bool        op_vec_dot    = false;
+    bool        op_from_float = false;
+    bool        op_mul_mat    = false;
+    std::string json_path;
+};
+
+struct bench_result {
+    std::string bench;
+    std::string path;
+    ggml_type   type;
+    int64_t     n;
+    int64_t     k;
+    int64_t     batch;
+    int         n_threads;
+    double      min_us;
+    double      avg_us;
+    double      gflops;
+    double      gbps;
+    double      cycles_per_block; // < 0 if no cycle counter is available
+};
+
+//
+// cycle counter: the thread's own cycles via perf_event_open, the TSC on x86 otherwise
+//
+
+struct cycle_counter {
+    int fd = -1;
+
+    cycle_counter() {
+#if defined(__linux__)
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.config         = PERF_COUNT_HW_CPU_CYCLES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~cycle_counter() {
+#if defined(__linux__)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    bool available() const {
+#if defined(__x86_64__) || defined(__i386__)
+        return true;
+#else
+        return fd >= 0;
+#endif
+    }
+
+    const char * source() const {
+        if (fd >= 0) {
+            return "perf_event";
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        return "tsc";
+#else
+        return "none";
+#endif
+    }
+
+    int64_t read() const {
+#if defined(__linux__)
+        if (fd >= 0) {
+            uint64_t value = 0;
+            if (::read(fd, &value, sizeof(value)) == (ssize_t) sizeof(value)) {
+                return (int64_t) value;
+            }
+        }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+        return (int64_t) __rdtsc();
+#else
+        return 0;
+#endif
+    }
+};
+
+static cycle_counter g_cycles;
+
+struct bench_timing {
+    double min_us = 0.0;
+    double avg_us = 0.0;
+    double avg_cycles = 0.0;
+};
+
+static int64_t time_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// timed in ns, the small kernels of --quick take less than a microsecond
+template <typename F>
+static bench_timing bench_run(int iterations, F && func) {
+    for (int i = 0; i < WARMUP; i++) {
+        func();
+    }
+
+    bench_timing t;
+    t.min_us = INFINITY;
+    int64_t total_ns     = 0;
+    int64_t total_cycles = 0;
+    for (int i = 0; i < iterations; i++) {
+        const int64_t start_ns     = time_ns();
+        const int64_t start_cycles = g_cycles.read();
+
+        func();
+
+        const int64_t end_cycles = g_cycles.read();
+        const int64_t end_ns     = time_ns();
+
+        total_ns     += end_ns - start_ns;
+        total_cycles += end_cycles - start_cycles;
+        t.min_us = std::min(t.min_us, (end_ns - start_ns) / 1e3);
+    }
+    t.avg_us     = total_ns / 1e3 / iterations;
+    t.avg_cycles = (double) total_cycles / iterations;
+    return t;
+}
+
+// Generate synthetic data
+static void generate_data(float offset, size_t n, float * dst) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = 0.1f + 2*cosf(i + offset);
+    }
+}
+
+// quantize an n x k weight in chunks to keep the f32 copy small
+static std::vector<uint8_t> make_weight(ggml_type type, int64_t n, int64_t k) {
+    const size_t row_size = ggml_row_size(type, k);
+    std::vector<uint8_t> data(row_size * n);
+
+    const int64_t chunk = 64;
+    std::vector<float> src(chunk * k);
+    for (int64_t r = 0; r < n; r += chunk) {
+        const int64_t nr = std::min(chunk, n - r);
+        generate_data((float) r, nr * k, src.data());
+        ggml_quantize_chunk(type, src.data(), data.data() + r * row_size, 0, nr, k, nullptr);
+    }
+    return data;
+}
+
+static std::string cpu_features() {
+    struct feature {
+        const char * name;
+        int (*has)(void);
+    };
+    static const feature features[] = {
+        { "AVX",         ggml_cpu_has_avx         },
+        { "AVX_VNNI",    ggml_cpu_has_avx_vnni    },
+        { "AVX2",        ggml_cpu_has_avx2        },
+        { "F16C",        ggml_cpu_has_f16c        },
+        { "FMA",         ggml_cpu_has_fma         },
+        { "AVX512",      ggml_cpu_has_avx512      },
+        { "AVX512_VNNI", ggml_cpu_has_avx512_vnni },
+        { "AVX512_BF16", ggml_cpu_has_avx512_bf16 },
+        { "AMX_INT8",    ggml_cpu_has_amx_int8    },
+        { "NEON",        ggml_cpu_has_neon        },
+        { "ARM_FMA",     ggml_cpu_has_arm_fma     },
+        { "FP16_VA",     ggml_cpu_has_fp16_va     },
+        { "DOTPROD",     ggml_cpu_has_dotprod     },
+        { "MATMUL_INT8", ggml_cpu_has_matmul_int8 },
+        { "SVE",         ggml_cpu_has_sve         },
+        { "SME",         ggml_cpu_has_sme         },
+        { "RISCV_V",     ggml_cpu_has_riscv_v     },
+        { "VSX",         ggml_cpu_has_vsx         },
+        { "WASM_SIMD",   ggml_cpu_has_wasm_simd   },
+    };
+
+    std::string res;
+    for (const auto & f : features) {
+        if (f.has()) {
+            res += res.empty() ? "" : " ";
+            res += f.name;
+        }
+    }
+    if (ggml_cpu_has_sve()) {
+        res += " SVE_CNT=" + std::to_string(ggml_cpu_get_sve_cnt());
+    }
+    return res;
+}
+
+static void print_result(const bench_result & r) {
+    char cycles[32];
+    if (r.cycles_per_block >= 0.0) {
+        snprintf(cycles, sizeof(cycles), "%10.2f", r.cycles_per_block);
+    } else {
+        snprintf(cycles, sizeof(cycles), "%10s", "-");
+    }
+    printf("%-10s %-7s %-7s %6" PRId64 " %6" PRId64 " %5" PRId64 " %3d %11.2f %11.2f %9.2f %8.2f %s\n",
+           r.bench.c_str(), r.path.c_str(), ggml_type_name(r.type), r.n, r.k, r.batch, r.n_threads,
+           r.min_us, r.avg_us, r.gflops, r.gbps, cycles);
+}
+
+//
+// single-thread kernels
+//
+
+static bench_result bench_vec_dot(ggml_type type, const bench_shape & shape, const std::vector<uint8_t> & w, int iterations) {
+    const auto * traits     = ggml_get_type_traits_cpu(type);
+    const ggml_type vd_type = traits->vec_dot_type;
+    const auto * vd_traits  = ggml_get_type_traits_cpu(vd_type);
+
+    const size_t w_row = ggml_row_size(type,    shape.k);
+    const size_t y_row = ggml_row_size(vd_type, shape.k);
+
+    std::vector<float> x(shape.k);
+    generate_data(0.5f, shape.k, x.data());
+    std::vector<uint8_t> y(y_row);
+    vd_traits->from_float(x.data(), y.data(), shape.k);
+
+    std::vector<float> s(shape.n);
+    const bench_timing t = bench_run(iterations, [&]() {
+        for (int64_t r = 0; r < shape.n; r++) {
+            traits->vec_dot((int) shape.k, &s[r], 0, w.data() + r * w_row, 0, y.data(), 0, 1);
+        }
+    });
+
+    const double blocks = (double) shape.n * shape.k / ggml_blck_size(type);
+    return {
+        "vec_dot", "vec_dot", type, shape.n, shape.k, 1, 1, t.min_us, t.avg_us,
+        2.0 * shape.n * shape.k / (t.avg_us * 1e3),
+        (double) (shape.n * w_row + y_row) / (t.avg_us * 1e3),
+        g_cycles.available() ? t.avg_cycles / blocks : -1.0,
+    };
+}
+
+static bench_result bench_from_float(ggml_type type, const bench_shape & shape, int64_t batch, int iterations) {
+    const ggml_type vd_type = ggml_get_type_traits_cpu(type)->vec_dot_type;
+    const auto * vd_traits  = ggml_get_type_traits_cpu(vd_type);
+
+    const size_t y_row = ggml_row_size(vd_type, shape.k);
+
+    std::vector<float> x(batch * shape.k);
+    generate_data(0.5f, x.size(), x.data());
+    std::vector<uint8_t> y(batch * y_row);
+
+    const bench_timing t = bench_run(iterations, [&]() {
+        for (int64_t r = 0; r < batch; r++) {
+            vd_traits->from_float(x.data() + r * shape.k, y.data() + r * y_row, shape.k);
+        }
+    });
+
+    const double blocks = (double) batch * shape.k / ggml_blck_size(vd_type);
+    return {
+        "from_float", ggml_type_name(vd_type), type, 0, shape.k, batch, 1, t.min_us, t.avg_us,
+        0.0,
+        (double) batch * (shape.k * sizeof(float) + y_row) / (t.avg_us * 1e3),
+        g_cycles.available() ? t.avg_cycles / blocks : -1.0,
+    };
+}
+
+//
+// full GGML_OP_MUL_MAT on the CPU backend
+//
+
+// returns false if the weight type cannot be placed in buft (e.g. no repacked layout for this ISA)
+static bool bench_mul_mat(ggml_backend_t backend, ggml_backend_buffer_type_t buft, const char * path,
+                          ggml_type type, const bench_shape & shape, int64_t batch, const std::vector<uint8_t> & w_data,
+                          int n_threads, int iterations, bench_result & res, std::vector<float> & out_data) {
+    ggml_init_params params = {
+        /* .mem_size   = */ ggml_tensor_overhead() * 3 + ggml_graph_overhead(),
+        /* .mem_buffer = */ NULL,
+        /* .no_alloc   = */ true,
+    };
+    ggml_context * ctx_w  = ggml_init(params);
+    ggml_context * ctx_io = ggml_init(params);
+
+    ggml_tensor * w   = ggml_new_tensor_2d(ctx_w,  type,          shape.k, shape.n);
+    ggml_tensor * x   = ggml_new_tensor_2d(ctx_io, GGML_TYPE_F32, shape.k, batch);
+    ggml_tensor * out = ggml_mul_mat(ctx_io, w, x);
+
+    ggml_cgraph * gf = ggml_new_graph(ctx_io);
+    ggml_build_forward_expand(gf, out);
+
+    ggml_backend_buffer_t buf_w  = ggml_backend_alloc_ctx_tensors_from_buft(ctx_w, buft);
+    ggml_backend_buffer_t buf_io = ggml_backend_alloc_ctx_tensors(ctx_io, backend);
+
+    // the repack buffer only accepts weights it has a layout for
+    const bool ok = ggml_backend_dev_supports_op(ggml_backend_get_device(backend), out);
+    if (ok) {
+        ggml_backend_tensor_set(w, w_data.data(), 0, w_data.size());
+
+        std::vector<float> x_data(batch * shape.k);
+        generate_data(0.5f, x_data.size(), x_data.data());
+        ggml_backend_tensor_set(x, x_data.data(), 0, ggml_nbytes(x));
+
+        const bench_timing t = bench_run(iterations, [&]() {
+            ggml_backend_graph_compute(backend, gf);
+        });
+
+        // the main thread takes part in the compute, its cycles approximate the wall time
+        const double blocks = (double) shape.n * shape.k / ggml_blck_size(type) * batch;
+        res = {
+            "mul_mat", path, type, shape.n, shape.k, batch, n_threads, t.min_us, t.avg_us,
+            2.0 * shape.n * shape.k * batch / (t.avg_us * 1e3),
+            (double) (w_data.size() + ggml_nbytes(x) + ggml_nbytes(out)) / (t.avg_us * 1e3),
+            g_cycles.available() ? t.avg_cycles * n_threads / blocks : -1.0,
+        };
+
+        out_data.resize(ggml_nelements(out));
+        ggml_backend_tensor_get(out, out_data.data(), 0, ggml_nbytes(out));
+    }
+
+    ggml_backend_buffer_free(buf_io);
+    ggml_backend_buffer_free(buf_w);
+    ggml_free(ctx_io);
+    ggml_free(ctx_w);
+
+    return ok;
+}
+
+// normalized mean squared error of the repacked kernels against the regular path
+static double nmse(const std::vector<float> & a, const std::vector<float> & b) {
+    double err = 0.0, ref = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        err += (a[i] - b[i]) * (a[i] - b[i]);
+        ref += a[i] * a[i];
+    }
+    return ref > 0.0 ? err / ref : err;
+}
+
+static ggml_backend_buffer_type_t find_repack_buft(ggml_backend_t backend) {
+    ggml_backend_dev_t dev = ggml_backend_get_device(backend);
+    ggml_backend_reg_t reg = ggml_backend_dev_backend_reg(dev);
+
+    auto get_extra_bufts = (ggml_backend_dev_get_extra_bufts_t)
+        ggml_backend_reg_get_proc_address(reg, "ggml_backend_dev_get_extra_bufts");
+    if (!get_extra_bufts) {
+        return nullptr;
+    }
+    for (ggml_backend_buffer_type_t * buft = get_extra_bufts(dev); buft && *buft; buft++) {
+        if (strcmp(ggml_backend_buft_name(*buft), "CPU_REPACK") == 0) {
+            return *buft;
+        }
+    }
+    return nullptr;
+}
+
+// JSON has no inf or nan
+static std::string json_number(double v, const char * fmt) {
+    if (!std::isfinite(v)) {
+        return "null";
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), fmt, v);
+    return buf;
+}
+
+static void write_json(const char * path, const bench_params & params, const std::string & features,
+                       const std::vector<bench_result> & results) {
+    FILE * f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "error: failed to open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"system\": {\"cpu_features\": \"%s\", \"llamafile\": %s, \"n_threads\": %d, \"cycles\": \"%s\"},\n",
+            features.c_str(), ggml_cpu_has_llamafile() ? "true" : "false", params.n_threads, g_cycles.source());
+    fprintf(f, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result & r = results[i];
+        const std::string cycles = r.cycles_per_block >= 0.0 ? json_number(r.cycles_per_block, "%.3f") : "null";
+        fprintf(f, "    {\"bench\": \"%s\", \"path\": \"%s\", \"type\": \"%s\", \"n\": %" PRId64 ", \"k\": %" PRId64
+                   ", \"batch\": %" PRId64 ", \"n_threads\": %d, \"min_us\": %s, \"avg_us\": %s"
+                   ", \"gflops\": %s, \"gbps\": %s, \"cycles_per_block\": %s}%s\n",
+                r.bench.c_str(), r.path.c_str(), ggml_type_name(r.type), r.n, r.k, r.batch, r.n_threads,
+                json_number(r.min_us, "%.3f").c_str(), json_number(r.avg_us, "%.3f").c_str(),
+                json_number(r.gflops, "%.3f").c_str(), json_number(r.gbps, "%.3f").c_str(),
+                cycles.c_str(), i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+
+    printf("\nresults saved to %s\n", path);
+}
+
+static void usage(char * argv[]) {
+    printf("Benchmark the CPU matmul kernels on LLaMA-sized shapes\n");
+    printf("\n");
+    printf("usage: %s [options]\n", argv[0]);
+    printf("\n");
+    printf("options: (default)\n");
+    printf("  -h, --help            show this help message and exit\n");
+    printf("  --type TYPE           weight type with a CPU vec_dot, e.g. q2_K, q3_K, q4_0, q4_K, q5_K, q6_K, q8_0,\n");
+    printf("                        f16, can be repeated (q4_0, q4_K, q5_K, q6_K, q8_0, f16)\n");
+    printf("  --shape NxK           weight with N output rows and K input features, can be repeated\n");
+    printf("                        (4096x4096, 11008x4096, 4096x11008)\n");
+    printf("  -b, --batch B         number of activation rows for from_float and mul_mat, can be repeated\n");
+    printf("                        (1, 4, 16, 64, 256, 512)\n");
+    printf("  --op OP               vec_dot, from_float or mul_mat (all)\n");
+    printf("  -t, --threads N       threads for mul_mat (%d)\n", (int) std::thread::hardware_concurrency());
+    printf("  -i, --iterations N    timed iterations after one warmup run (%d)\n", ITERATIONS);
+    printf("  --json FNAME          also write the results as JSON to FNAME\n");
+    printf("  --quick               small shape, q4_0, q8_0, q3_K and q6_K and two batches, for smoke testing\n");
+}
+
+int main(int argc, char * argv[]) {
+    bench_params params {};
+    bool quick = false;
+
+    bool invalid_param = false;
+    std::string arg;
+    for (int i = 1; i < argc; i++) {
+        arg = argv[i];
+
+        if (arg == "--type") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            ggml_type type = GGML_TYPE_COUNT;
+            for (int t = 0; t < GGML_TYPE_COUNT; t++) {
+                const char * name = ggml_type_name((ggml_type) t);
+                if (name && strcmp(name, argv[i]) == 0) {
+                    type = (ggml_type) t;
+                }
+            }
+            if (type == GGML_TYPE_COUNT || !ggml_get_type_traits_cpu(type)->vec_dot) {
+                fprintf(stderr, "error: unsupported type %s\n", argv[i]);
+                invalid_param = true;
+                break;
+            }
+            params.types.push_back(type);
+        } else if (arg == "--shape") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            bench_shape shape = {};
+            if (sscanf(argv[i], "%" SCNd64 "x%" SCNd64, &shape.n, &shape.k) != 2 || shape.n <= 0 || shape.k <= 0) {
+                invalid_param = true;
+                break;
+            }
+            params.shapes.push_back(shape);
+        } else if (arg == "-b" || arg == "--batch") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            params.batches.push_back(std::max(1, std::atoi(argv[i])));
+        } else if (arg == "--op") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            std::string op {argv[i]};
+            if (op == "vec_dot") {
+                params.op_vec_dot = true;
+            } else if (op == "from_float") {
+                params.op_from_float = true;
+            } else if (op == "mul_mat") {
+                params.op_mul_mat = true;
+            } else {
+                invalid_param = true;
+                break;
+            }
+        } else if (arg == "-t" || arg == "--threads") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            params.n_threads = std::atoi(argv[i]);
+        } else if (arg == "-i" || arg == "--iterations") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            params.iterations = std::max(1, std::atoi(argv[i]));
+        } else if (arg == "--json") {
+            if (++i >= argc) {
+                invalid_param = true;
+                break;
+            }
+            params.json_path = argv[i];
+        } else if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "-h" || arg == "--help") {
+            usage(argv);
+            return 1;
+        } else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (invalid_param) {
+        fprintf(stderr, "error: invalid parameter for argument: %s\n", arg.c_str());
+        return 1;
+    }
+
+    if (params.types.empty()) {
+        params.types = quick ? std::vector<ggml_type> { GGML_TYPE_Q4_0, GGML_TYPE_Q8_0, GGML_TYPE_Q3_K, GGML_TYPE_Q6_K }
+                             : std::vector<ggml_type> { GGML_TYPE_Q4_0, GGML_TYPE_Q4_K, GGML_TYPE_Q5_K, GGML_TYPE_Q6_K, GGML_TYPE_Q8_0, GGML_TYPE_F16 };
+    }
+    if (params.shapes.empty()) {
+        params.shapes = quick ? std::vector<bench_shape> { { 256, 512 } }
+                              : std::vector<bench_shape> { { 4096, 4096 }, { 11008, 4096 }, { 4096, 11008 } };
+    }
+    if (params.batches.empty()) {
+        params.batches = quick ? std::vector<int64_t> { 1, 8 } : std::vector<int64_t> { 1, 4, 16, 64, 256, 512 };
+    }
+    if (quick) {
+        params.iterations = std::min(params.iterations, 2);
+    }
+    if (params.n_threads <= 0) {
+        params.n_threads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+    if (!(params.op_vec_dot || params.op_from_float || params.op_mul_mat)) {
+        params.op_vec_dot = params.op_from_float = params.op_mul_mat = true;
+    }
+
+    ggml_cpu_init();
+
+    ggml_backend_t backend = ggml_backend_cpu_init();
+    ggml_backend_cpu_set_n_threads(backend, params.n_threads);
+    ggml_backend_buffer_type_t repack_buft = find_repack_buft(backend);
+
+    const std::string features = cpu_features();
+    printf("cpu features : %s\n", features.c_str());
+    printf("llamafile    : %s\n", ggml_cpu_has_llamafile() ? "yes" : "no");
+    printf("repack       : %s\n", repack_buft ? "yes" : "no");
+    printf("cycles       : %s\n", g_cycles.source());
+    printf("\n");
+    printf("%-10s %-7s %-7s %6s %6s %5s %3s %11s %11s %9s %8s %10s\n",
+           "bench", "path", "type", "n", "k", "batch", "th", "min(us)", "avg(us)", "GFLOP/s", "GB/s", "cyc/block");
+
+    std::vector<bench_result> results;
+    int n_failed = 0;
+    auto add = [&](const bench_result & r) {
+        print_result(r);
+        results.push_back(r);
+    };
+
+    for (ggml_type type : params.types) {
+        for (const bench_shape & shape : params.shapes) {
+            if (shape.k % ggml_blck_size(type) != 0) {
+                fprintf(stderr, "skipping %s %" PRId64 "x%" PRId64 ": k is not a multiple of the block size\n",
+                        ggml_type_name(type), shape.n, shape.k);
+                continue;
+            }
+
+            const std::vector<uint8_t> w = make_weight(type, shape.n, shape.k);
+
+            if (params.op_vec_dot) {
+                add(bench_vec_dot(type, shape, w, params.iterations));
+            }
+            for (int64_t batch : params.batches) {
+                if (params.op_from_float) {
+                    add(bench_from_float(type, shape, batch, params.iterations));
+                }
+                if (params.op_mul_mat) {
+                    bench_result r;
+                    std::vector<float> out_cpu;
+                    std::vector<float> out_repack;
+                    if (bench_mul_mat(backend, ggml_backend_cpu_buffer_type(), "cpu", type, shape, batch, w,
+                                      params.n_threads, params.iterations, r, out_cpu)) {
+                        add(r);
+                    }
+                    if (repack_buft && bench_mul_mat(backend, repack_buft, "repack", type, shape, batch, w,
+                                                     params.n_threads, params.iterations, r, out_repack)) {
+                        add(r);
+
+                        const double err = nmse(out_cpu, out_repack);
+                        if (err > MAX_REPACK_NMSE) {
+                            fprintf(stderr, "error: repacked %s mul_mat differs from the cpu path, nmse = %g\n",
+                                    ggml_type_name(type), err);
+                            n_failed++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (!params.json_path.empty()) {
+        write_json(params.json_path.c_str(), params, features, results);
+    }
+
+    ggml_backend_free(backend);
+
+    return n_failed > 0 ? 1 : 0;
+}
@@ -269,6 +269,9 @@ int main(int argc, char * argv[]) {
     };
     struct ggml_context * ctx = ggml_init(ggml_params);
 
+    // initialize the CPU backend (also picks up GGML_PROFILING from the environment)
+    ggml_cpu_init();
+
     for (int i = 0; i < GGML_TYPE_COUNT; i++) {
         ggml_type type = (ggml_type) i;
         const auto * qfns = ggml_get_type_traits(type);
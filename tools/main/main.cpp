@@ -7,6 +7,7 @@
 #include "chat.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <fstream>
@@ -131,7 +132,19 @@ int main(int argc, char ** argv) {
     // Initialize ARM NEON profiling for w4a8/w8a8 quantization and matmul operations
     #if GGML_PROFILING_ENABLED
     ggml_profiler_init();
-    LOG_INF("%s: ARM NEON profiling enabled for quantization/matmul operations\n", __func__);
+    if (!params.prof_trace_file.empty()) {
+        ggml_profiler_enable(1);
+        const char * n_events = getenv("GGML_PROF_TRACE_EVENTS");
+        ggml_profiler_trace_enable(1, n_events ? std::strtoull(n_events, nullptr, 10) : 0);
+        LOG_INF("%s: CPU profiler trace will be saved to '%s'\n", __func__, params.prof_trace_file.c_str());
+    }
+    if (ggml_profiler_is_enabled()) {
+        LOG_INF("%s: ARM NEON profiling enabled for quantization/matmul operations\n", __func__);
+    }
+    #else
+    if (!params.prof_trace_file.empty()) {
+        LOG_WRN("%s: --prof-trace ignored, rebuild with -DGGML_CPU_PROFILING=ON or RUNTIME\n", __func__);
+    }
     #endif
 
     llama_model * model = nullptr;
@@ -986,6 +999,9 @@ int main(int argc, char ** argv) {
     LOG("========================================\n");
     ggml_profiler_print_results();
     LOG("========================================\n");
+    if (!params.prof_trace_file.empty()) {
+        ggml_profiler_save_trace(params.prof_trace_file.c_str());
+    }
     #endif
 
     common_sampler_free(smpl);
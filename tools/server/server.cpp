@@ -86,6 +86,7 @@ enum error_type {
     ERROR_TYPE_PERMISSION,
     ERROR_TYPE_UNAVAILABLE, // custom error
     ERROR_TYPE_NOT_SUPPORTED, // custom error
+    ERROR_TYPE_RATE_LIMIT,
 };
 
 struct slot_params {
@@ -204,6 +205,14 @@ struct server_task {
     server_tokens prompt_tokens;
     int id_selected_slot = -1;
 
+    // time when the task was posted to the queue, in us
+    int64_t t_queued = -1;
+
+    // used by the queue to pick the next deferred task, and by the admission control
+    int         priority = 0; // higher goes first
+    std::string tenant;       // requests of one tenant are limited to --tenant-slots slots
+    int32_t     n_kv = 0;     // estimated number of KV cells that the task needs
+
     // used by SERVER_TASK_TYPE_SLOT_SAVE, SERVER_TASK_TYPE_SLOT_RESTORE, SERVER_TASK_TYPE_SLOT_ERASE
     struct slot_action {
         int slot_id;
@@ -511,6 +520,17 @@ struct result_timings {
     int32_t draft_n = 0;
     int32_t draft_n_accepted = 0;
 
+    // Optional latency metrics - only included when >= 0
+    double queue_ms = -1; // from the request to the start of the prompt processing
+    double ttft_ms  = -1; // from the request to the first token
+    double tpot_ms  = -1; // per output token after the first one
+
+    // Optional number of times the slot was preempted in the KV pool - only included when > 0
+    int32_t preempted_n = 0;
+
+    // Optional number of batches that the prompt was split across - only included when > 0
+    int32_t prompt_batches = 0;
+
     json to_json() const {
         json base = {
             {"prompt_n",               prompt_n},
@@ -529,6 +549,26 @@ struct result_timings {
             base["draft_n_accepted"] = draft_n_accepted;
         }
 
+        if (queue_ms >= 0) {
+            base["queue_ms"] = queue_ms;
+        }
+
+        if (ttft_ms >= 0) {
+            base["ttft_ms"] = ttft_ms;
+        }
+
+        if (tpot_ms >= 0) {
+            base["tpot_ms"] = tpot_ms;
+        }
+
+        if (preempted_n > 0) {
+            base["preempted_n"] = preempted_n;
+        }
+
+        if (prompt_batches > 0) {
+            base["prompt_batches"] = prompt_batches;
+        }
+
         return base;
     }
 };
@@ -1096,6 +1136,10 @@ static json format_error_response(const std::string & message, const enum error_
             type_str = "unavailable_error";
             code = 503;
             break;
+        case ERROR_TYPE_RATE_LIMIT:
+            type_str = "rate_limit_error";
+            code = 429;
+            break;
     }
     return json {
         {"code", code},
@@ -1242,6 +1286,11 @@ struct server_slot {
 
     struct slot_params params;
 
+    // scheduling of the current task, see server_task
+    int         priority = 0;
+    std::string tenant;
+    int32_t     n_kv     = 0;
+
     slot_state state = SLOT_STATE_IDLE;
 
     // used to determine the slot that has been used the longest
@@ -1270,6 +1319,17 @@ struct server_slot {
 
     server_tokens cache_tokens;
 
+    // the KV of the cached tokens was dropped, to make room in a shared KV pool (--kv-pool) or to stop sharing
+    // the cells of a prefix before a context shift (--prefix-cache): only the first n_past of them are in the
+    // KV cache, and the rest are restored before generating again
+    bool preempted = false;
+
+    // number of times the slot was preempted in the KV pool for the current task
+    int32_t n_preempted = 0;
+
+    // number of batches that the prompt of the current task was split across
+    int32_t n_prompt_batches = 0;
+
     std::vector<completion_token_output> generated_token_probs;
 
     bool has_next_token = true;
@@ -1292,6 +1352,7 @@ struct server_slot {
     // stats
     size_t n_sent_text        = 0; // number of sent text character
 
+    int64_t t_queued = -1; // time when the task was posted, in us
     int64_t t_start_process_prompt;
     int64_t t_start_generation;
 
@@ -1328,6 +1389,9 @@ struct server_slot {
         // clear speculative decoding stats
         n_draft_total = 0;
         n_draft_accepted = 0;
+
+        n_preempted      = 0;
+        n_prompt_batches = 0;
     }
 
     bool is_non_causal() const {
@@ -1359,6 +1423,16 @@ struct server_slot {
         return state != SLOT_STATE_IDLE;
     }
 
+    // number of KV cells used by the slot
+    int32_t n_kv_cells() const {
+        // until a new prompt is started, the slot keeps the KV of its cached tokens
+        if (state == SLOT_STATE_IDLE || state == SLOT_STATE_STARTED) {
+            return cache_tokens.size();
+        }
+
+        return n_past;
+    }
+
     bool can_speculate() const {
         return ctx_dft && params.speculative.n_max > 0 && params.cache_prompt;
     }
@@ -1378,6 +1452,13 @@ struct server_slot {
             t_last_used = ggml_time_us();
             t_token_generation = (ggml_time_us() - t_start_generation) / 1e3;
             state = SLOT_STATE_IDLE;
+
+            if (preempted) {
+                // only these tokens are in the KV cache
+                cache_tokens.keep_first(n_past);
+                preempted = false;
+            }
+
             callback_on_release(id);
         }
     }
@@ -1400,6 +1481,22 @@ struct server_slot {
             timings.draft_n_accepted = n_draft_accepted;
         }
 
+        // Add latency metrics
+        if (t_queued >= 0) {
+            timings.queue_ms = (t_start_process_prompt - t_queued) / 1e3;
+
+            if (t_start_generation > 0) {
+                timings.ttft_ms = (t_start_generation - t_queued) / 1e3;
+            }
+        }
+
+        if (n_decoded > 1) {
+            timings.tpot_ms = t_token_generation / (n_decoded - 1);
+        }
+
+        timings.preempted_n    = n_preempted;
+        timings.prompt_batches = n_prompt_batches;
+
         return timings;
     }
 
@@ -1463,6 +1560,15 @@ struct server_slot {
                 t_token_generation, n_decoded, t_gen, n_gen_second,
                 t_prompt_processing + t_token_generation, n_prompt_tokens_processed + n_decoded);
 
+        if (t_queued >= 0 && t_start_generation > 0) {
+            SLT_INF(*this,
+                    "\n"
+                    "queue time = %10.2f ms, time to first token = %10.2f ms, time per output token = %8.2f ms\n",
+                    (t_start_process_prompt - t_queued) / 1e3, (t_start_generation - t_queued) / 1e3,
+                    n_decoded > 1 ? t_token_generation / (n_decoded - 1) : 0.0
+            );
+        }
+
         if (n_draft_total > 0) {
             const float draft_ratio = (float) n_draft_accepted / n_draft_total;
             SLT_INF(*this,
@@ -1548,6 +1654,44 @@ struct server_metrics {
     }
 };
 
+// limits the prompt tokens in a batch while slots are generating, so that their time per output token
+// stays close to a target (--target-tpot): a long prompt is split across more batches instead
+struct server_prefill_scheduler {
+    float t_target_ms = 0.0f;
+
+    // moving averages of the decode time of a batch without prompt tokens,
+    // and of the time that each prompt token adds to it
+    float t_base_ms  = 0.0f;
+    float t_token_ms = 0.0f;
+
+    // the prompts always make some progress
+    static constexpr int32_t n_prompt_min = 16;
+
+    // max number of prompt tokens in a batch with n_gen generated tokens
+    int32_t n_prompt_max(int32_t n_gen, int32_t n_batch) const {
+        if (t_target_ms <= 0.0f || n_gen == 0 || t_token_ms <= 0.0f) {
+            return n_batch;
+        }
+
+        const int32_t n_prompt = (t_target_ms - t_base_ms) / t_token_ms;
+
+        return std::min(n_batch, std::max(n_prompt_min, n_prompt));
+    }
+
+    void on_decoded(int32_t n_gen, int32_t n_prompt, float t_ms) {
+        const float alpha = 0.1f;
+
+        if (n_prompt == 0) {
+            t_base_ms = t_base_ms == 0.0f ? t_ms : (1.0f - alpha)*t_base_ms + alpha*t_ms;
+            return;
+        }
+
+        const float t_token = std::max(0.0f, n_gen > 0 ? t_ms - t_base_ms : t_ms) / n_prompt;
+
+        t_token_ms = t_token_ms == 0.0f ? t_token : (1.0f - alpha)*t_token_ms + alpha*t_token;
+    }
+};
+
 struct server_queue {
     int id = 0;
     bool running;
@@ -1559,6 +1703,12 @@ struct server_queue {
     std::mutex mutex_tasks;
     std::condition_variable condition_tasks;
 
+    // admission control (--admit-kv-ratio), 0 = disabled
+    int64_t n_kv_max = 0;
+
+    int64_t n_kv_running = 0;    // estimated KV cells of the tasks in the slots
+    float   t_token_ms   = 0.0f; // moving average of the decode time per batch token, for Retry-After
+
     // callback functions
     std::function<void(server_task &&)> callback_new_task;
     std::function<void(void)>           callback_update_slots;
@@ -1572,6 +1722,9 @@ struct server_queue {
             cleanup_pending_task(task.id_target);
         }
         const int task_id = task.id;
+        if (task.t_queued < 0) {
+            task.t_queued = ggml_time_us();
+        }
         QUE_DBG("new task, id = %d, front = %d\n", task_id, front);
         if (front) {
             queue_tasks.push_front(std::move(task));
@@ -1585,23 +1738,43 @@ struct server_queue {
     // multi-task version of post()
     int post(std::vector<server_task> && tasks, bool front = false) {
         std::unique_lock<std::mutex> lock(mutex_tasks);
-        for (auto & task : tasks) {
-            if (task.id == -1) {
-                task.id = id++;
+        post_locked(std::move(tasks), front);
+        return 0;
+    }
+
+    // post the tasks only if the estimated KV cells of the running and queued tasks stay within n_kv_max with them
+    // otherwise the tasks are dropped, and t_retry_s is an estimate of when enough of the queue is processed
+    bool post_admitted(std::vector<server_task> && tasks, int & t_retry_s) {
+        std::unique_lock<std::mutex> lock(mutex_tasks);
+
+        if (n_kv_max > 0) {
+            int64_t n_kv_used = n_kv_running;
+            for (const auto & task : queue_tasks) {
+                n_kv_used += task.n_kv;
             }
-            // if this is cancel task make sure to clean up pending tasks
-            if (task.type == SERVER_TASK_TYPE_CANCEL) {
-                cleanup_pending_task(task.id_target);
+            for (const auto & task : queue_tasks_deferred) {
+                n_kv_used += task.n_kv;
             }
-            QUE_DBG("new task, id = %d/%d, front = %d\n", task.id, (int) tasks.size(), front);
-            if (front) {
-                queue_tasks.push_front(std::move(task));
-            } else {
-                queue_tasks.push_back(std::move(task));
+
+            int64_t n_kv_new = 0;
+            for (const auto & task : tasks) {
+                n_kv_new += task.n_kv;
+            }
+
+            // a request is always admitted into an empty server, even if it needs more than n_kv_max
+            if (n_kv_used > 0 && n_kv_used + n_kv_new > n_kv_max) {
+                const int64_t n_kv_over = n_kv_used + n_kv_new - n_kv_max;
+
+                t_retry_s = std::clamp((int) std::ceil(n_kv_over*t_token_ms/1e3), 1, 60);
+
+                QUE_DBG("rejected %d tasks, n_kv_used = %" PRId64 ", n_kv_new = %" PRId64 ", n_kv_max = %" PRId64 "\n",
+                        (int) tasks.size(), n_kv_used, n_kv_new, n_kv_max);
+                return false;
             }
         }
-        condition_tasks.notify_one();
-        return 0;
+
+        post_locked(std::move(tasks), false);
+        return true;
     }
 
     // Add a new task, but defer until one slot is available
@@ -1630,15 +1803,49 @@ struct server_queue {
     }
 
     // Call when the state of one slot is changed, it will move one task from deferred to main queue
-    void pop_deferred_task() {
+    // the task with the highest priority goes first, then the one of the tenant with the fewest running tasks,
+    // then the oldest one; the tasks of tenants that already run n_tenant_max tasks stay deferred
+    void pop_deferred_task(const std::map<std::string, int> & n_tenant_running = {}, int n_tenant_max = 0) {
         std::unique_lock<std::mutex> lock(mutex_tasks);
-        if (!queue_tasks_deferred.empty()) {
-            queue_tasks.emplace_back(std::move(queue_tasks_deferred.front()));
-            queue_tasks_deferred.pop_front();
+
+        auto next   = queue_tasks_deferred.end();
+        int  n_next = 0;
+
+        for (auto it = queue_tasks_deferred.begin(); it != queue_tasks_deferred.end(); ++it) {
+            const auto n_it = n_tenant_running.find(it->tenant);
+            const int  n    = n_it == n_tenant_running.end() ? 0 : n_it->second;
+
+            if (n_tenant_max > 0 && !it->tenant.empty() && n >= n_tenant_max) {
+                continue;
+            }
+
+            if (next == queue_tasks_deferred.end() ||
+                it->priority > next->priority ||
+                (it->priority == next->priority && (n < n_next || (n == n_next && it->t_queued < next->t_queued)))) {
+                next   = it;
+                n_next = n;
+            }
+        }
+
+        if (next != queue_tasks_deferred.end()) {
+            queue_tasks.emplace_back(std::move(*next));
+            queue_tasks_deferred.erase(next);
         }
         condition_tasks.notify_one();
     }
 
+    // Call from the main loop to keep the admission control up to date
+    void set_n_kv_running(int64_t n_kv) {
+        std::unique_lock<std::mutex> lock(mutex_tasks);
+        n_kv_running = n_kv;
+    }
+
+    void on_decoded(int32_t n_tokens, float t_ms) {
+        std::unique_lock<std::mutex> lock(mutex_tasks);
+        const float t = t_ms / n_tokens;
+        t_token_ms = t_token_ms == 0.0f ? t : 0.9f*t_token_ms + 0.1f*t;
+    }
+
     // end the start_loop routine
     void terminate() {
         std::unique_lock<std::mutex> lock(mutex_tasks);
@@ -1699,6 +1906,28 @@ struct server_queue {
     }
 
 private:
+    void post_locked(std::vector<server_task> && tasks, bool front) {
+        for (auto & task : tasks) {
+            if (task.id == -1) {
+                task.id = id++;
+            }
+            if (task.t_queued < 0) {
+                task.t_queued = ggml_time_us();
+            }
+            // if this is cancel task make sure to clean up pending tasks
+            if (task.type == SERVER_TASK_TYPE_CANCEL) {
+                cleanup_pending_task(task.id_target);
+            }
+            QUE_DBG("new task, id = %d/%d, front = %d\n", task.id, (int) tasks.size(), front);
+            if (front) {
+                queue_tasks.push_front(std::move(task));
+            } else {
+                queue_tasks.push_back(std::move(task));
+            }
+        }
+        condition_tasks.notify_one();
+    }
+
     void cleanup_pending_task(int id_target) {
         // no need lock because this is called exclusively by post()
         auto rm_func = [id_target](const server_task & task) {
@@ -1855,6 +2084,12 @@ struct server_context {
     llama_model * model = nullptr;
     llama_context * ctx = nullptr;
 
+    // persistent CPU threadpools, so that the workers keep their state (e.g. --poll adaptive) between graphs
+    ggml_threadpool * threadpool       = nullptr;
+    ggml_threadpool * threadpool_batch = nullptr;
+
+    decltype(ggml_threadpool_free) * threadpool_free_fn = nullptr;
+
     // multimodal
     mtmd_context * mctx = nullptr;
 
@@ -1874,6 +2109,12 @@ struct server_context {
 
     // slots / clients
     std::vector<server_slot> slots;
+
+    // prompt prefixes shared between the slots (--prefix-cache)
+    server_prefix_tree prefix_tree;
+
+    // state of the prompts dropped by the slots (--cache-ram, --cache-disk)
+    server_prompt_cache prompt_cache;
     json default_generation_settings_for_props;
 
     server_queue    queue_tasks;
@@ -1881,6 +2122,8 @@ struct server_context {
 
     server_metrics metrics;
 
+    server_prefill_scheduler prefill_scheduler;
+
     // Necessary similarity of prompt for slot selection
     float slot_prompt_similarity = 0.0f;
 
@@ -1905,6 +2148,55 @@ struct server_context {
         }
 
         llama_batch_free(batch);
+
+        if (ctx) {
+            llama_detach_threadpool(ctx);
+        }
+        if (threadpool_free_fn) {
+            threadpool_free_fn(threadpool);
+            threadpool_free_fn(threadpool_batch);
+        }
+    }
+
+    // same as llama-cli: the CPU backend would otherwise use a new threadpool for every graph
+    bool init_threadpool() {
+        auto * cpu_dev = ggml_backend_dev_by_type(GGML_BACKEND_DEVICE_TYPE_CPU);
+        if (!cpu_dev) {
+            SRV_ERR("%s", "no CPU backend found\n");
+            return false;
+        }
+        auto * reg = ggml_backend_dev_backend_reg(cpu_dev);
+        auto * threadpool_new_fn = (decltype(ggml_threadpool_new) *) ggml_backend_reg_get_proc_address(reg, "ggml_threadpool_new");
+        threadpool_free_fn = (decltype(ggml_threadpool_free) *) ggml_backend_reg_get_proc_address(reg, "ggml_threadpool_free");
+
+        if (!threadpool_new_fn || !threadpool_free_fn) {
+            threadpool_free_fn = nullptr;
+            return true;
+        }
+
+        struct ggml_threadpool_params tpp_batch = ggml_threadpool_params_from_cpu_params(params_base.cpuparams_batch);
+        struct ggml_threadpool_params tpp       = ggml_threadpool_params_from_cpu_params(params_base.cpuparams);
+
+        if (!ggml_threadpool_params_match(&tpp, &tpp_batch)) {
+            threadpool_batch = threadpool_new_fn(&tpp_batch);
+            if (!threadpool_batch) {
+                SRV_ERR("batch threadpool create failed : n_threads %d\n", tpp_batch.n_threads);
+                return false;
+            }
+
+            // start the non-batch threadpool in the paused state
+            tpp.paused = true;
+        }
+
+        threadpool = threadpool_new_fn(&tpp);
+        if (!threadpool) {
+            SRV_ERR("threadpool create failed : n_threads %d\n", tpp.n_threads);
+            return false;
+        }
+
+        llama_attach_threadpool(ctx, threadpool, threadpool_batch);
+
+        return true;
     }
 
     bool load_model(const common_params & params) {
@@ -1922,6 +2214,10 @@ struct server_context {
             return false;
         }
 
+        if (!init_threadpool()) {
+            return false;
+        }
+
         vocab = llama_model_get_vocab(model);
 
         n_ctx = llama_n_ctx(ctx);
@@ -2001,6 +2297,22 @@ struct server_context {
                 SRV_WRN("%s\n", "cache_reuse is not supported by multimodal, it will be disabled");
             }
 
+            if (params_base.kv_pool) {
+                params_base.kv_pool = false;
+                SRV_WRN("%s\n", "kv_pool is not supported by multimodal, it will be disabled");
+            }
+
+            if (params_base.prefix_cache) {
+                params_base.prefix_cache = false;
+                SRV_WRN("%s\n", "prefix_cache is not supported by multimodal, it will be disabled");
+            }
+
+            if (params_base.cache_ram_mib > 0 || !params_base.cache_disk_path.empty()) {
+                params_base.cache_ram_mib = 0;
+                params_base.cache_disk_path.clear();
+                SRV_WRN("%s\n", "prompt cache is not supported by multimodal, it will be disabled");
+            }
+
             if (!params_base.speculative.model.path.empty()) {
                 SRV_ERR("%s\n", "err: speculative decode is not supported by multimodal");
                 return false;
@@ -2017,15 +2329,32 @@ struct server_context {
                 params_base.n_cache_reuse = 0;
                 SRV_WRN("%s\n", "cache_reuse is not supported by this context, it will be disabled");
             }
+
+            if (params_base.kv_pool) {
+                params_base.kv_pool = false;
+                SRV_WRN("%s\n", "kv_pool is not supported by this context, it will be disabled");
+            }
+
+            if (params_base.prefix_cache) {
+                params_base.prefix_cache = false;
+                SRV_WRN("%s\n", "prefix_cache is not supported by this context, it will be disabled");
+            }
+
+            if (params_base.cache_ram_mib > 0 || !params_base.cache_disk_path.empty()) {
+                params_base.cache_ram_mib = 0;
+                params_base.cache_disk_path.clear();
+                SRV_WRN("%s\n", "prompt cache is not supported by this context, it will be disabled");
+            }
         }
 
         return true;
     }
 
     void init() {
-        const int32_t n_ctx_slot = n_ctx / params_base.n_parallel;
+        // with a shared KV pool, any slot can use the whole context
+        const int32_t n_ctx_slot = params_base.kv_pool ? n_ctx : n_ctx / params_base.n_parallel;
 
-        SRV_INF("initializing slots, n_slots = %d\n", params_base.n_parallel);
+        SRV_INF("initializing slots, n_slots = %d, kv_pool = %d\n", params_base.n_parallel, params_base.kv_pool);
 
         for (int i = 0; i < params_base.n_parallel; i++) {
             server_slot slot;
@@ -2058,8 +2387,14 @@ struct server_context {
             slot.params.sampling = params_base.sampling;
             slot.params.n_keep = params_base.n_keep;
 
-            slot.callback_on_release = [this](int) {
-                queue_tasks.pop_deferred_task();
+            slot.callback_on_release = [this](int id_slot) {
+                // the KV of the cached tokens stays in the cache, so other slots can share it
+                if (params_base.prefix_cache && !slots[id_slot].is_non_causal()) {
+                    prefix_tree.insert(slots[id_slot].cache_tokens.get_text_tokens(), id_slot);
+                }
+
+                queue_tasks.set_n_kv_running(n_kv_running());
+                queue_tasks.pop_deferred_task(n_tenant_running(), params_base.tenant_slots);
             };
 
             slot.reset();
@@ -2078,6 +2413,26 @@ struct server_context {
 
         metrics.init();
 
+        prefill_scheduler.t_target_ms = params_base.target_tpot_ms;
+
+        queue_tasks.n_kv_max = (int64_t) (params_base.admit_kv_ratio * llama_n_ctx(ctx));
+
+        prompt_cache.ram_size_max  = (size_t) std::max(0, params_base.cache_ram_mib)  * 1024 * 1024;
+        prompt_cache.disk_size_max = (size_t) std::max(0, params_base.cache_disk_mib) * 1024 * 1024;
+
+        if (!params_base.cache_disk_path.empty()) {
+            if (fs_create_directory_with_parents(params_base.cache_disk_path)) {
+                prompt_cache.disk_path = params_base.cache_disk_path;
+            } else {
+                SRV_WRN("failed to create %s, the prompt cache will not use the disk\n", params_base.cache_disk_path.c_str());
+            }
+        }
+
+        if (prompt_cache.enabled()) {
+            SRV_INF("prompt cache: %.0f MiB in RAM, %.0f MiB on disk at '%s'\n",
+                    prompt_cache.ram_size_max / 1024.0 / 1024.0, prompt_cache.disk_path.empty() ? 0.0 : prompt_cache.disk_size_max / 1024.0 / 1024.0, prompt_cache.disk_path.c_str());
+        }
+
         oai_parser_opt = {
             /* use_jinja             */ params_base.use_jinja,
             /* prefill_assistant     */ params_base.prefill_assistant,
@@ -2169,11 +2524,18 @@ struct server_context {
         slot.task_type     = task.type;
         slot.params        = std::move(task.params);
         slot.prompt_tokens = std::move(task.prompt_tokens);
+        slot.t_queued      = task.t_queued;
+        slot.priority      = task.priority;
+        slot.tenant        = task.tenant;
+        slot.n_kv          = task.n_kv;
 
         if (!are_lora_equal(slot.params.lora, slot.lora)) {
             // if lora is changed, we cannot reuse cached tokens
             slot.cache_tokens.clear();
             slot.lora = slot.params.lora;
+
+            // nor share them with other slots
+            prefix_tree.erase(slot.id, 0);
         }
 
         if (!slot.prompt_tokens.validate(ctx)) {
@@ -2223,9 +2585,347 @@ struct server_context {
 
         // clear the entire KV cache
         llama_memory_clear(llama_get_memory(ctx), true);
+        prefix_tree.clear();
         clean_kv_cache = false;
     }
 
+    //
+    // shared KV pool (--kv-pool)
+    //
+    // the KV cache is already one pool of cells that the sequences take from wherever they are free,
+    // so the slots only have to agree on who gets the free cells:
+    //  - the generating slots get a cell for their next token first
+    //  - the preempted slots get back the cells of their tokens next
+    //  - the prompts take what is left, a batch at a time, in the order they started, and leave a cell
+    //    for the next token of each generating slot
+    //  - the cached prompts of idle slots are evicted when cells are needed, least recently used first
+    //  - when that is not enough, the slots that started last are preempted: a prompt drops the cells
+    //    at its end that are needed and goes on from there later, a generating slot drops its KV and
+    //    recomputes it from its tokens once there is room again
+    //
+
+    int32_t kv_pool_n_free() const {
+        // the cells in the prefix tree are counted once, even when several slots share them
+        int32_t n_used = prefix_tree.n_tokens();
+        for (const auto & slot : slots) {
+            n_used += std::max(0, slot.n_kv_cells() - (int32_t) prefix_tree.n_tokens(slot.id));
+        }
+
+        return n_ctx - n_used;
+    }
+
+    // number of cells that the preempted slots still need to restore their KV
+    int32_t kv_pool_n_restore() const {
+        int32_t n_restore = 0;
+        for (const auto & slot : slots) {
+            if (slot.preempted) {
+                n_restore += slot.cache_tokens.size() - slot.n_past + 1;
+            }
+        }
+
+        return n_restore;
+    }
+
+    // true if slot a gets the cells before slot b: higher priority first, then the one that started first
+    static bool kv_pool_goes_before(const server_slot & a, const server_slot & b) {
+        if (a.priority != b.priority) {
+            return a.priority > b.priority;
+        }
+        if (a.t_start_process_prompt != b.t_start_process_prompt) {
+            return a.t_start_process_prompt < b.t_start_process_prompt;
+        }
+
+        return a.id < b.id;
+    }
+
+    // number of cells that the prompt of the slot leaves to the others: those that the preempted slots
+    // need to restore their KV, the next token of each generating slot, and the rest of the prompts before it
+    int32_t kv_pool_n_reserved(const server_slot & slot) const {
+        int32_t n_reserved = kv_pool_n_restore();
+        for (const auto & other : slots) {
+            if (other.state == SLOT_STATE_GENERATING && !other.preempted) {
+                n_reserved++;
+            } else if (other.state == SLOT_STATE_PROCESSING_PROMPT && other.id != slot.id && kv_pool_goes_before(other, slot)) {
+                n_reserved += other.n_prompt_tokens - other.n_past;
+            }
+        }
+
+        return n_reserved;
+    }
+
+    // evict the cached prompts of idle slots until n_cells cells are free or there are none left
+    // returns the number of free cells
+    int32_t kv_pool_evict_idle(int32_t n_cells) {
+        int32_t n_free = kv_pool_n_free();
+
+        while (n_free < n_cells) {
+            if (params_base.prefix_cache) {
+                // drop the least recently used leaf of the prefix tree, the shorter prefixes can still be shared
+                std::set<int> id_slots;
+                size_t n_keep = 0;
+
+                const bool found = prefix_tree.find_lru_leaf([this](int id) { return !slots[id].is_processing(); }, id_slots, n_keep);
+                if (!found) {
+                    break;
+                }
+
+                for (int id : id_slots) {
+                    server_slot & slot = slots[id];
+
+                    SLT_INF(slot, "evicting the cached prompt from the KV pool, n_keep = %zu, n_tokens = %d\n", n_keep, (int) slot.cache_tokens.size());
+
+                    prompt_cache_save(slot);
+
+                    llama_memory_seq_rm(llama_get_memory(ctx), slot.id, n_keep, -1);
+
+                    slot.cache_tokens.keep_first(n_keep);
+                    slot.n_past = std::min(slot.n_past, (int32_t) n_keep);
+
+                    prefix_tree.erase(slot.id, n_keep);
+                }
+
+                n_free = kv_pool_n_free();
+                continue;
+            }
+
+            server_slot * lru = nullptr;
+            for (auto & slot : slots) {
+                if (slot.is_processing() || slot.cache_tokens.size() == 0) {
+                    continue;
+                }
+
+                if (lru == nullptr || slot.t_last_used < lru->t_last_used) {
+                    lru = &slot;
+                }
+            }
+
+            if (lru == nullptr) {
+                break;
+            }
+
+            SLT_INF(*lru, "evicting the cached prompt from the KV pool, n_tokens = %d\n", (int) lru->cache_tokens.size());
+
+            prompt_cache_save(*lru);
+
+            llama_memory_seq_rm(llama_get_memory(ctx), lru->id, -1, -1);
+
+            n_free += lru->cache_tokens.size();
+
+            lru->cache_tokens.clear();
+            lru->n_past = 0;
+        }
+
+        return n_free;
+    }
+
+    // preempt the slot that goes last among those holding KV cells, to free n_cells cells
+    // returns false if there is none
+    bool kv_pool_preempt(int32_t n_cells) {
+        server_slot * last = nullptr;
+        for (auto & slot : slots) {
+            if (!slot.is_processing() || slot.state == SLOT_STATE_STARTED || slot.n_past == 0) {
+                continue;
+            }
+
+            if (last == nullptr || kv_pool_goes_before(*last, slot)) {
+                last = &slot;
+            }
+        }
+
+        if (last == nullptr) {
+            return false;
+        }
+
+        if (last->state == SLOT_STATE_PROCESSING_PROMPT) {
+            // drop only the cells at the end of the prompt, it goes on from there once there is room again
+            const int32_t n_drop = std::min(std::max(n_cells, 1), last->n_past);
+            const int32_t n_keep = last->n_past - n_drop;
+
+            SLT_WRN(*last, "preempted to make room in the KV pool, n_past = %d, n_drop = %d\n", last->n_past, n_drop);
+
+            llama_memory_seq_rm(llama_get_memory(ctx), last->id, n_keep, -1);
+            prefix_tree.erase(last->id, n_keep);
+
+            last->cache_tokens.keep_first(n_keep);
+            last->n_prompt_tokens_processed = std::max(0, last->n_prompt_tokens_processed - n_drop);
+            last->n_past = n_keep;
+            last->n_preempted++;
+
+            return true;
+        }
+
+        SLT_WRN(*last, "preempted to make room in the KV pool, n_past = %d\n", last->n_past);
+
+        llama_memory_seq_rm(llama_get_memory(ctx), last->id, -1, -1);
+        prefix_tree.erase(last->id, 0);
+
+        // keep the cached tokens, their KV is restored before the slot generates again
+        last->preempted = true;
+        last->n_preempted++;
+        last->n_past = 0;
+
+        return true;
+    }
+
+    // make room for the next token of each generating slot
+    void kv_pool_reserve() {
+        while (true) {
+            int32_t n_needed = 0;
+            for (const auto & slot : slots) {
+                if (slot.state == SLOT_STATE_GENERATING && !slot.preempted) {
+                    n_needed++;
+                }
+            }
+
+            const int32_t n_free = kv_pool_evict_idle(n_needed);
+            if (n_free >= n_needed || !kv_pool_preempt(n_needed - n_free)) {
+                break;
+            }
+        }
+    }
+
+    //
+    // scheduling (priority, --tenant-slots, --admit-kv-ratio)
+    //
+
+    // estimated number of KV cells that a completion task needs: its prompt and all the tokens it may generate
+    int32_t n_kv_estimate(const server_task & task) const {
+        const int32_t n_ctx_slot = slots.front().n_ctx;
+
+        int32_t n_predict = task.params.n_predict >= 0 ? task.params.n_predict : n_ctx_slot;
+        if (params_base.n_predict > 0) {
+            // same limit as in launch_slot_with_task()
+            n_predict = std::min(n_predict, params_base.n_predict);
+        }
+
+        return std::min<int64_t>(n_ctx_slot, (int64_t) task.prompt_tokens.size() + n_predict);
+    }
+
+    int64_t n_kv_running() const {
+        int64_t n_kv = 0;
+        for (const auto & slot : slots) {
+            if (slot.is_processing()) {
+                n_kv += slot.n_kv;
+            }
+        }
+
+        return n_kv;
+    }
+
+    // number of slots that each tenant uses, the requests without a tenant count as one
+    std::map<std::string, int> n_tenant_running() const {
+        std::map<std::string, int> n_running;
+        for (const auto & slot : slots) {
+            if (slot.is_processing()) {
+                n_running[slot.tenant]++;
+            }
+        }
+
+        return n_running;
+    }
+
+    //
+    // prompt cache (--cache-ram, --cache-disk)
+    //
+
+    // keep the state of the slot's sequence in the prompt cache before it is dropped
+    void prompt_cache_save(server_slot & slot) {
+        if (!prompt_cache.enabled() || slot.is_non_causal() || slot.cache_tokens.size() < server_prompt_cache::n_tokens_min) {
+            return;
+        }
+
+        const llama_tokens tokens = slot.cache_tokens.get_text_tokens();
+
+        if (prompt_cache.contains(tokens, slot.lora)) {
+            return;
+        }
+
+        const int64_t t_start = ggml_time_us();
+
+        std::vector<uint8_t> data(llama_state_seq_get_size(ctx, slot.id));
+
+        const size_t n_write = llama_state_seq_get_data(ctx, data.data(), data.size(), slot.id);
+        if (n_write == 0) {
+            SLT_WRN(slot, "failed to save %d tokens to the prompt cache\n", (int) slot.cache_tokens.size());
+            return;
+        }
+
+        data.resize(n_write);
+
+        prompt_cache.put(tokens, slot.lora, std::move(data));
+
+        SLT_INF(slot, "saved %d tokens to the prompt cache, %.3f MiB in %.2f ms (cache: %.3f MiB in RAM, %.3f MiB on disk)\n",
+                (int) slot.cache_tokens.size(), n_write / 1024.0 / 1024.0, (ggml_time_us() - t_start) / 1e3,
+                prompt_cache.ram_size / 1024.0 / 1024.0, prompt_cache.disk_size / 1024.0 / 1024.0);
+    }
+
+    // restore the state with the longest prefix of the new prompt from the prompt cache, unless the slot has as much already
+    // returns false while the state is read from the disk
+    bool prompt_cache_load(server_slot & slot) {
+        const llama_tokens tokens = slot.prompt_tokens.get_text_tokens();
+
+        size_t n_common = 0;
+
+        auto it = prompt_cache.find(tokens, slot.lora, n_common);
+        if (it == prompt_cache.entries.end() || n_common < server_prompt_cache::n_tokens_min) {
+            return true;
+        }
+
+        size_t n_cached = slot.cache_tokens.get_common_prefix(slot.prompt_tokens);
+
+        if (params_base.prefix_cache) {
+            const auto accept = [&](int id) {
+                return id != slot.id && are_lora_equal(slots[id].lora, slot.lora);
+            };
+
+            int id_src = -1;
+            n_cached = std::max(n_cached, prefix_tree.find(tokens, accept, id_src));
+        }
+
+        if (n_common <= n_cached) {
+            return true;
+        }
+
+        llama_tokens cached;
+        std::vector<uint8_t> data;
+
+        if (!prompt_cache.take(it, cached, data)) {
+            return false;
+        }
+
+        // the slot's own cache is replaced
+        prompt_cache_save(slot);
+
+        if (params_base.kv_pool) {
+            kv_pool_evict_idle(cached.size());
+        }
+
+        const int64_t t_start = ggml_time_us();
+
+        const size_t n_read = data.empty() ? 0 : llama_state_seq_set_data(ctx, data.data(), data.size(), slot.id);
+
+        prefix_tree.erase(slot.id, 0);
+        slot.cache_tokens.clear();
+
+        if (n_read == 0) {
+            // the KV of the slot may already be invalidated
+            llama_memory_seq_rm(llama_get_memory(ctx), slot.id, -1, -1);
+
+            SLT_WRN(slot, "failed to restore %d tokens from the prompt cache\n", (int) cached.size());
+            return true;
+        }
+
+        slot.cache_tokens.insert(cached);
+
+        if (params_base.prefix_cache) {
+            prefix_tree.insert(cached, slot.id);
+        }
+
+        SLT_INF(slot, "restored %d tokens from the prompt cache in %.2f ms, n_common = %zu\n", (int) cached.size(), (ggml_time_us() - t_start) / 1e3, n_common);
+
+        return true;
+    }
+
     bool process_token(completion_token_output & result, server_slot & slot) {
         // remember which tokens were sampled - used for repetition penalties during sampling
         const std::string token_str = result.text_to_send;
@@ -2720,6 +3420,13 @@ struct server_context {
             case SERVER_TASK_TYPE_EMBEDDING:
             case SERVER_TASK_TYPE_RERANK:
                 {
+                    if (params_base.tenant_slots > 0 && !task.tenant.empty() && n_tenant_running()[task.tenant] >= params_base.tenant_slots) {
+                        // the tenant already uses all the slots it is allowed to
+                        SRV_DBG("tenant limit reached, defer task, id_task = %d\n", task.id);
+                        queue_tasks.defer(std::move(task));
+                        break;
+                    }
+
                     const int id_slot = task.id_selected_slot;
 
                     server_slot * slot = id_slot != -1 ? get_slot_by_id(id_slot) : get_available_slot(task);
@@ -2868,6 +3575,8 @@ struct server_context {
                     tokens.resize(slot->n_ctx);
                     size_t token_count = 0;
                     size_t nread = llama_state_seq_load_file(ctx, filepath.c_str(), slot->id, tokens.data(), tokens.size(), &token_count);
+                    prefix_tree.erase(slot->id, 0);
+
                     if (nread == 0) {
                         slot->cache_tokens.clear(); // KV may already been invalidated?
                         send_error(task, "Unable to restore slot, no available space in KV cache or invalid slot save file", ERROR_TYPE_INVALID_REQUEST);
@@ -2877,6 +3586,10 @@ struct server_context {
                     slot->cache_tokens.clear();
                     slot->cache_tokens.insert(tokens);
 
+                    if (params_base.prefix_cache) {
+                        prefix_tree.insert(tokens, slot->id);
+                    }
+
                     const int64_t t_end = ggml_time_us();
                     const double t_restore_ms = (t_end - t_start) / 1000.0;
 
@@ -2910,6 +3623,7 @@ struct server_context {
                     const size_t n_erased = slot->cache_tokens.size();
                     llama_memory_seq_rm(llama_get_memory(ctx), slot->id, -1, -1);
                     slot->cache_tokens.clear();
+                    prefix_tree.erase(slot->id, 0);
 
                     auto res = std::make_unique<server_task_result_slot_erase>();
                     res->id       = task.id;
@@ -2929,6 +3643,8 @@ struct server_context {
     }
 
     void update_slots() {
+        queue_tasks.set_n_kv_running(n_kv_running());
+
         // check if all slots are idle
         {
             bool all_idle = true;
@@ -2983,8 +3699,18 @@ struct server_context {
 
                 SLT_WRN(slot, "slot context shift, n_keep = %d, n_left = %d, n_discard = %d\n", n_keep, n_left, n_discard);
 
-                llama_memory_seq_rm (llama_get_memory(ctx), slot.id, n_keep            , n_keep + n_discard);
-                llama_memory_seq_add(llama_get_memory(ctx), slot.id, n_keep + n_discard, slot.n_past,        -n_discard);
+                // shifting the cells that other slots share would shift them for these slots too,
+                // so the slot gets its own copy of them instead: their KV is recomputed at the new positions
+                const bool copy_shared = (int) prefix_tree.n_shared(slot.id) > n_keep;
+
+                prefix_tree.erase(slot.id, n_keep);
+
+                if (copy_shared) {
+                    llama_memory_seq_rm(llama_get_memory(ctx), slot.id, n_keep, -1);
+                } else {
+                    llama_memory_seq_rm (llama_get_memory(ctx), slot.id, n_keep            , n_keep + n_discard);
+                    llama_memory_seq_add(llama_get_memory(ctx), slot.id, n_keep + n_discard, slot.n_past,        -n_discard);
+                }
 
                 // add generated tokens to cache
                 {
@@ -3000,6 +3726,13 @@ struct server_context {
 
                 slot.n_past -= n_discard;
 
+                if (copy_shared) {
+                    SLT_INF(slot, "the shifted cells are shared with other slots, recomputing %d tokens\n", slot.n_past - n_keep);
+
+                    slot.n_past    = n_keep;
+                    slot.preempted = true;
+                }
+
                 slot.truncated = true;
             }
         }
@@ -3010,13 +3743,20 @@ struct server_context {
         // track if given slot can be batched with slots already in the batch
         server_slot * slot_batched = nullptr;
 
+        // a slot is waiting for its prompt to be read from the prompt cache on disk
+        bool waiting_prompt_cache = false;
+
         auto accept_special_token = [&](server_slot & slot, llama_token token) {
             return params_base.special || slot.params.sampling.preserved_tokens.find(token) != slot.params.sampling.preserved_tokens.end();
         };
 
+        if (params_base.kv_pool) {
+            kv_pool_reserve();
+        }
+
         // frist, add sampled tokens from any ongoing sequences
         for (auto & slot : slots) {
-            if (slot.state != SLOT_STATE_GENERATING) {
+            if (slot.state != SLOT_STATE_GENERATING || slot.preempted) {
                 continue;
             }
 
@@ -3042,6 +3782,10 @@ struct server_context {
         int32_t n_batch  = llama_n_batch(ctx);
         int32_t n_ubatch = llama_n_ubatch(ctx);
 
+        // the generated tokens are in the batch, the prompts take what the scheduler leaves for them
+        const int32_t n_gen_tokens = batch.n_tokens;
+        const int32_t n_batch_max  = std::min(n_batch, n_gen_tokens + prefill_scheduler.n_prompt_max(n_gen_tokens, n_batch));
+
         // next, batch any pending prompts without exceeding n_batch
         if (params_base.cont_batching || batch.n_tokens == 0) {
             for (auto & slot : slots) {
@@ -3060,6 +3804,12 @@ struct server_context {
 
                     // TODO: maybe move branch to outside of this loop in the future
                     if (slot.state == SLOT_STATE_STARTED) {
+                        // restore the prompt from the prompt cache, the slot waits while it is read from the disk
+                        if (prompt_cache.enabled() && slot.params.cache_prompt && !slot.is_non_causal() && !prompt_cache_load(slot)) {
+                            waiting_prompt_cache = true;
+                            continue;
+                        }
+
                         slot.t_start_process_prompt = ggml_time_us();
                         slot.t_start_generation = 0;
 
@@ -3156,8 +3906,14 @@ struct server_context {
                                 // reuse any previously computed tokens that are common with the new prompt
                                 slot.n_past = slot.cache_tokens.get_common_prefix(prompt_tokens);
 
+                                // keep the cached tokens in the prompt cache, unless the new prompt keeps most of them
+                                if (2*slot.n_past < (int) slot.cache_tokens.size()) {
+                                    prompt_cache_save(slot);
+                                }
+
                                 // reuse chunks from the cached prompt by shifting their KV cache in the new position
-                                if (params_base.n_cache_reuse > 0) {
+                                // (not when other slots share these cells, they would be shifted for them too)
+                                if (params_base.n_cache_reuse > 0 && (int) prefix_tree.n_shared(slot.id) <= slot.n_past) {
                                     size_t head_c = slot.n_past; // cache
                                     size_t head_p = slot.n_past; // current prompt
 
@@ -3204,6 +3960,36 @@ struct server_context {
 
                                     SLT_DBG(slot, "after context reuse, new slot.n_past = %d\n", slot.n_past);
                                 }
+
+                                // share the KV of a longer prefix cached by another slot
+                                if (params_base.prefix_cache && !slot.is_non_causal()) {
+                                    const auto accept = [&](int id) {
+                                        return id != slot.id && are_lora_equal(slots[id].lora, slot.lora);
+                                    };
+
+                                    const llama_tokens tokens = prompt_tokens.get_text_tokens();
+
+                                    int id_src = -1;
+                                    const int n_shared = (int) prefix_tree.find(tokens, accept, id_src);
+
+                                    // the source may not have the KV of the whole prefix because of SWA
+                                    const auto pos_min = id_src >= 0 ? llama_memory_seq_pos_min(llama_get_memory(ctx), id_src) : -1;
+
+                                    if (n_shared > slot.n_past && pos_min <= std::max(0, n_shared - llama_model_n_swa(model))) {
+                                        SLT_INF(slot, "sharing the KV of %d prompt tokens cached by slot %d, n_past = %d\n", n_shared, id_src, slot.n_past);
+
+                                        llama_memory_seq_rm(llama_get_memory(ctx), slot.id, -1, -1);
+                                        llama_memory_seq_cp(llama_get_memory(ctx), id_src, slot.id, 0, n_shared);
+
+                                        slot.cache_tokens.clear();
+                                        slot.cache_tokens.insert(llama_tokens(tokens.begin(), tokens.begin() + n_shared));
+
+                                        prefix_tree.erase (slot.id, 0);
+                                        prefix_tree.insert(slot.cache_tokens.get_text_tokens(), slot.id);
+
+                                        slot.n_past = n_shared;
+                                    }
+                                }
                             } else {
                                 // if we don't cache the prompt, we have to remove the entire KV cache
                                 slot.n_past = 0;
@@ -3253,6 +4039,8 @@ struct server_context {
                         slot.n_past = 0;
                     }
 
+                    prefix_tree.erase(slot.id, slot.n_past);
+
                     SLT_INF(slot, "kv cache rm [%d, end)\n", slot.n_past);
 
                     // remove the non-common part from the cache
@@ -3283,8 +4071,23 @@ struct server_context {
                         slot.n_prompt_tokens_processed += n_pos;
                     }
 
+                    // with a shared KV pool, the prompt only takes the cells that are free and not needed by the other slots
+                    int32_t n_kv_free = n_batch;
+                    if (params_base.kv_pool) {
+                        const int32_t n_reserved = kv_pool_n_reserved(slot);
+
+                        n_kv_free = kv_pool_evict_idle(slot.n_prompt_tokens - slot.n_past + n_reserved) - n_reserved;
+                    }
+
+                    if (n_kv_free <= 0) {
+                        SLT_DBG(slot, "waiting for room in the KV pool, n_past = %d\n", slot.n_past);
+                        continue;
+                    }
+
+                    const int32_t n_past_prev = slot.n_past;
+
                     // add prompt tokens for processing in the current batch
-                    while (slot.n_past < slot.n_prompt_tokens && batch.n_tokens < n_batch) {
+                    while (slot.n_past < slot.n_prompt_tokens && batch.n_tokens < n_batch_max && n_kv_free > 0) {
                         // get next token to process
                         llama_token cur_tok = slot.prompt_tokens[slot.n_past];
                         if (cur_tok == LLAMA_TOKEN_NULL) {
@@ -3299,6 +4102,11 @@ struct server_context {
 
                         slot.n_prompt_tokens_processed++;
                         slot.n_past++;
+                        n_kv_free--;
+                    }
+
+                    if (slot.n_past > n_past_prev) {
+                        slot.n_prompt_batches++;
                     }
 
                     // SLT_INF(slot, "new cache_tokens: %s\n", slot.cache_tokens.str().c_str());
@@ -3332,13 +4140,52 @@ struct server_context {
                     }
                 }
 
-                if (batch.n_tokens >= n_batch) {
+                // a preempted slot gets the KV of its tokens back before it generates again
+                if (slot.state == SLOT_STATE_GENERATING && slot.preempted) {
+                    const int32_t n_restore = slot.cache_tokens.size() - slot.n_past;
+
+                    int32_t n_kv_free = params_base.kv_pool ? kv_pool_evict_idle(n_restore + 1) : n_restore + 1;
+
+                    // start only when all of them fit, so that it is not preempted again half way
+                    if (slot.n_past > 0 || n_kv_free > n_restore) {
+                        while (slot.n_past < (int) slot.cache_tokens.size() && batch.n_tokens < n_batch_max && n_kv_free > 0) {
+                            common_batch_add(batch, slot.cache_tokens[slot.n_past], slot.n_past, { slot.id }, false);
+
+                            slot.n_past++;
+                            n_kv_free--;
+                        }
+
+                        SLT_INF(slot, "restoring the KV of the cached tokens, n_past = %d, n_cache_tokens = %d\n", slot.n_past, (int) slot.cache_tokens.size());
+                    }
+
+                    if (slot.n_past == (int) slot.cache_tokens.size()) {
+                        slot.preempted = false;
+                    }
+                }
+
+                if (batch.n_tokens >= n_batch_max) {
                     break;
                 }
             }
         }
 
         if (batch.n_tokens == 0) {
+            if (waiting_prompt_cache) {
+                // nothing else to decode, do not spin until the file is written or read
+                prompt_cache.wait_files(std::chrono::milliseconds(5));
+                return;
+            }
+
+            // the prompts in progress filled the KV pool, let the preempted slots and the earlier prompts go on
+            if (params_base.kv_pool) {
+                const int32_t n_restore = kv_pool_n_restore();
+                const int32_t n_needed  = n_restore > 0 ? n_restore : n_batch;
+
+                if (kv_pool_preempt(n_needed - kv_pool_n_free())) {
+                    return;
+                }
+            }
+
             SRV_WRN("%s", "no tokens to decode\n");
             return;
         }
@@ -3385,6 +4232,8 @@ struct server_context {
 
         int32_t i_next = 0;
 
+        const int64_t t_decode_start = ggml_time_us();
+
         // process the created batch of tokens
         for (int32_t i = 0; i < batch.n_tokens; i = i_next) {
             const int32_t n_tokens = std::min(n_batch, batch.n_tokens - i);
@@ -3466,6 +4315,11 @@ struct server_context {
 
                     // prompt evaluated for next-token prediction
                     slot.state = SLOT_STATE_GENERATING;
+
+                    // the other slots can share the prompt from now on
+                    if (params_base.prefix_cache) {
+                        prefix_tree.insert(slot.cache_tokens.get_text_tokens(), slot.id);
+                    }
                 } else if (slot.state != SLOT_STATE_GENERATING) {
                     continue; // continue loop of slots
                 }
@@ -3515,7 +4369,7 @@ struct server_context {
                     continue;
                 }
 
-                if (slot.state != SLOT_STATE_GENERATING) {
+                if (slot.state != SLOT_STATE_GENERATING || slot.preempted) {
                     continue;
                 }
 
@@ -3612,6 +4466,11 @@ struct server_context {
             }
         }
 
+        const float t_decode_ms = (ggml_time_us() - t_decode_start) / 1e3;
+
+        prefill_scheduler.on_decoded(n_gen_tokens, batch.n_tokens - n_gen_tokens, t_decode_ms);
+        queue_tasks.on_decoded(batch.n_tokens, t_decode_ms);
+
         SRV_DBG("%s", "run slots completed\n");
     }
 
@@ -3641,6 +4500,18 @@ static void log_server_request(const httplib::Request & req, const httplib::Resp
     SRV_DBG("response: %s\n", res.body.c_str());
 }
 
+// the API key sent in the "Authorization: Bearer" header, empty if there is none
+static std::string get_api_key(const httplib::Request & req) {
+    const std::string auth_header = req.get_header_value("Authorization");
+    const std::string prefix      = "Bearer ";
+
+    if (auth_header.substr(0, prefix.size()) == prefix) {
+        return auth_header.substr(prefix.size());
+    }
+
+    return "";
+}
+
 std::function<void(int)> shutdown_handler;
 std::atomic_flag is_terminating = ATOMIC_FLAG_INIT;
 
@@ -3779,11 +4650,8 @@ int main(int argc, char ** argv) {
         }
 
         // Check for API key in the header
-        auto auth_header = req.get_header_value("Authorization");
-
-        std::string prefix = "Bearer ";
-        if (auth_header.substr(0, prefix.size()) == prefix) {
-            std::string received_api_key = auth_header.substr(prefix.size());
+        const std::string received_api_key = get_api_key(req);
+        if (!received_api_key.empty()) {
             if (std::find(params.api_keys.begin(), params.api_keys.end(), received_api_key) != params.api_keys.end()) {
                 return true; // API key is valid
             }
@@ -4169,6 +5037,7 @@ int main(int argc, char ** argv) {
             server_task_type type,
             json & data,
             const std::vector<raw_buffer> & files,
+            const std::string & api_key,
             const std::function<bool()> & is_connection_closed,
             httplib::Response & res,
             oaicompat_type oaicompat) -> void {
@@ -4257,6 +5126,12 @@ int main(int argc, char ** argv) {
                         data);
                 task.id_selected_slot = json_value(data, "id_slot", -1);
 
+                // clients cannot jump ahead of everyone else, but can always let others go first
+                task.priority = std::min(json_value(data, "priority", 0), ctx_server.params_base.priority_max);
+                // with --api-key the tenant is the key, so that clients cannot pick another tenant
+                task.tenant   = ctx_server.params_base.api_keys.empty() ? json_value(data, "tenant", std::string()) : api_key;
+                task.n_kv     = ctx_server.n_kv_estimate(task);
+
                 // OAI-compat
                 task.params.oaicompat                 = oaicompat;
                 task.params.oaicompat_cmpl_id         = completion_id;
@@ -4267,7 +5142,14 @@ int main(int argc, char ** argv) {
 
             task_ids = server_task::get_list_id(tasks);
             ctx_server.queue_results.add_waiting_tasks(tasks);
-            ctx_server.queue_tasks.post(std::move(tasks));
+
+            int t_retry_s = 0;
+            if (!ctx_server.queue_tasks.post_admitted(std::move(tasks), t_retry_s)) {
+                ctx_server.queue_results.remove_waiting_task_ids(task_ids);
+                res.set_header("Retry-After", std::to_string(t_retry_s));
+                res_error(res, format_error_response("the server is busy, the queued requests already need more KV cache than the limit", ERROR_TYPE_RATE_LIMIT));
+                return;
+            }
         } catch (const std::exception & e) {
             res_error(res, format_error_response(e.what(), ERROR_TYPE_INVALID_REQUEST));
             return;
@@ -4337,6 +5219,7 @@ int main(int argc, char ** argv) {
             SERVER_TASK_TYPE_COMPLETION,
             data,
             files,
+            get_api_key(req),
             req.is_connection_closed,
             res,
             OAICOMPAT_TYPE_NONE);
@@ -4349,6 +5232,7 @@ int main(int argc, char ** argv) {
             SERVER_TASK_TYPE_COMPLETION,
             data,
             files,
+            get_api_key(req),
             req.is_connection_closed,
             res,
             OAICOMPAT_TYPE_COMPLETION);
@@ -4428,6 +5312,7 @@ int main(int argc, char ** argv) {
             SERVER_TASK_TYPE_INFILL,
             data,
             files,
+            get_api_key(req),
             req.is_connection_closed,
             res,
             OAICOMPAT_TYPE_NONE); // infill is not OAI compatible
@@ -4451,6 +5336,7 @@ int main(int argc, char ** argv) {
             SERVER_TASK_TYPE_COMPLETION,
             data,
             files,
+            get_api_key(req),
             req.is_connection_closed,
             res,
             OAICOMPAT_TYPE_CHAT);
@@ -444,6 +444,54 @@ def test_n_probs_post_sampling():
         assert any(prob["prob"] == 1.0 for prob in tok["top_probs"])
 
 
+def test_completion_latency_timings():
+    global server
+    server.start()
+    res = server.make_request("POST", "/completion", data={
+        "n_predict": 8,
+        "prompt": "I believe the meaning of life is",
+    })
+    assert res.status_code == 200
+    timings = res.body["timings"]
+    assert timings["predicted_n"] == 8
+    assert 0 <= timings["queue_ms"] <= timings["ttft_ms"]
+    assert timings["tpot_ms"] > 0
+
+
+def test_completion_target_tpot():
+    global server
+    server.n_slots = 2
+    long_prompt = "Write a joke about AI from a very long prompt which will not be truncated. " * 6
+
+    def run() -> int:
+        # the second prompt is processed while the first request generates
+        tasks = []
+        for prompt in ["I believe the meaning of life is", long_prompt]:
+            tasks.append((server.make_request, ("POST", "/completion", {
+                "prompt": prompt,
+                "n_predict": 64,
+                "ignore_eos": True,
+                "cache_prompt": False,
+                "temperature": 0.0,
+            })))
+        results = parallel_function_calls(tasks)
+        for res in results:
+            assert res.status_code == 200
+            assert res.body["timings"]["predicted_n"] == 64
+        return results[1].body["timings"]["prompt_batches"]
+
+    server.target_tpot = None
+    server.start()
+    n_batches_default = run()
+    server.stop()
+
+    # with a target of 1 ms the long prompt only gets the minimum of 16 tokens per batch instead of up to 32
+    server.target_tpot = 1
+    server.start()
+    n_batches_target = run()
+    assert n_batches_target > n_batches_default
+
+
 def test_cancel_request():
     global server
     server.n_ctx = 4096
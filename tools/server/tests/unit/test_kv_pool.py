@@ -0,0 +1,97 @@
+import pytest
+from utils import *
+
+server = ServerPreset.tinyllama2()
+
+
+LONG_TEXT = """
+Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.
+Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.
+Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur.
+Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum.
+""".strip()
+
+@pytest.fixture(scope="module", autouse=True)
+def create_server():
+    global server
+    server = ServerPreset.tinyllama2()
+    server.n_ctx = 512
+    server.n_slots = 2
+    server.kv_pool = True
+    server.disable_ctx_shift = True
+
+
+def test_kv_pool_long_prompt():
+    # the prompt is 301 tokens, more than the 512/2 = 256 tokens of a slot without the pool
+    global server
+    server.start()
+    res = server.make_request("POST", "/completion", data={
+        "n_predict": 32,
+        "prompt": LONG_TEXT,
+    })
+    assert res.status_code == 200
+    assert res.body["timings"]["prompt_n"] == 301
+    assert res.body["timings"]["predicted_n"] == 32
+    assert res.body["truncated"] is False
+
+
+def test_kv_pool_long_prompt_without_pool():
+    global server
+    server.kv_pool = False
+    server.start()
+    res = server.make_request("POST", "/completion", data={
+        "n_predict": 32,
+        "prompt": LONG_TEXT,
+    })
+    assert res.status_code != 200
+    assert "exceeds the available context size" in res.body["error"]["message"]
+
+
+def test_kv_pool_evict_idle():
+    # the cached prompt of the first request is evicted from the pool to make room for the second one
+    global server
+    server.start()
+    res = server.make_request("POST", "/completion", data={
+        "n_predict": 8,
+        "prompt": LONG_TEXT,
+        "id_slot": 0,
+    })
+    assert res.status_code == 200
+    res = server.make_request("POST", "/completion", data={
+        "n_predict": 8,
+        "prompt": LONG_TEXT[::-1],
+        "id_slot": 1,
+    })
+    assert res.status_code == 200
+    assert res.body["timings"]["predicted_n"] == 8
+
+
+def test_kv_pool_preempt():
+    # together the requests need more than the 256 cells of the pool,
+    # the one that started last is preempted and resumes when the other one is done
+    global server
+    server.n_ctx = 256
+    server.n_predict = -1 # the preset would cap the requests at 64 tokens
+    server.start()
+    prompts = ["Write a very long book.", "Write another a poem."]
+    data = {
+        "n_predict": 160,
+        "temperature": 0.0,
+    }
+    # each request fits alone
+    expected = []
+    for prompt in prompts:
+        res = server.make_request("POST", "/completion", data={**data, "prompt": prompt})
+        assert res.status_code == 200
+        assert "preempted_n" not in res.body["timings"]
+        expected.append(res.body["content"])
+    tasks = []
+    for prompt in prompts:
+        tasks.append((server.make_request, ("POST", "/completion", {**data, "prompt": prompt})))
+    results = parallel_function_calls(tasks)
+    for res, content in zip(results, expected):
+        assert res.status_code == 200
+        assert res.body["timings"]["predicted_n"] == 160
+        # the KV of a preempted slot is recomputed, the output is the same
+        assert res.body["content"] == content
+    assert sum(res.body["timings"].get("preempted_n", 0) for res in results) > 0
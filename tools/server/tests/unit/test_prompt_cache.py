@@ -0,0 +1,82 @@
+import pytest
+from utils import *
+
+server = ServerPreset.tinyllama2()
+
+
+LONG_TEXT = """
+Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.
+Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.
+Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur.
+Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum.
+""".strip()
+
+@pytest.fixture(scope="module", autouse=True)
+def create_server():
+    global server
+    server = ServerPreset.tinyllama2()
+    server.n_ctx = 1024
+    server.n_slots = 1
+    server.temperature = 0.0
+
+
+def run_conversations():
+    # the second conversation replaces the first one in the slot
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT,
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+    assert res.body["timings"]["prompt_n"] == 301
+
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT[::-1],
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+
+    # the first conversation is back from the prompt cache
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT,
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+    assert res.body["timings"]["prompt_n"] == 1
+
+
+def test_prompt_cache_ram():
+    global server
+    server.cache_ram = 64
+    server.start()
+    run_conversations()
+
+
+def test_prompt_cache_disk():
+    global server
+    server.cache_ram = 0
+    server.cache_disk = "./tmp/prompt-cache"
+    server.start()
+    run_conversations()
+
+
+def test_prompt_cache_disabled():
+    global server
+    server.cache_ram = None
+    server.cache_disk = None
+    server.start()
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT,
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT[::-1],
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+    res = server.make_request("POST", "/completion", data={
+        "prompt": LONG_TEXT,
+        "cache_prompt": True,
+    })
+    assert res.status_code == 200
+    assert res.body["timings"]["prompt_n"] == 301
@@ -0,0 +1,119 @@
+import pytest
+import time
+from utils import *
+
+server = ServerPreset.tinyllama2()
+
+
+@pytest.fixture(scope="module", autouse=True)
+def create_server():
+    global server
+    server = ServerPreset.tinyllama2()
+    server.n_ctx = 4096
+    server.n_slots = 1
+    server.n_predict = -1
+
+
+# keeps the slot busy while the other requests are queued
+LONG_REQUEST = {
+    "prompt": "I believe the meaning of life is",
+    "n_predict": 3000,
+    "ignore_eos": True,
+}
+
+
+def run_delayed(requests: list[tuple[str, dict, dict | None]]) -> list[tuple[str, ServerResponse]]:
+    # sends the requests 0.2s apart, and returns them in the order that they complete
+    done = []
+    def send(name: str, data: dict, headers: dict | None):
+        res = server.make_request("POST", "/completion", data=data, headers=headers)
+        done.append((name, res))
+    tasks = []
+    for i, (name, data, headers) in enumerate(requests):
+        def task(i=i, name=name, data=data, headers=headers):
+            time.sleep(0.2*i)
+            send(name, data, headers)
+        tasks.append((task, ()))
+    parallel_function_calls(tasks)
+    return done
+
+
+def test_priority():
+    global server
+    server.priority_max = 1
+    server.start()
+    done = run_delayed([
+        ("long", LONG_REQUEST, None),
+        ("low",  {"prompt": "Hello", "n_predict": 8}, None),
+        ("high", {"prompt": "Hello", "n_predict": 8, "priority": 1}, None),
+    ])
+    assert [name for name, _ in done] == ["long", "high", "low"]
+    for _, res in done:
+        assert res.status_code == 200
+
+
+def test_priority_max():
+    global server
+    server.priority_max = 0
+    server.start()
+    done = run_delayed([
+        ("long",  LONG_REQUEST, None),
+        ("lower", {"prompt": "Hello", "n_predict": 8, "priority": -1}, None),
+        ("first", {"prompt": "Hello", "n_predict": 8}, None),
+        ("high",  {"prompt": "Hello", "n_predict": 8, "priority": 100}, None),
+    ])
+    # by default the priority is capped at 0, lowering it still works
+    assert [name for name, _ in done] == ["long", "first", "high", "lower"]
+
+
+def test_tenant_slots():
+    global server
+    server.n_slots = 2
+    server.n_ctx = 8192
+    server.tenant_slots = 1
+    server.start()
+    done = run_delayed([
+        ("a1", {**LONG_REQUEST, "tenant": "a"}, None),
+        ("a2", {"prompt": "Hello", "n_predict": 8, "tenant": "a"}, None),
+        ("b",  {"prompt": "Hello", "n_predict": 8, "tenant": "b"}, None),
+    ])
+    # the second request of tenant "a" waits for the first one, even though a slot is free
+    assert [name for name, _ in done] == ["b", "a1", "a2"]
+
+
+def test_tenant_slots_api_key():
+    global server
+    server.n_slots = 2
+    server.n_ctx = 8192
+    server.tenant_slots = 1
+    server.api_key = "tenant-key"
+    server.start()
+    headers = {"Authorization": "Bearer tenant-key"}
+    done = run_delayed([
+        ("a", {**LONG_REQUEST, "tenant": "a"}, headers),
+        ("b", {"prompt": "Hello", "n_predict": 8, "tenant": "b"}, headers),
+    ])
+    # with API keys the tenant field is ignored, both requests count against the same key
+    assert [name for name, _ in done] == ["a", "b"]
+    for _, res in done:
+        assert res.status_code == 200
+    server.api_key = None
+
+
+def test_admit_kv_ratio():
+    global server
+    server.n_slots = 1
+    server.n_ctx = 4096
+    server.tenant_slots = None
+    server.admit_kv_ratio = 0.75 # 3072 of the 4096 cells
+    server.start()
+    done = dict(run_delayed([
+        ("long",  LONG_REQUEST, None),                               # about 3000 cells, always admitted first
+        ("big",   {"prompt": "Hello", "n_predict": 200}, None),      # over the limit
+        ("small", {"prompt": "Hello", "n_predict": 8}, None),        # still fits
+    ]))
+    assert done["long"].status_code == 200
+    assert done["big"].status_code == 429
+    assert done["big"].body["error"]["type"] == "rate_limit_error"
+    assert int(done["big"].headers["Retry-After"]) >= 1
+    assert done["small"].status_code == 200
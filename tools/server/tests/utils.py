@@ -80,6 +80,14 @@ class ServerProcess:
     api_key: str | None = None
     lora_files: List[str] | None = None
     disable_ctx_shift: int | None = False
+    kv_pool: bool | None = None
+    prefix_cache: bool | None = None
+    cache_ram: int | None = None
+    cache_disk: str | None = None
+    target_tpot: int | None = None
+    tenant_slots: int | None = None
+    priority_max: int | None = None
+    admit_kv_ratio: float | None = None
     draft_min: int | None = None
     draft_max: int | None = None
     no_webui: bool | None = None
@@ -180,6 +188,22 @@ class ServerProcess:
                 server_args.extend(["--lora", lora_file])
         if self.disable_ctx_shift:
             server_args.extend(["--no-context-shift"])
+        if self.kv_pool:
+            server_args.append("--kv-pool")
+        if self.prefix_cache:
+            server_args.append("--prefix-cache")
+        if self.cache_ram is not None:
+            server_args.extend(["--cache-ram", self.cache_ram])
+        if self.cache_disk:
+            server_args.extend(["--cache-disk", self.cache_disk])
+        if self.target_tpot:
+            server_args.extend(["--target-tpot", self.target_tpot])
+        if self.tenant_slots:
+            server_args.extend(["--tenant-slots", self.tenant_slots])
+        if self.priority_max:
+            server_args.extend(["--priority-max", self.priority_max])
+        if self.admit_kv_ratio:
+            server_args.extend(["--admit-kv-ratio", self.admit_kv_ratio])
         if self.api_key:
             server_args.extend(["--api-key", self.api_key])
         if self.draft_max:
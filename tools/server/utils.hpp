@@ -18,7 +18,16 @@
 #define JSON_ASSERT GGML_ASSERT
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
 #include <random>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -1316,6 +1325,546 @@ public:
     }
 };
 
+//
+// prefix cache
+//
+
+// radix tree of the token prefixes that have their KV in the cache
+// the KV of a prefix is held by the sequences of one or more slots, which share the cells by reference (llama_memory_seq_cp)
+// a slot that holds a prefix also holds all the shorter ones, so the slots of a node are a subset of the slots of its parent
+struct server_prefix_tree {
+    struct node {
+        // tokens of the edge from the parent
+        llama_tokens tokens;
+
+        // slots holding the prefix that ends with this node
+        std::set<int> id_slots;
+
+        int64_t t_last_used = 0;
+
+        std::map<llama_token, std::unique_ptr<node>> children;
+    };
+
+    node root;
+
+    void clear() {
+        root.children.clear();
+    }
+
+    // record that the slot holds the KV of the tokens
+    void insert(const llama_tokens & tokens, int id_slot) {
+        const int64_t t_now = ggml_time_us();
+
+        node * cur = &root;
+
+        size_t i = 0;
+        while (i < tokens.size()) {
+            auto it = cur->children.find(tokens[i]);
+            if (it == cur->children.end()) {
+                auto leaf = std::make_unique<node>();
+                leaf->tokens.assign(tokens.begin() + i, tokens.end());
+                leaf->id_slots.insert(id_slot);
+                leaf->t_last_used = t_now;
+
+                cur->children[tokens[i]] = std::move(leaf);
+                return;
+            }
+
+            node * child = it->second.get();
+
+            const size_t n_match = match(*child, tokens, i);
+            if (n_match < child->tokens.size()) {
+                split(*child, n_match);
+            }
+
+            child->id_slots.insert(id_slot);
+            child->t_last_used = t_now;
+
+            cur = child;
+            i  += n_match;
+        }
+    }
+
+    // the slot only holds the first n_keep tokens of its prefix from now on
+    void erase(int id_slot, size_t n_keep) {
+        erase(root, 0, id_slot, n_keep);
+    }
+
+    // find the longest prefix of the tokens held by a slot for which accept(id_slot) is true
+    // returns the length of the prefix, and one of the slots that hold it in id_slot
+    size_t find(const llama_tokens & tokens, const std::function<bool(int)> & accept, int & id_slot) const {
+        size_t n_best = 0;
+        id_slot = -1;
+
+        const node * cur = &root;
+
+        size_t i = 0;
+        while (i < tokens.size()) {
+            auto it = cur->children.find(tokens[i]);
+            if (it == cur->children.end()) {
+                break;
+            }
+
+            const node * child = it->second.get();
+
+            int id_found = -1;
+            for (int id : child->id_slots) {
+                if (accept(id)) {
+                    id_found = id;
+                    break;
+                }
+            }
+
+            if (id_found < 0) {
+                break;
+            }
+
+            const size_t n_match = match(*child, tokens, i);
+
+            n_best  = i + n_match;
+            id_slot = id_found;
+
+            if (n_match < child->tokens.size()) {
+                break;
+            }
+
+            cur = child;
+            i  += n_match;
+        }
+
+        return n_best;
+    }
+
+    // find the least recently used leaf for which accept(id_slot) is true for all of its slots
+    // returns false if there is none, otherwise the slots of the leaf and the position where it starts
+    bool find_lru_leaf(const std::function<bool(int)> & accept, std::set<int> & id_slots, size_t & n_pos) const {
+        const node * lru = nullptr;
+        find_lru_leaf(root, 0, accept, lru, n_pos);
+
+        if (lru == nullptr) {
+            return false;
+        }
+
+        id_slots = lru->id_slots;
+
+        return true;
+    }
+
+    // number of tokens in the tree, i.e. of distinct KV cells
+    size_t n_tokens() const {
+        return n_tokens(root);
+    }
+
+    // number of tokens held by the slot
+    size_t n_tokens(int id_slot) const {
+        return n_path(id_slot, 1);
+    }
+
+    // number of tokens held by the slot whose cells are shared with other slots
+    size_t n_shared(int id_slot) const {
+        return n_path(id_slot, 2);
+    }
+
+private:
+    static size_t match(const node & nd, const llama_tokens & tokens, size_t i) {
+        size_t n = 0;
+        while (n < nd.tokens.size() && i + n < tokens.size() && nd.tokens[n] == tokens[i + n]) {
+            n++;
+        }
+
+        return n;
+    }
+
+    // keep the first n tokens of the edge in the node, and move the rest to a new child
+    static void split(node & nd, size_t n) {
+        auto tail = std::make_unique<node>();
+        tail->tokens.assign(nd.tokens.begin() + n, nd.tokens.end());
+        tail->id_slots    = nd.id_slots;
+        tail->t_last_used = nd.t_last_used;
+        tail->children    = std::move(nd.children);
+
+        const llama_token key = tail->tokens[0];
+
+        nd.tokens.resize(n);
+        nd.children.clear();
+        nd.children[key] = std::move(tail);
+    }
+
+    // n_pos is the number of tokens before the children of cur
+    static void erase(node & cur, size_t n_pos, int id_slot, size_t n_keep) {
+        for (auto it = cur.children.begin(); it != cur.children.end();) {
+            node & child = *it->second;
+
+            if (child.id_slots.count(id_slot) == 0) {
+                ++it;
+                continue;
+            }
+
+            if (n_pos < n_keep && n_pos + child.tokens.size() > n_keep) {
+                split(child, n_keep - n_pos);
+            }
+
+            if (n_pos >= n_keep) {
+                child.id_slots.erase(id_slot);
+            }
+
+            erase(child, n_pos + child.tokens.size(), id_slot, n_keep);
+
+            if (child.id_slots.empty()) {
+                it = cur.children.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static void find_lru_leaf(const node & cur, size_t n_pos, const std::function<bool(int)> & accept, const node * & lru, size_t & n_pos_lru) {
+        for (const auto & it : cur.children) {
+            const node & child = *it.second;
+
+            if (!child.children.empty()) {
+                find_lru_leaf(child, n_pos + child.tokens.size(), accept, lru, n_pos_lru);
+                continue;
+            }
+
+            if (lru != nullptr && child.t_last_used >= lru->t_last_used) {
+                continue;
+            }
+
+            if (std::all_of(child.id_slots.begin(), child.id_slots.end(), accept)) {
+                lru       = &child;
+                n_pos_lru = n_pos;
+            }
+        }
+    }
+
+    static size_t n_tokens(const node & cur) {
+        size_t n = cur.tokens.size();
+        for (const auto & it : cur.children) {
+            n += n_tokens(*it.second);
+        }
+
+        return n;
+    }
+
+    // length of the path of the slot, up to the first node with less than n_min_slots slots
+    size_t n_path(int id_slot, size_t n_min_slots) const {
+        size_t n = 0;
+
+        const node * cur = &root;
+        while (cur != nullptr) {
+            const node * next = nullptr;
+            for (const auto & it : cur->children) {
+                if (it.second->id_slots.count(id_slot) > 0 && it.second->id_slots.size() >= n_min_slots) {
+                    next = it.second.get();
+                    break;
+                }
+            }
+
+            if (next != nullptr) {
+                n += next->tokens.size();
+            }
+
+            cur = next;
+        }
+
+        return n;
+    }
+};
+
+// state of the sequences that the slots had to drop, kept in RAM and then on disk (--cache-ram, --cache-disk)
+// a slot restores it when a new prompt starts with more of its tokens than the slot has in the KV cache
+struct server_prompt_cache {
+    struct entry {
+        llama_tokens tokens;
+
+        std::vector<common_adapter_lora_info> lora;
+
+        // state of the sequence, in RAM or in a file on disk
+        std::vector<uint8_t> data;
+        std::string path;
+
+        size_t size = 0;
+
+        int64_t t_last_used = 0;
+
+        // the file written in the background, the data leaves RAM once it is done
+        std::future<bool> writing;
+
+        // the file read in the background
+        std::future<std::vector<uint8_t>> reading;
+    };
+
+    // shorter prompts are processed again faster than their state is saved and restored
+    static constexpr size_t n_tokens_min = 64;
+
+    // a finished read that no slot took for this long was abandoned, e.g. by a cancelled task
+    static constexpr int64_t t_abandoned_us = 1000000;
+
+    size_t ram_size_max  = 0;
+    size_t disk_size_max = 0;
+
+    // empty if there is no disk tier
+    std::string disk_path;
+
+    size_t ram_size  = 0;
+    size_t disk_size = 0;
+
+    std::list<entry> entries;
+
+    // the files are named with a random prefix, so that servers sharing the directory do not use each other's files
+    std::string file_prefix = random_file_prefix();
+    uint64_t    n_files     = 0;
+
+    ~server_prompt_cache() {
+        for (auto & e : entries) {
+            if (e.writing.valid()) {
+                e.writing.wait();
+            }
+            if (e.reading.valid()) {
+                e.reading.wait();
+            }
+
+            if (!e.path.empty()) {
+                std::remove(e.path.c_str());
+            }
+        }
+    }
+
+    bool enabled() const {
+        return ram_size_max > 0 || (!disk_path.empty() && disk_size_max > 0);
+    }
+
+    // add the state of a sequence that holds the tokens
+    // true if an entry starts with the tokens, it has all of them already
+    bool contains(const llama_tokens & tokens, const std::vector<common_adapter_lora_info> & lora) {
+        for (auto & e : entries) {
+            if (e.tokens.size() >= tokens.size() && are_lora_equal(e.lora, lora) &&
+                    std::equal(tokens.begin(), tokens.end(), e.tokens.begin())) {
+                e.t_last_used = ggml_time_us();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void put(const llama_tokens & tokens, const std::vector<common_adapter_lora_info> & lora, std::vector<uint8_t> && data) {
+        if (contains(tokens, lora)) {
+            return;
+        }
+
+        collect();
+
+        // the entries with a prefix of the tokens are not needed anymore
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->tokens.size() <= tokens.size() && !it->writing.valid() && !it->reading.valid() && are_lora_equal(it->lora, lora) &&
+                    std::equal(it->tokens.begin(), it->tokens.end(), tokens.begin())) {
+                it = erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        entry e;
+        e.tokens      = tokens;
+        e.lora        = lora;
+        e.size        = data.size();
+        e.data        = std::move(data);
+        e.t_last_used = ggml_time_us();
+
+        ram_size += e.size;
+
+        entries.push_back(std::move(e));
+
+        // least recently used entries go from RAM to disk, then from disk to nowhere
+        while (ram_size > ram_size_max) {
+            auto it = lru([](const entry & e) { return e.path.empty(); });
+            if (it == entries.end()) {
+                break;
+            }
+
+            if (disk_path.empty() || it->size > disk_size_max) {
+                erase(it);
+                continue;
+            }
+
+            const std::string path = disk_path + file_prefix + std::to_string(n_files++) + ".bin";
+
+            ram_size  -= it->size;
+            disk_size += it->size;
+
+            // the update loop does not wait for the disk, collect() checks the result
+            it->path    = path;
+            it->writing = std::async(std::launch::async, [path, data = std::move(it->data)]() {
+                std::ofstream file(path, std::ios::binary);
+                file.write((const char *) data.data(), data.size());
+                file.close();
+
+                return !file.fail();
+            });
+            it->data.clear();
+        }
+
+        while (disk_size > disk_size_max) {
+            auto it = lru([](const entry & e) { return !e.path.empty() && !e.writing.valid() && !e.reading.valid(); });
+            if (it == entries.end()) {
+                break;
+            }
+
+            erase(it);
+        }
+    }
+
+    // find the entry with the longest common prefix with the tokens
+    // returns entries.end() if there is none, otherwise the length of the prefix in n_common
+    std::list<entry>::iterator find(const llama_tokens & tokens, const std::vector<common_adapter_lora_info> & lora, size_t & n_common) {
+        auto best = entries.end();
+        n_common = 0;
+
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (!are_lora_equal(it->lora, lora)) {
+                continue;
+            }
+
+            size_t n = 0;
+            while (n < it->tokens.size() && n < tokens.size() && it->tokens[n] == tokens[n]) {
+                n++;
+            }
+
+            if (n > n_common) {
+                best     = it;
+                n_common = n;
+            }
+        }
+
+        return best;
+    }
+
+    // take the entry out of the cache
+    // returns false while the file of the entry is written or read in the background
+    bool take(std::list<entry>::iterator it, llama_tokens & tokens, std::vector<uint8_t> & data) {
+        it->t_last_used = ggml_time_us();
+
+        if (it->writing.valid()) {
+            if (it->writing.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return false;
+            }
+
+            if (!it->writing.get()) {
+                // the state is lost, the caller gets no data
+                LOG_WRN("%s: failed to write %s\n", __func__, it->path.c_str());
+                tokens = std::move(it->tokens);
+                data.clear();
+                erase(it);
+                return true;
+            }
+        }
+
+        if (!it->path.empty()) {
+            if (!it->reading.valid()) {
+                const std::string path = it->path;
+                it->reading = std::async(std::launch::async, [path]() {
+                    std::vector<uint8_t> res;
+
+                    std::ifstream file(path, std::ios::binary | std::ios::ate);
+                    if (file) {
+                        res.resize(file.tellg());
+                        file.seekg(0);
+                        file.read((char *) res.data(), res.size());
+                        if (!file) {
+                            res.clear();
+                        }
+                    }
+
+                    return res;
+                });
+            }
+
+            if (it->reading.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return false;
+            }
+
+            it->data = it->reading.get();
+        }
+
+        tokens = std::move(it->tokens);
+        data   = std::move(it->data);
+
+        erase(it);
+
+        return true;
+    }
+
+    // wait up to t_max for a file that is written or read in the background
+    void wait_files(std::chrono::milliseconds t_max) {
+        for (auto & e : entries) {
+            if (e.writing.valid()) {
+                e.writing.wait_for(t_max);
+                return;
+            }
+            if (e.reading.valid()) {
+                e.reading.wait_for(t_max);
+                return;
+            }
+        }
+    }
+
+private:
+    static std::string random_file_prefix() {
+        std::random_device rd;
+        const uint64_t id = ((uint64_t) rd() << 32) | rd();
+
+        return string_format("prompt-cache-%016" PRIx64 "-", id);
+    }
+
+    std::list<entry>::iterator lru(const std::function<bool(const entry &)> & pred) {
+        auto res = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (pred(*it) && (res == entries.end() || it->t_last_used < res->t_last_used)) {
+                res = it;
+            }
+        }
+
+        return res;
+    }
+
+    // check the finished writes, and drop the reads that no slot came back for, so that their entries can be evicted
+    void collect() {
+        const int64_t t_now = ggml_time_us();
+
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->writing.valid() && it->writing.wait_for(std::chrono::seconds(0)) == std::future_status::ready && !it->writing.get()) {
+                LOG_WRN("%s: failed to write %s\n", __func__, it->path.c_str());
+                it = erase(it);
+                continue;
+            }
+
+            if (it->reading.valid() && t_now - it->t_last_used > t_abandoned_us &&
+                    it->reading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                it->reading.get();
+            }
+
+            ++it;
+        }
+    }
+
+    std::list<entry>::iterator erase(std::list<entry>::iterator it) {
+        if (it->writing.valid()) {
+            it->writing.wait();
+        }
+
+        if (it->path.empty()) {
+            ram_size -= it->size;
+        } else {
+            disk_size -= it->size;
+            std::remove(it->path.c_str());
+        }
+
+        return entries.erase(it);
+    }
+};
+
 // Computes FNV-1a hash of the data
 static std::string fnv_hash(const uint8_t * data, size_t len) {
     const uint64_t fnv_prime = 0x100000001b3ULL;